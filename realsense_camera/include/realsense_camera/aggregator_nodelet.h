@@ -0,0 +1,98 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#pragma once
+#ifndef REALSENSE_CAMERA_AGGREGATOR_NODELET_H
+#define REALSENSE_CAMERA_AGGREGATOR_NODELET_H
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+#include <diagnostic_updater/diagnostic_updater.h>
+
+#include <realsense_camera/Frameset.h>
+#include <realsense_camera/constants.h>
+#include <realsense_camera/frame_hub.h>
+#include <realsense_camera/multi_camera_sync.h>
+
+namespace realsense_camera
+{
+/*
+ * Combines the frames of several camera nodelets of the same manager into one frameset.
+ *
+ * The frames are taken from the cameras through the frame hub, aligned on their corrected
+ * stamps and emitted at a fixed rate: to in-process listeners of the hub as shared pointers,
+ * and on the frameset topic, which copies the images, only while it has subscribers.
+ */
+class AggregatorNodelet: public nodelet::Nodelet
+{
+public:
+  virtual void onInit();
+  virtual ~AggregatorNodelet();
+
+protected:
+  struct Channel
+  {
+    std::string camera;  // namespace of the camera nodelet
+    int stream;
+  };
+
+  // Member Variables.
+  ros::NodeHandle nh_;
+  ros::NodeHandle pnh_;
+  std::string nodelet_name_;
+  std::string frame_id_;
+  double rate_;
+  double max_skew_ms_;
+  int history_;
+  std::vector<Channel> channels_;
+  std::shared_ptr<FrameHub> frame_hub_;
+  std::vector<int> sinks_;
+  MultiCameraSynchronizer sync_;
+  ros::Publisher frameset_pub_;
+  ros::Timer aggregate_timer_;
+  boost::shared_ptr<diagnostic_updater::Updater> diagnostic_updater_;
+  ros::Timer diagnostic_timer_;
+  std::chrono::steady_clock::time_point stats_start_;
+
+  // Member Functions.
+  virtual bool getParameters();
+  virtual void aggregate(const ros::TimerEvent &event);
+  virtual void publishFrameset(const AlignedFrameset &frameset);
+  virtual void diagnoseAlignment(diagnostic_updater::DiagnosticStatusWrapper &stat);
+  virtual void updateDiagnostics(const ros::TimerEvent &event);
+};
+}  // namespace realsense_camera
+#endif  // REALSENSE_CAMERA_AGGREGATOR_NODELET_H
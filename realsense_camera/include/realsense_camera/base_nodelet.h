@@ -36,6 +36,8 @@
 #include <boost/thread.hpp>
 #include <boost/algorithm/string/join.hpp>
 #include <thread>  // NOLINT(build/c++11)
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
 #include <cstdlib>
 #include <cctype>
 #include <algorithm>
@@ -55,6 +57,8 @@
 #include <ros/ros.h>
 #include <nodelet/nodelet.h>
 #include <sensor_msgs/image_encodings.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <sensor_msgs/CompressedImage.h>
 #include <std_msgs/String.h>
 #include <std_msgs/UInt16.h>
 #include <std_msgs/Float32MultiArray.h>
@@ -64,12 +68,31 @@
 #include <pluginlib/class_list_macros.h>
 #include <tf/transform_broadcaster.h>
 #include <tf2_ros/static_transform_broadcaster.h>
+#include <diagnostic_updater/diagnostic_updater.h>
 
 #include <realsense_camera/CameraConfiguration.h>
 #include <realsense_camera/IsPowered.h>
 #include <realsense_camera/SetPower.h>
 #include <realsense_camera/ForcePower.h>
+#include <realsense_camera/GetCameraOptions.h>
+#include <realsense_camera/DepthStatistics.h>
+#include <realsense_camera/Frameset.h>
 #include <realsense_camera/constants.h>
+#include <realsense_camera/image_pool.h>
+#include <realsense_camera/depth_kernels.h>
+#include <realsense_camera/depth_filters.h>
+#include <realsense_camera/depth_codec.h>
+#include <realsense_camera/color_conversion.h>
+#include <realsense_camera/clock_model.h>
+#include <realsense_camera/frameset_sync.h>
+#include <realsense_camera/ring_buffer.h>
+#include <realsense_camera/worker_pool.h>
+#include <realsense_camera/pointcloud.h>
+#include <realsense_camera/registration.h>
+#include <realsense_camera/transform_table.h>
+#include <realsense_camera/device_watcher.h>
+#include <realsense_camera/device_registry.h>
+#include <realsense_camera/frame_hub.h>
 
 namespace realsense_camera
 {
@@ -82,6 +105,8 @@ public:
   virtual void setDepthEnable(bool &enable_depth);
   virtual bool getCameraOptionValues(realsense_camera::CameraConfiguration::Request & req,
       realsense_camera::CameraConfiguration::Response & res);
+  virtual bool getCameraOptionsService(realsense_camera::GetCameraOptions::Request & req,
+      realsense_camera::GetCameraOptions::Response & res);
   virtual bool setPowerCameraService(realsense_camera::SetPower::Request & req,
       realsense_camera::SetPower::Response & res);
   virtual bool forcePowerCameraService(realsense_camera::ForcePower::Request & req,
@@ -95,12 +120,14 @@ protected:
   ros::NodeHandle pnh_;
   ros::Time camera_start_ts_;
   ros::ServiceServer get_options_service_;
+  ros::ServiceServer get_camera_options_service_;
   ros::ServiceServer set_power_service_;
   ros::ServiceServer force_power_service_;
   ros::ServiceServer is_powered_service_;
   rs_error *rs_error_ = NULL;
-  rs_context *rs_context_ = NULL;
-  rs_device *rs_device_;
+  std::shared_ptr<DeviceRegistry> device_registry_;
+  uint64_t device_generation_ = 0;  // of the device list last seen
+  rs_device *rs_device_ = NULL;
   std::string nodelet_name_;
   std::string serial_no_;
   std::string usb_port_id_;
@@ -119,18 +146,61 @@ protected:
   std::string frame_id_[STREAM_COUNT];
   std::string optical_frame_id_[STREAM_COUNT];
   image_transport::CameraPublisher camera_publisher_[STREAM_COUNT] = {};
-  sensor_msgs::CameraInfoPtr camera_info_ptr_[STREAM_COUNT] = {};
+  sensor_msgs::CameraInfoPtr camera_info_ptr_[STREAM_COUNT] = {};  // calibration, copied for each frame
+  rs_intrinsics intrinsics_[STREAM_COUNT];
   ros::Publisher min_depth_pub_;
+  ros::Publisher depth_stats_pub_;
+  ros::Publisher pointcloud_pub_;
+  ros::Publisher compressed_depth_pub_;
+  ros::Publisher frameset_pub_;
   std::string base_frame_id_;
   bool enable_pointcloud_;
+  bool organized_pointcloud_;
+  bool enable_registration_;
+  int decimation_factor_;
+  DepthDecimationMode decimation_mode_;
+  int worker_threads_;
   bool enable_tf_;
   bool enable_tf_dynamic_;
+  double tf_publish_rate_;
+  bool enable_lazy_streams_;
+  double lazy_stream_debounce_;
   const uint16_t *image_depth16_;
   cv::Mat cvWrapper_;
+  float depth_scale_meters_ = MILLIMETER_METERS;
+  DepthScaleFactor depth_scale_factor_;
+  DepthRayTable depth_ray_table_;
+  std::shared_ptr<WorkerPool> worker_pool_;  // shared by the nodelets of the manager
+  DepthRegistration registration_;
+  std::mutex registration_mutex_;
+  image_transport::CameraPublisher decimated_depth_publisher_;
+  sensor_msgs::CameraInfoPtr decimated_depth_info_ptr_;
+  ImagePool decimated_depth_pool_;
+  std::vector<uint16_t> decimation_scratch_;
+  image_transport::CameraPublisher registered_depth_publisher_;
+  image_transport::CameraPublisher registered_color_publisher_;
+  sensor_msgs::CameraInfoPtr registered_depth_info_ptr_;
+  sensor_msgs::CameraInfoPtr registered_color_info_ptr_;
+  ImagePool registered_depth_pool_;
+  ImagePool registered_color_pool_;
+  int registered_color_bpp_;
+  std::string converted_color_encoding_;
+  YuyvConversion color_conversion_;
+  image_transport::CameraPublisher converted_color_publisher_;
+  image_transport::CameraPublisher mono_color_publisher_;
+  ImagePool converted_color_pool_;
+  ImagePool mono_color_pool_;
+  sensor_msgs::ImageConstPtr latest_color_image_;
+  std::mutex latest_color_mutex_;
   std::mutex frame_mutex_[STREAM_COUNT];
+  ImagePool image_pool_[STREAM_COUNT];
+  int image_pool_max_mb_;
+  boost::shared_ptr<diagnostic_updater::Updater> diagnostic_updater_;
+  ros::Timer diagnostic_timer_;
 
   boost::shared_ptr<boost::thread> transform_thread_;
   ros::Time transform_ts_;
+  TransformTable transform_table_;
   tf2_ros::StaticTransformBroadcaster static_tf_broadcaster_;
   tf::TransformBroadcaster dynamic_tf_broadcaster_;
   rs_extrinsics color2depth_extrinsic_;  // color frame is base frame
@@ -141,34 +211,216 @@ protected:
   {
     rs_option opt;
     double min, max, step, value;
+    std::string name;  // lower case, as in the option parameters
   };
-  std::vector<CameraOptions> camera_options_;
+  std::vector<CameraOptions> camera_options_;  // values are the option cache
+  std::mutex option_cache_mutex_;
+  std::map<rs_option, double> applied_options_;  // last value sent to the camera
+  std::vector<rs_option> pending_options_;
+  std::vector<double> pending_values_;
+  std::mutex options_mutex_;  // camera option reads and writes, and the values above
+  double option_refresh_interval_;
+  ros::Timer option_refresh_timer_;
+
+  // Depth filter settings, set from the dynamic reconfigure callbacks.
+  struct DepthFilterSettings
+  {
+    bool enable_spatial = false;
+    double spatial_alpha;
+    int spatial_delta;
+    int spatial_iterations;
+    bool enable_temporal = false;
+    double temporal_alpha;
+    int temporal_delta;
+    int temporal_persistence;
+    bool enable_hole_filling = false;
+    HoleFillingMode hole_filling_mode = HOLE_FILLING_FARTHEST;
+  };
+  struct FilterTiming
+  {
+    uint64_t frames = 0;
+    double total_ms = 0.0;
+    double max_ms = 0.0;
+  };
+  DepthFilterSettings depth_filter_settings_;
+  bool reset_temporal_filter_ = false;
+  std::mutex depth_filter_mutex_;
+  TemporalDepthFilter temporal_filter_;
+  std::vector<uint16_t> spatial_filter_scratch_;
+  std::vector<uint16_t> hole_filling_scratch_;
+  FilterTiming spatial_filter_timing_;
+  FilterTiming temporal_filter_timing_;
+  FilterTiming hole_filling_timing_;
+  DepthEncoder depth_encoder_;
+  std::vector<sensor_msgs::CompressedImagePtr> compressed_depth_buffers_;
+  std::mutex depth_codec_mutex_;
+  FilterTiming depth_encode_timing_;
+  uint64_t depth_raw_bytes_ = 0;
+  uint64_t depth_encoded_bytes_ = 0;
+  double frameset_tolerance_ms_;
+  FramesetSynchronizer frameset_sync_;
+  std::shared_ptr<FrameHub> frame_hub_;
+  std::string frame_source_;  // namespace the aggregators know this camera by
+  std::atomic<bool> aggregator_demand_[STREAM_COUNT] = {};
+  std::atomic<bool> frameset_listener_demand_ = {false};
+
+  struct QueuedFrame
+  {
+    rs::frame frame;
+    std::chrono::steady_clock::time_point enqueue_time;
+  };
+  struct FrameQueue
+  {
+    RingBuffer<QueuedFrame> ring;
+    std::atomic<uint64_t> enqueued = {0};
+    std::atomic<uint64_t> dropped = {0};
+    std::atomic<uint64_t> published = {0};
+    uint64_t reported_dropped = 0;  // diagnostics thread only
+  };
+  FrameQueue frame_queue_[STREAM_COUNT];
+  std::thread frame_worker_[STREAM_COUNT];
+  std::atomic<bool> frame_workers_running_ = {false};
+  int frame_queue_size_;
+  std::string frame_drop_policy_;
+  double frame_max_age_ms_;
+
+  // Device to host clock mapping of the camera clock, fed from the frame callbacks of its streams.
+  bool enable_clock_sync_;
+  double clock_sync_window_;
+  double clock_sync_outlier_ms_;
+  DeviceClockModel clock_model_;
+  uint64_t reported_clock_resets_ = 0;  // diagnostics thread only
+  std::mutex clock_mutex_;
+
+  // Subscriber demand, updated from the publisher connect/disconnect callbacks.
+  std::atomic<bool> topics_advertised_ = {false};
+  std::atomic<bool> image_demand_[STREAM_COUNT] = {};
+  std::atomic<bool> stream_demand_[STREAM_COUNT] = {};
+  std::atomic<bool> min_depth_demand_ = {false};
+  std::atomic<bool> depth_stats_demand_ = {false};
+  std::atomic<bool> pointcloud_demand_ = {false};
+  std::atomic<bool> decimated_depth_demand_ = {false};
+  std::atomic<bool> compressed_depth_demand_ = {false};
+  std::atomic<bool> converted_color_demand_ = {false};
+  std::atomic<bool> mono_color_demand_ = {false};
+  std::atomic<bool> registered_depth_demand_ = {false};
+  std::atomic<bool> registered_color_demand_ = {false};
+  std::atomic<bool> frameset_topic_demand_ = {false};
+  std::atomic<bool> frameset_demand_ = {false};  // topic or in-process listeners
+  ros::Timer stream_demand_timer_;  // guarded by stream_demand_mutex_
+  std::mutex stream_demand_mutex_;
+  std::mutex stream_mutex_;
+
+  // Runtime stream profile switching; profile_changed_ is guarded by stream_mutex_.
+  bool profile_changed_[STREAM_COUNT] = {};
+  std::chrono::steady_clock::time_point profile_switch_start_;
+  std::atomic<bool> awaiting_first_frame_[STREAM_COUNT] = {};
+  std::atomic<double> first_frame_ms_[STREAM_COUNT] = {};  // after the start or the last profile switch
+  std::atomic<double> restart_ms_ = {0.0};
+  std::atomic<uint64_t> profile_switches_ = {0};
 
   std::queue<pid_t> system_proc_groups_;
 
+  // Startup and reconnect.
+  double reconnect_min_delay_;
+  double reconnect_max_delay_;
+  DeviceWatcher device_watcher_;
+  std::chrono::steady_clock::time_point startup_start_;
+  std::chrono::steady_clock::time_point startup_phase_start_;
+  std::vector<std::pair<std::string, double>> startup_phases_;  // name, ms
+  const char *first_frame_event_ = "profile switch";
+
   // Member Functions.
   virtual void getParameters();
   virtual bool connectToCamera();
-  virtual std::vector<int> listCameras(int num_of_camera);
+  virtual std::vector<int> listCameras(const std::vector<DeviceRegistry::Device> &devices, bool print);
+  virtual bool waitForCamera();
+  virtual void endStartupPhase(const std::string &phase);
+  virtual void reportStartup();
   virtual void advertiseTopics();
+  virtual image_transport::CameraPublisher advertiseCameraTopic(image_transport::ImageTransport &image_transport,
+      const std::string &topic);
+  virtual void setupStreamDemand();
+  virtual void updateStreamDemand();
+  virtual void applyStreamDemand(const ros::TimerEvent &event);
+  virtual bool isStreamWanted(int stream);
+  virtual bool requiresStreaming() { return false; }
   virtual void advertiseServices();
   virtual std::vector<std::string> setDynamicReconfServer() { return {}; }  // must be defined in derived class
   virtual void startDynamicReconfCallback() { return; }  // must be defined in derived class
   virtual void getCameraOptions();
   virtual void setStaticCameraOptions(std::vector<std::string> dynamic_params);
+  virtual void queueCameraOption(rs_option opt, double value);
+  virtual void queueCameraOptions(const rs_option *opts, const double *values, size_t count);
+  virtual void forgetCameraOption(rs_option opt);
+  virtual void addPendingOption(rs_option opt, double value);
+  virtual bool isAutoManaged(rs_option opt);
+  virtual void applyCameraOptions();
+  virtual void setupOptionRefresh();
+  virtual void refreshCameraOptions(const ros::TimerEvent &event);
+  virtual void updateCachedOption(rs_option opt, double value);
   virtual void setStreams();
+  virtual void setStreamProfile(rs_stream stream_index, int &width, int &height, int &fps);
+  virtual bool isStreamModeSupported(rs_stream stream_index, int width, int height, int fps);
+  virtual void restartStreams();
+  virtual void reportFirstFrame(rs_stream stream_index);
   virtual void enableStream(rs_stream stream_index, int width, int height, rs_format format, int fps);
   virtual void getStreamCalibData(rs_stream stream_index);
   virtual void disableStream(rs_stream stream_index);
   virtual std::string startCamera();
   virtual std::string stopCamera();
+  virtual void cacheDepthScale();
   virtual ros::Time getTimestamp(rs_stream stream_index, double frame_ts);
+  virtual DeviceClockModel &getClockModel(rs_stream stream_index);
+  virtual void resetClockModels();
+  virtual ros::Time toHostTime(const DeviceClockModel &model, double device_ms);
+  virtual void startFrameWorkers();
+  virtual void stopFrameWorkers();
+  virtual std::vector<std::unique_lock<std::mutex>> lockFrames();
+  virtual void flushFrameQueues();
+  virtual void queueFrame(rs_stream stream_index, rs::frame &frame);
+  virtual void processFrames(rs_stream stream_index);
   virtual void publishStreamTopic(rs_stream stream_index, rs::frame &  frame);
+  virtual void setDepthFilters(const DepthFilterSettings &settings);
+  virtual bool filterDepth(sensor_msgs::Image &image);
+  virtual void recordFilterTime(FilterTiming &timing, std::chrono::steady_clock::time_point start);
+  virtual void publishDepthStatistics(sensor_msgs::Image &image, bool scale, bool publish_min_depth,
+      bool publish_stats);
+  virtual void publishPointCloud(const sensor_msgs::Image &depth_image);
+  virtual void setupDecimation();
+  virtual void publishDecimatedDepth(const sensor_msgs::Image &depth_image);
+  virtual void publishCompressedDepth(const sensor_msgs::Image &depth_image);
+  virtual void setupColorConversion();
+  virtual void publishConvertedColor(const sensor_msgs::Image &yuyv_image, bool keep_color);
+  virtual bool convertColorImage(const sensor_msgs::Image &yuyv_image, YuyvConversion conversion,
+      sensor_msgs::Image &image);
+  virtual void setupRegistration();
+  virtual void publishRegisteredImages(const sensor_msgs::Image &depth_image);
+  virtual void setupFrameset();
+  virtual void publishFrameset(rs_stream stream_index, const sensor_msgs::ImageConstPtr &image,
+      const sensor_msgs::CameraInfoConstPtr &camera_info);
+  virtual void setupFrameHub();
+  virtual void publishToAggregators(rs_stream stream_index, const sensor_msgs::ImageConstPtr &image,
+      const sensor_msgs::CameraInfoConstPtr &camera_info);
   virtual void getCameraExtrinsics();
+  virtual void buildTransformTable();
+  virtual void addSensorTransforms(const std::string &frame_id, const std::string &optical_frame_id,
+      const rs_extrinsics &extrinsic);
   virtual void publishStaticTransforms();
   virtual void publishDynamicTransforms();
   virtual void prepareTransforms();
   virtual void checkError();
+  virtual void setupDiagnostics();
+  virtual void updateDiagnostics(const ros::TimerEvent &event);
+  virtual void diagnoseImagePools(diagnostic_updater::DiagnosticStatusWrapper &stat);
+  virtual void diagnoseFrameQueues(diagnostic_updater::DiagnosticStatusWrapper &stat);
+  virtual void diagnoseStreamProfiles(diagnostic_updater::DiagnosticStatusWrapper &stat);
+  virtual void diagnoseDepthFilters(diagnostic_updater::DiagnosticStatusWrapper &stat);
+  virtual void diagnoseDepthCompression(diagnostic_updater::DiagnosticStatusWrapper &stat);
+  virtual void diagnoseFrameset(diagnostic_updater::DiagnosticStatusWrapper &stat);
+  virtual void diagnoseClockSync(diagnostic_updater::DiagnosticStatusWrapper &stat);
+  virtual void addClockStatistics(diagnostic_updater::DiagnosticStatusWrapper &stat, const std::string &name,
+      const DeviceClockModel &model, uint64_t &reported_resets);
   virtual bool checkForSubscriber();
   virtual void wrappedSystem(std::vector<std::string> string_argv);
   virtual void setFrameCallbacks();
@@ -0,0 +1,105 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#pragma once
+#ifndef REALSENSE_CAMERA_CLOCK_MODEL_H
+#define REALSENSE_CAMERA_CLOCK_MODEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace realsense_camera
+{
+/*
+ * Mapping from a device clock to the host clock, fitted online from frame arrivals.
+ *
+ * Every arrival pairs a device timestamp with the host time it was received. The host
+ * time is the capture time plus a transport latency that is never negative, so only the
+ * earliest arrival of each interval is kept. The window of these minima is fitted with a
+ * least-squares line, which gives the offset and the skew of the device clock. A minimum
+ * farther from the fit than the outlier limit is rejected; a run of rejections, or a
+ * device timestamp going backwards, restarts the model.
+ */
+class DeviceClockModel
+{
+public:
+  struct Statistics
+  {
+    double offset_sec;   // host minus device time at the newest arrival
+    double skew_ppm;     // rate error of the device clock relative to the host
+    double residual_ms;  // rms distance of the window from the fit
+    double span_sec;     // device time covered by the window
+    size_t samples;
+    uint64_t accepted;
+    uint64_t rejected;
+    uint64_t resets;
+  };
+
+  DeviceClockModel();
+  void configure(double window_sec, double outlier_ms);
+  void reset();
+  void addSample(double device_ms, double host_sec);
+  bool isValid() const;
+  double toHost(double device_ms) const;
+  Statistics getStatistics() const;
+
+private:
+  struct Sample
+  {
+    double x;  // device ms since the origin
+    double y;  // host seconds since the origin, minus x at the nominal rate
+  };
+
+  void restart();
+  void commitInterval();
+  void fit();
+
+  std::vector<Sample> window_;
+  size_t capacity_;
+  size_t head_ = 0;
+  size_t count_ = 0;
+  double outlier_sec_;
+  bool started_ = false;
+  double origin_device_ms_ = 0.0;
+  double origin_host_sec_ = 0.0;
+  double last_x_ = 0.0;
+  Sample interval_min_ = {0.0, 0.0};
+  double interval_start_ = 0.0;
+  double intercept_ = 0.0;
+  double slope_ = 0.0;  // seconds of offset per device ms
+  double residual_sec_ = 0.0;
+  int consecutive_rejects_ = 0;
+  uint64_t accepted_ = 0;
+  uint64_t rejected_ = 0;
+  uint64_t resets_ = 0;
+};
+}  // namespace realsense_camera
+#endif  // REALSENSE_CAMERA_CLOCK_MODEL_H
@@ -0,0 +1,55 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#pragma once
+#ifndef REALSENSE_CAMERA_COLOR_CONVERSION_H
+#define REALSENSE_CAMERA_COLOR_CONVERSION_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace realsense_camera
+{
+enum YuyvConversion
+{
+  YUYV_TO_RGB8,
+  YUYV_TO_BGR8,
+  YUYV_TO_MONO8   // the luma channel as is
+};
+
+/*
+ * Convert rows of a YUYV image, the width being even. Color uses the same BT.601
+ * limited range integer conversion as librealsense, so the result matches its RGB8
+ * and BGR8 formats.
+ */
+void convertYuyv(const uint8_t *yuyv, size_t yuyv_step, uint32_t width, uint32_t rows, YuyvConversion conversion,
+    uint8_t *out, size_t out_step);
+}  // namespace realsense_camera
+#endif  // REALSENSE_CAMERA_COLOR_CONVERSION_H
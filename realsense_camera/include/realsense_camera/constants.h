@@ -57,9 +57,45 @@ namespace realsense_camera
     const bool ENABLE_FISHEYE = true;
     const bool ENABLE_IMU = true;
     const bool ENABLE_PC = false;
+    const bool ORGANIZED_PC = true;
+    const bool ENABLE_REGISTRATION = false;
+    const int DECIMATION_FACTOR = 2;
+    const int WORKER_THREADS = 0;  // one per core
     const bool ENABLE_TF = true;
     const bool ENABLE_TF_DYNAMIC = false;
+    const double TF_PUBLISH_RATE = 1.0;  // Hz, dynamic transforms only
+    const bool ENABLE_LAZY_STREAMS = false;
+    const double LAZY_STREAM_DEBOUNCE = 2.0;  // seconds
+    const int IMAGE_POOL_MAX_MB = 32;  // per stream
+    const size_t COMPRESSED_DEPTH_BUFFERS = 4;
+    const double FRAMESET_TOLERANCE_MS = 0.0;  // half the shortest frame period
+    const size_t FRAMESET_MAX_PENDING = 4;
+    const double DIAGNOSTICS_PERIOD = 1.0;  // seconds
+    const double OPTION_REFRESH_INTERVAL = 1.0;  // seconds, 0 disables
+    const double RECONNECT_MIN_DELAY = 0.5;  // seconds, doubled after each failed attempt
+    const double RECONNECT_MAX_DELAY = 5.0;
+    const double DEVICE_SETTLE_TIME = 0.5;  // seconds without new device nodes before reconnecting
+    const int FRAME_QUEUE_SIZE = 2;  // frames per stream
+    const double FRAME_MAX_AGE_MS = 100.0;
+    const int FRAME_WORKER_TIMEOUT_MS = 100;
+    const bool ENABLE_CLOCK_SYNC = true;
+    const double CLOCK_SYNC_WINDOW = 20.0;  // seconds
+    const double CLOCK_SYNC_OUTLIER_MS = 5.0;
+    const double AGGREGATOR_RATE = 15.0;  // Hz
+    const double AGGREGATOR_MAX_SKEW_MS = 20.0;
+    const int AGGREGATOR_HISTORY = 4;  // frames per camera stream
     const std::string DEFAULT_MODE = "preset";
+    const std::string FRAME_DROP_OLDEST = "drop_oldest";
+    const std::string FRAME_DROP_NEWEST = "drop_newest";
+    const std::string FRAME_DROP_MAX_AGE = "max_age";
+    const std::string DEFAULT_FRAME_DROP_POLICY = FRAME_DROP_OLDEST;
+    const std::string DECIMATION_MEDIAN = "median";
+    const std::string DECIMATION_MIN_VALID = "min_valid";
+    const std::string COLOR_FORMAT_RGB8 = "rgb8";
+    const std::string COLOR_FORMAT_YUYV = "yuyv";
+    const std::string DEFAULT_COLOR_FORMAT = COLOR_FORMAT_RGB8;
+    const std::string YUYV_ENCODING = "yuv422_yuy2";  // Y0 U Y1 V byte order; "yuv422" is U Y0 V Y1
+    const std::string DEFAULT_AGGREGATOR_FRAME_ID = "base_link";
     const std::string DEFAULT_BASE_FRAME_ID = "camera_link";
     const std::string DEFAULT_DEPTH_FRAME_ID = "camera_depth_frame";
     const std::string DEFAULT_COLOR_FRAME_ID = "camera_rgb_frame";
@@ -70,10 +106,20 @@ namespace realsense_camera
     const std::string DEPTH_NAMESPACE = "depth";
     const std::string IMAGE_RAW = "image_raw";
     const std::string IMAGE_RECT = "image_rect";
+    const std::string IMAGE_COLOR = "image_color";  // converted from native YUYV
+    const std::string IMAGE_MONO = "image_mono";    // luma of native YUYV
     const std::string DATA_MIN = "data_min";
+    const std::string DATA_STATS = "data_stats";
+    const std::string POINTS = "points";
+    const std::string FRAMESET = "frameset";
+    const std::string BANDED_RVL_TRANSPORT = "banded_rvl";  // compressed depth, under the depth image topic
     const std::string COLOR_NAMESPACE = "rgb";
     const std::string IR_NAMESPACE = "ir";
+    const std::string DEPTH_DECIMATED_NAMESPACE = "depth_decimated";
+    const std::string DEPTH_REGISTERED_NAMESPACE = "depth_registered";  // depth in the color frame
+    const std::string COLOR_REGISTERED_NAMESPACE = "rgb_registered";    // color in the depth frame
     const std::string SETTINGS_SERVICE = "get_settings";
+    const std::string CAMERA_OPTIONS_SERVICE = "get_camera_options";
     const std::string CAMERA_IS_POWERED_SERVICE = "is_powered";
     const std::string CAMERA_SET_POWER_SERVICE = "set_power";
     const std::string CAMERA_FORCE_POWER_SERVICE = "force_power";
@@ -104,14 +150,29 @@ namespace realsense_camera
     const std::string FISHEYE_NAMESPACE = "fisheye";
     const std::string IMU_NAMESPACE = "imu";
     const std::string DATA_RAW = "data_raw";
+    const std::string DATA_RAW_BATCH = "data_raw_batch";
+    const std::string DATA_FUSED = "data_fused";  // calibrated gyro with the accel interpolated to it
     const std::string IMU_INFO_SERVICE = "get_imu_info";
     const std::string DEFAULT_FISHEYE_FRAME_ID = "camera_fisheye_frame";
     const std::string DEFAULT_IMU_FRAME_ID = "camera_imu_frame";
     const std::string DEFAULT_FISHEYE_OPTICAL_FRAME_ID = "camera_fisheye_optical_frame";
     const std::string DEFAULT_IMU_OPTICAL_FRAME_ID = "camera_imu_optical_frame";
+    const std::string DEFAULT_IMU_WORLD_FRAME_ID = "camera_imu_world";  // gravity aligned, child of the IMU
     const std::string IMU_ACCEL = "IMU_ACCEL";
     const std::string IMU_GYRO = "IMU_GYRO";
     const double IMU_UNITS_TO_MSEC = 0.00003125;
+    const int IMU_QUEUE_SIZE = 1024;  // samples, about 2 s of gyro and accel
+    const double IMU_BATCH_PERIOD = 0.01;  // seconds
+    const std::string IMU_INTERPOLATION_LINEAR = "linear";
+    const std::string IMU_INTERPOLATION_CUBIC = "cubic";
+    const double IMU_FUSION_MAX_GAP_MS = 50.0;
+    const std::string ORIENTATION_FILTER_NONE = "none";
+    const std::string ORIENTATION_FILTER_MADGWICK_NAME = "madgwick";
+    const std::string ORIENTATION_FILTER_MAHONY_NAME = "mahony";
+    const double MADGWICK_GAIN = 0.1;
+    const double MAHONY_GAIN = 1.0;
+    const double MAHONY_INTEGRAL_GAIN = 0.0;
+    const bool ENABLE_IMU_TF = false;
     const std::string ZR300_CAMERA_FW_VERSION = "2.0.71.26";
     const std::string ZR300_ADAPTER_FW_VERSION = "1.28.0.0";
     const std::string ZR300_MOTION_MODULE_FW_VERSION = "1.25.0.0";
@@ -0,0 +1,97 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#pragma once
+#ifndef REALSENSE_CAMERA_DEPTH_CODEC_H
+#define REALSENSE_CAMERA_DEPTH_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace realsense_camera
+{
+/*
+ * Lossless codec for 16-bit depth images, after the RVL scheme: each row is split into runs
+ * of zero and non-zero pixels, and the non-zero pixels are stored as the zigzag-coded delta
+ * to the previous valid pixel. Run lengths and deltas are variable-length coded in nibbles
+ * of three data bits and a continuation bit, eight nibbles per 32-bit word.
+ *
+ * The image is cut into bands of rows that are coded independently, so that bands can be
+ * encoded and decoded in parallel. Encoded layout, all fields little-endian uint32:
+ *   width, height, band rows, encoded size in bytes of each band, band payloads.
+ * The banded layout and the nibble coding differ from the original RVL stream, so the format
+ * has its own name and standard RVL decoders cannot read it.
+ */
+const std::string DEPTH_CODEC_FORMAT = "16UC1; banded_rvl";
+const uint32_t DEPTH_CODEC_BAND_ROWS = 32;
+const uint64_t DEPTH_CODEC_MAX_PIXELS = 4096 * 4096;  // bounds the decoder allocation
+
+/*
+ * Encoder keeping one reusable output buffer per band. Between begin and finish, each band
+ * is encoded by one call of encodeBand, from any thread.
+ */
+class DepthEncoder
+{
+public:
+  /*
+   * Start encoding an image and return its number of bands. The image must stay valid
+   * until finish.
+   */
+  size_t begin(const uint16_t *depth, uint32_t width, uint32_t height, size_t step);
+  void encodeBand(size_t band);
+
+  /*
+   * Write the encoded image to out and return its size in bytes.
+   */
+  size_t finish(std::vector<uint8_t> &out);
+
+private:
+  const uint16_t *depth_ = NULL;
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+  size_t step_ = 0;
+  std::vector<std::vector<uint32_t>> bands_;
+  std::vector<size_t> band_sizes_;
+};
+
+/*
+ * Encode an image on the calling thread.
+ */
+size_t encodeDepth(const uint16_t *depth, uint32_t width, uint32_t height, size_t step, std::vector<uint8_t> &out);
+
+/*
+ * Decode an encoded image into a packed depth buffer. Returns false when the data is
+ * truncated or malformed, or its size exceeds DEPTH_CODEC_MAX_PIXELS.
+ */
+bool decodeDepth(const uint8_t *data, size_t size, uint32_t &width, uint32_t &height, std::vector<uint16_t> &depth);
+}  // namespace realsense_camera
+#endif  // REALSENSE_CAMERA_DEPTH_CODEC_H
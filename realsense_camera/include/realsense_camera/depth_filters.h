@@ -0,0 +1,89 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#pragma once
+#ifndef REALSENSE_CAMERA_DEPTH_FILTERS_H
+#define REALSENSE_CAMERA_DEPTH_FILTERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace realsense_camera
+{
+/*
+ * Source of the value written into a depth hole.
+ */
+enum HoleFillingMode
+{
+  HOLE_FILLING_NEAREST,   // nearest valid 4-neighbour
+  HOLE_FILLING_FARTHEST   // farthest valid 4-neighbour, which favours the background
+};
+
+/*
+ * Edge-preserving smoothing of a depth image in place. Each iteration runs a recursive
+ * exponential filter forwards and backwards along the rows and then along the columns.
+ * A pixel is blended with its already filtered neighbour only when both are valid and
+ * closer than delta, so depth edges and holes are preserved. Alpha is the weight of the
+ * current pixel. The scratch buffer is reused across calls.
+ */
+void spatialFilterDepth(uint16_t *depth, uint32_t width, uint32_t height, size_t step, float alpha, uint16_t delta,
+    int iterations, std::vector<uint16_t> &scratch);
+
+/*
+ * Fill the pixels without depth from their 4-neighbours, in place. A single pass closes
+ * holes up to two pixels wide. The scratch buffer is reused across calls.
+ */
+void fillDepthHoles(uint16_t *depth, uint32_t width, uint32_t height, size_t step, HoleFillingMode mode,
+    std::vector<uint16_t> &scratch);
+
+/*
+ * Exponential moving average of the depth over time, with per-pixel persistence.
+ *
+ * A valid pixel is blended with its running average when they are closer than delta,
+ * otherwise the average restarts from the new value. A pixel without depth keeps its last
+ * average when it was valid in at least persistence of the last 8 frames; a persistence
+ * of zero never fills. The state is reset when the image size changes.
+ */
+class TemporalDepthFilter
+{
+public:
+  void reset();
+  void apply(uint16_t *depth, uint32_t width, uint32_t height, size_t step, float alpha, uint16_t delta,
+      int persistence);
+
+private:
+  std::vector<uint16_t> average_;
+  std::vector<uint8_t> history_;  // validity of the last 8 frames, newest in bit 0
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+};
+}  // namespace realsense_camera
+#endif  // REALSENSE_CAMERA_DEPTH_FILTERS_H
@@ -0,0 +1,106 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#pragma once
+#ifndef REALSENSE_CAMERA_DEPTH_KERNELS_H
+#define REALSENSE_CAMERA_DEPTH_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace realsense_camera
+{
+// Coarse depth histogram: 16 bins of 512 mm, the last bin is open-ended.
+const int DEPTH_HISTOGRAM_BINS = 16;
+const int DEPTH_HISTOGRAM_BIN_SHIFT = 9;
+
+/*
+ * Fixed-point factor used to rescale raw depth units to millimeters:
+ * depth_mm = (raw * multiplier + rounding) >> shift, saturated to 16 bits.
+ */
+struct DepthScaleFactor
+{
+  uint32_t multiplier;
+  uint32_t shift;
+};
+
+/*
+ * Statistics of one depth frame. Zero depth is invalid and is excluded from
+ * min, mean and the histogram.
+ */
+struct DepthFrameStatistics
+{
+  uint16_t min;    // 65535 when no pixel is valid
+  uint16_t max;
+  uint64_t sum;
+  size_t valid;
+  size_t count;
+  uint32_t histogram[DEPTH_HISTOGRAM_BINS];
+};
+
+/*
+ * Reduction applied to each block of a decimated depth image. Zero depth is invalid and
+ * is ignored; a block without valid depth gives zero.
+ */
+enum DepthDecimationMode
+{
+  DEPTH_DECIMATION_MEDIAN,     // lower median of the valid values
+  DEPTH_DECIMATION_MIN_VALID   // nearest valid value
+};
+
+/*
+ * Convert a floating point scale (millimeters per raw unit) to a fixed-point factor.
+ */
+DepthScaleFactor makeDepthScaleFactor(double scale);
+
+/*
+ * Rescale a depth buffer in place.
+ */
+void scaleDepth(uint16_t *depth, size_t count, const DepthScaleFactor &factor);
+
+/*
+ * Compute the frame statistics in a single pass over the buffer. When factor is not NULL
+ * the buffer is rescaled in place in the same pass and the statistics describe the
+ * rescaled values. The histogram is filled only when requested.
+ */
+void computeDepthStatistics(uint16_t *depth, size_t count, const DepthScaleFactor *factor, bool histogram,
+    DepthFrameStatistics &stats);
+
+/*
+ * Reduce each factor x factor block of a depth image to one pixel, factor being 2 or 4. The output
+ * is width / factor by height / factor pixels; trailing rows and columns are dropped. A factor of 4
+ * applies the 2x2 reduction twice, which for the median is the median of the 2x2 medians, through
+ * the intermediate image in scratch; it is only reallocated when the resolution grows.
+ */
+void decimateDepth(const uint16_t *depth, uint32_t width, uint32_t height, size_t step, int factor,
+    DepthDecimationMode mode, uint16_t *out, size_t out_step, std::vector<uint16_t> &scratch);
+}  // namespace realsense_camera
+#endif  // REALSENSE_CAMERA_DEPTH_KERNELS_H
@@ -0,0 +1,110 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#pragma once
+#ifndef REALSENSE_CAMERA_DEVICE_REGISTRY_H
+#define REALSENSE_CAMERA_DEVICE_REGISTRY_H
+
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <vector>
+
+#include <librealsense/rs.h>
+
+#include <realsense_camera/worker_pool.h>
+
+namespace realsense_camera
+{
+/*
+ * Process-wide owner of the librealsense context, shared by the nodelets of one manager.
+ *
+ * The first nodelet to scan creates the context, enumerates the devices and reads their
+ * descriptors; the others reuse them and claim their own device by serial number or USB port.
+ * A rescan, e.g. after a hotplug event, lists the devices of the same context again: librealsense
+ * keeps one context per process, and its devices stay valid while they stream. The context lives
+ * until the registry is dropped by the last nodelet.
+ */
+class DeviceRegistry
+{
+public:
+  struct Device
+  {
+    rs_device *device;
+    std::string serial_no, usb_port_id, name, camera_fw, adapter_fw, motion_module_fw;
+    std::string owner;  // nodelet name, empty while unassigned
+  };
+
+  /*
+   * Return the registry of this process, creating it for the first reference.
+   */
+  static std::shared_ptr<DeviceRegistry> acquire();
+
+  ~DeviceRegistry();
+
+  /*
+   * Enumerate the devices, unless another caller already did after the generation the caller
+   * last saw. generation is updated to the one of the returned list. Returns true when this call
+   * enumerated; the first failed librealsense call is returned in error. Assigned devices stay
+   * in the list with their owner, and are not probed again.
+   */
+  bool scan(WorkerPool &pool, uint64_t &generation, rs_error **error);
+
+  /*
+   * Descriptors of the enumerated devices, in librealsense order.
+   */
+  std::vector<Device> getDevices();
+
+  /*
+   * Assign the first unassigned device whose name contains camera_type and which matches serial_no
+   * and usb_port_id where those are not empty. Returns NULL when none does; when the device
+   * matches but belongs to another nodelet its owner is returned in assigned_to.
+   */
+  rs_device *assign(const std::string &owner, const std::string &camera_type, const std::string &serial_no,
+      const std::string &usb_port_id, std::string &assigned_to);
+
+  /*
+   * Return a device to the registry.
+   */
+  void release(rs_device *device);
+
+private:
+  DeviceRegistry();
+
+  static void probeDevice(rs_device *device, Device &info, rs_error **error);
+
+  std::mutex mutex_;
+  rs_context *context_;  // created by the first scan
+  std::vector<Device> devices_;
+  uint64_t generation_;  // number of enumerations
+};
+}  // namespace realsense_camera
+#endif  // REALSENSE_CAMERA_DEVICE_REGISTRY_H
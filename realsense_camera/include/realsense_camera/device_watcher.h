@@ -0,0 +1,73 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#pragma once
+#ifndef REALSENSE_CAMERA_DEVICE_WATCHER_H
+#define REALSENSE_CAMERA_DEVICE_WATCHER_H
+
+namespace realsense_camera
+{
+/*
+ * Waits for video device nodes to appear under /dev.
+ *
+ * librealsense enumerates cameras only when a context is created, so a nodelet that waits for its
+ * camera has to retry. The watcher lets it sleep until the kernel adds a /dev/video* node instead
+ * of polling on a fixed period. Without inotify, wait() degrades to a plain sleep.
+ */
+class DeviceWatcher
+{
+public:
+  DeviceWatcher();
+  ~DeviceWatcher();
+
+  /*
+   * Start watching /dev. Returns false when inotify is unavailable.
+   */
+  bool open();
+
+  /*
+   * Stop watching.
+   */
+  void close();
+
+  /*
+   * Sleep up to timeout seconds. Returns true early when a video device node appeared, after the
+   * nodes have been quiet for settle seconds so that a camera with several nodes is complete.
+   */
+  bool wait(double timeout, double settle);
+
+private:
+  bool readEvents();
+
+  int fd_;
+  int watch_;
+};
+}  // namespace realsense_camera
+#endif  // REALSENSE_CAMERA_DEVICE_WATCHER_H
@@ -0,0 +1,133 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#pragma once
+#ifndef REALSENSE_CAMERA_FRAME_HUB_H
+#define REALSENSE_CAMERA_FRAME_HUB_H
+
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <vector>
+
+#include <sensor_msgs/CameraInfo.h>
+#include <sensor_msgs/Image.h>
+
+#include <realsense_camera/multi_camera_sync.h>
+
+namespace realsense_camera
+{
+/*
+ * Process-wide exchange of frames between the camera nodelets and the frame aggregators of
+ * one nodelet manager.
+ *
+ * Cameras register as sources under their namespace and hand over every frame an aggregator
+ * asked for, as the same shared pointer they publish; aggregators register sinks for the
+ * source streams they combine and hand their framesets on to in-process listeners. Cameras
+ * hand their own framesets on the same way, under their source name. Nothing is copied.
+ * Callbacks run on the publishing thread while the hub is locked, so they must be short and
+ * must not call back into the hub.
+ */
+class FrameHub
+{
+public:
+  typedef std::function<void(const std::vector<bool> &, bool)> DemandCallback;  // streams, framesets wanted
+  typedef std::function<void(const sensor_msgs::ImageConstPtr &, const sensor_msgs::CameraInfoConstPtr &)>
+      FrameCallback;
+  typedef std::function<void(const AlignedFrameset &)> FramesetCallback;
+
+  /*
+   * Return the hub of this process, creating it for the first reference.
+   */
+  static std::shared_ptr<FrameHub> acquire();
+
+  /*
+   * Register a camera. demand_changed is called with the streams the sinks want and whether
+   * the source has frameset listeners, now and whenever a sink or listener for the source is
+   * added or removed.
+   */
+  void addSource(const std::string &source, int stream_count, const DemandCallback &demand_changed);
+  void removeSource(const std::string &source);
+
+  /*
+   * Hand a frame of a source stream to its sinks.
+   */
+  void publish(const std::string &source, int stream, const sensor_msgs::ImageConstPtr &image,
+      const sensor_msgs::CameraInfoConstPtr &camera_info);
+
+  /*
+   * Receive the frames of a source stream; returns the id to remove the sink with.
+   */
+  int addSink(const std::string &source, int stream, const FrameCallback &callback);
+  void removeSink(int id);
+
+  /*
+   * Receive the framesets of an aggregator or camera; returns the id to remove the listener with.
+   */
+  int addFramesetListener(const std::string &aggregator, const FramesetCallback &callback);
+  void removeFramesetListener(int id);
+
+  /*
+   * Hand a frameset of an aggregator or camera to its listeners.
+   */
+  void publishFrameset(const std::string &aggregator, const AlignedFrameset &frameset);
+
+private:
+  struct Source
+  {
+    std::string name;
+    int stream_count;
+    DemandCallback demand_changed;
+  };
+  struct Sink
+  {
+    int id;
+    std::string source;
+    int stream;
+    FrameCallback callback;
+  };
+  struct Listener
+  {
+    int id;
+    std::string aggregator;
+    FramesetCallback callback;
+  };
+
+  void notifyDemand(const std::string &source);
+
+  std::mutex mutex_;
+  std::vector<Source> sources_;
+  std::vector<Sink> sinks_;
+  std::vector<Listener> listeners_;
+  int next_id_ = 1;
+};
+}  // namespace realsense_camera
+#endif  // REALSENSE_CAMERA_FRAME_HUB_H
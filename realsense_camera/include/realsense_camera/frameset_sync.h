@@ -0,0 +1,99 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#pragma once
+#ifndef REALSENSE_CAMERA_FRAMESET_SYNC_H
+#define REALSENSE_CAMERA_FRAMESET_SYNC_H
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <sensor_msgs/CameraInfo.h>
+#include <sensor_msgs/Image.h>
+
+#include <realsense_camera/multi_camera_sync.h>
+
+namespace realsense_camera
+{
+/*
+ * Matches the frames of several streams into sets captured at the same time.
+ *
+ * Each frame joins the pending set whose first frame is nearest to its stamp and within
+ * the tolerance, or starts a new one. A set is complete once it holds a frame of every
+ * stream. Every stream delivers its frames in order, so the pending sets older than a
+ * completed one can no longer complete and are dropped. The oldest set is also dropped
+ * when more than the configured number are pending, which bounds the frames held.
+ *
+ * Frames are held as the shared pointers the streams published, together with the camera
+ * info of the same frame, so a set references the frames without copying them.
+ */
+class FramesetSynchronizer
+{
+public:
+  struct Statistics
+  {
+    size_t streams;             // matched into each set
+    uint64_t matched;           // completed sets
+    uint64_t unmatched_frames;  // frames dropped without a set
+    double total_wait_ms;       // from the first frame of a set to its completion
+    double max_wait_ms;
+  };
+
+  void configure(const std::vector<int> &streams, double tolerance_sec, size_t max_pending);
+  bool add(int stream, const sensor_msgs::ImageConstPtr &image, const sensor_msgs::CameraInfoConstPtr &camera_info,
+      AlignedFrameset &frameset);
+  Statistics takeStatistics();
+
+private:
+  struct PendingSet
+  {
+    std::vector<sensor_msgs::ImageConstPtr> images;  // in the order of streams_
+    std::vector<sensor_msgs::CameraInfoConstPtr> camera_infos;
+    size_t count;
+    ros::Time stamp;  // of the first frame added
+    std::chrono::steady_clock::time_point first_arrival;
+  };
+
+  void dropPending(size_t count);
+
+  std::mutex mutex_;
+  std::vector<int> streams_;
+  std::vector<int> slot_;  // index into streams_ by stream, -1 when not matched
+  ros::Duration tolerance_;
+  size_t max_pending_ = 0;
+  std::deque<PendingSet> pending_;
+  Statistics stats_ = {0, 0, 0, 0.0, 0.0};
+};
+}  // namespace realsense_camera
+#endif  // REALSENSE_CAMERA_FRAMESET_SYNC_H
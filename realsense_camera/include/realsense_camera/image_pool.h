@@ -0,0 +1,83 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#pragma once
+#ifndef REALSENSE_CAMERA_IMAGE_POOL_H
+#define REALSENSE_CAMERA_IMAGE_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <sensor_msgs/Image.h>
+
+namespace realsense_camera
+{
+/*
+ * Bounded pool of pre-sized image messages for one stream.
+ *
+ * The pool keeps one owning pointer per buffer and hands out copies of it. A buffer is
+ * free again once every subscriber has released its copy, so steady-state streaming
+ * recycles the same buffers without any heap allocation.
+ */
+class ImagePool
+{
+public:
+  struct Statistics
+  {
+    uint64_t hits;       // acquisitions served by a recycled buffer
+    uint64_t misses;     // acquisitions that had to allocate
+    size_t outstanding;  // pooled buffers currently held by subscribers
+    size_t pooled;       // buffers owned by the pool
+    size_t pooled_bytes;
+  };
+
+  void configure(uint32_t width, uint32_t height, uint32_t step, const std::string &encoding, size_t memory_cap);
+  sensor_msgs::ImagePtr acquire();
+  Statistics getStatistics();
+
+private:
+  sensor_msgs::ImagePtr allocate();
+
+  std::mutex mutex_;
+  std::vector<sensor_msgs::ImagePtr> buffers_;
+  size_t next_ = 0;
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+  uint32_t step_ = 0;
+  std::string encoding_;
+  size_t max_buffers_ = 0;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+};
+}  // namespace realsense_camera
+#endif  // REALSENSE_CAMERA_IMAGE_POOL_H
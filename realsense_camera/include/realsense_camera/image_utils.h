@@ -0,0 +1,61 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#pragma once
+#ifndef REALSENSE_CAMERA_IMAGE_UTILS_H
+#define REALSENSE_CAMERA_IMAGE_UTILS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <sensor_msgs/CameraInfo.h>
+#include <sensor_msgs/Image.h>
+
+namespace realsense_camera
+{
+/*
+ * Set the image message geometry and size its data buffer for the given frame layout.
+ */
+void prepareImageMessage(sensor_msgs::Image &image, int width, int height, int step, const std::string &encoding);
+
+/*
+ * Copy a librealsense frame buffer into a prepared image message.
+ * Returns the number of bytes copied, which is exactly one frame.
+ */
+size_t copyFrameToImage(const void *frame_data, int frame_step, sensor_msgs::Image &image);
+
+/*
+ * Copy a camera info for one frame. Published messages are shared with the subscribers,
+ * so the calibration is never restamped in place once it has been handed out.
+ */
+sensor_msgs::CameraInfoPtr stampCameraInfo(const sensor_msgs::CameraInfo &info, const ros::Time &stamp);
+}  // namespace realsense_camera
+#endif  // REALSENSE_CAMERA_IMAGE_UTILS_H
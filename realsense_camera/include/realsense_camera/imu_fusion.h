@@ -0,0 +1,102 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#pragma once
+#ifndef REALSENSE_CAMERA_IMU_FUSION_H
+#define REALSENSE_CAMERA_IMU_FUSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace realsense_camera
+{
+/*
+ * One gyro or accel reading at a device timestamp in ms.
+ */
+struct MotionSample
+{
+  double timestamp;
+  float axes[3];
+};
+
+/*
+ * Gyro reading paired with the accel interpolated to its timestamp.
+ */
+struct FusedMotionSample
+{
+  double timestamp;
+  float angular_velocity[3];
+  float linear_acceleration[3];
+};
+
+enum MotionInterpolation
+{
+  MOTION_INTERPOLATION_LINEAR,
+  MOTION_INTERPOLATION_CUBIC  // cubic Hermite with finite-difference tangents, one accel sample later
+};
+
+/*
+ * Apply a motion module calibration in place: the first three columns of the matrix scale
+ * and align the axes, and the last column is the bias subtracted afterwards.
+ */
+void calibrateMotionSamples(const float matrix[3][4], MotionSample *samples, size_t count);
+
+/*
+ * Pairs every gyro sample with the accel interpolated to its timestamp.
+ *
+ * Accel samples are kept in a short history. A gyro sample waits until the accel samples
+ * around it have arrived, and is dropped when it falls before the history, when the accel
+ * samples around it are further apart than the maximum gap, or when too many wait.
+ */
+class MotionFusion
+{
+public:
+  void configure(MotionInterpolation interpolation, double max_gap_ms);
+  void reset();
+  void addAccel(const MotionSample *samples, size_t count, std::vector<FusedMotionSample> &fused);
+  void addGyro(const MotionSample *samples, size_t count, std::vector<FusedMotionSample> &fused);
+  uint64_t getDropped() const;
+
+private:
+  enum Result {FUSED, WAIT, DROP};
+
+  void process(std::vector<FusedMotionSample> &fused);
+  Result interpolate(const MotionSample &gyro, FusedMotionSample &out) const;
+
+  MotionInterpolation interpolation_ = MOTION_INTERPOLATION_LINEAR;
+  double max_gap_ms_ = 50.0;
+  std::deque<MotionSample> accel_;
+  std::deque<MotionSample> pending_gyro_;
+  uint64_t dropped_ = 0;
+};
+}  // namespace realsense_camera
+#endif  // REALSENSE_CAMERA_IMU_FUSION_H
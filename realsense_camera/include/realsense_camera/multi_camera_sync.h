@@ -0,0 +1,100 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#pragma once
+#ifndef REALSENSE_CAMERA_MULTI_CAMERA_SYNC_H
+#define REALSENSE_CAMERA_MULTI_CAMERA_SYNC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <sensor_msgs/CameraInfo.h>
+#include <sensor_msgs/Image.h>
+
+namespace realsense_camera
+{
+/*
+ * Frames of several cameras picked for one point in time. The images are shared with the
+ * camera nodelets and must not be modified.
+ */
+struct AlignedFrameset
+{
+  ros::Time stamp;  // newest time every channel has reached
+  std::vector<sensor_msgs::ImageConstPtr> images;  // in the order of the channels
+  std::vector<sensor_msgs::CameraInfoConstPtr> camera_infos;
+  double skew_ms;  // newest minus oldest image stamp
+};
+
+/*
+ * Aligns the frames of several cameras on their image stamps.
+ *
+ * The stamps are already on the host clock, corrected per device by the clock models of the
+ * camera nodelets, so frames of different cameras compare directly. Each channel keeps its
+ * newest frames; collect() picks, for the newest time all channels have reached, the frame of
+ * every channel nearest to it, and rejects the set when the frames are further apart than the
+ * allowed skew. It is meant to be polled at the output rate, independent of the camera rates.
+ */
+class MultiCameraSynchronizer
+{
+public:
+  struct Statistics
+  {
+    uint64_t collected;   // framesets returned
+    uint64_t incomplete;  // polls with a channel without frames
+    uint64_t skewed;      // polls rejected for the skew
+    uint64_t stale;       // polls without a newer set than the last one
+    double total_skew_ms;  // of the collected sets
+    double max_skew_ms;
+  };
+
+  void configure(size_t channels, size_t history, double max_skew_sec);
+  void add(size_t channel, const sensor_msgs::ImageConstPtr &image, const sensor_msgs::CameraInfoConstPtr &camera_info);
+  bool collect(AlignedFrameset &frameset);
+  Statistics takeStatistics();
+
+private:
+  struct Frame
+  {
+    sensor_msgs::ImageConstPtr image;
+    sensor_msgs::CameraInfoConstPtr camera_info;
+  };
+
+  std::mutex mutex_;
+  std::vector<std::deque<Frame>> channels_;  // oldest first
+  size_t history_ = 1;
+  ros::Duration max_skew_;
+  ros::Time last_stamp_;  // of the last collected set
+  Statistics stats_ = {0, 0, 0, 0, 0.0, 0.0};
+};
+}  // namespace realsense_camera
+#endif  // REALSENSE_CAMERA_MULTI_CAMERA_SYNC_H
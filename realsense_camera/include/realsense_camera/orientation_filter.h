@@ -0,0 +1,71 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#pragma once
+#ifndef REALSENSE_CAMERA_ORIENTATION_FILTER_H
+#define REALSENSE_CAMERA_ORIENTATION_FILTER_H
+
+namespace realsense_camera
+{
+enum OrientationFilterType
+{
+  ORIENTATION_FILTER_MADGWICK,  // gradient descent step towards gravity, weighted by gain
+  ORIENTATION_FILTER_MAHONY     // proportional-integral correction of the gyro towards gravity
+};
+
+/*
+ * Orientation of the IMU relative to a gravity-aligned world frame, from gyro and accel
+ * samples. The state is a quaternion and the Mahony integral term, so an update never
+ * allocates. The first sample, and a gap longer than the reset interval, initialize the
+ * roll and pitch from the accel with zero yaw.
+ */
+class OrientationFilter
+{
+public:
+  void configure(OrientationFilterType type, double gain, double integral_gain);
+  void reset();
+  void update(const float angular_velocity[3], const float linear_acceleration[3], double timestamp_ms);
+  bool isInitialized() const;
+  void getOrientation(double &x, double &y, double &z, double &w) const;
+
+private:
+  void initialize(double ax, double ay, double az);
+  void integrate(double gx, double gy, double gz, double dt);
+
+  OrientationFilterType type_ = ORIENTATION_FILTER_MADGWICK;
+  double gain_ = 0.1;
+  double integral_gain_ = 0.0;
+  double q_[4] = {1.0, 0.0, 0.0, 0.0};  // w, x, y, z
+  double integral_[3] = {0.0, 0.0, 0.0};
+  double last_timestamp_ms_ = 0.0;
+  bool initialized_ = false;
+};
+}  // namespace realsense_camera
+#endif  // REALSENSE_CAMERA_ORIENTATION_FILTER_H
@@ -0,0 +1,78 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#pragma once
+#ifndef REALSENSE_CAMERA_POINTCLOUD_H
+#define REALSENSE_CAMERA_POINTCLOUD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <librealsense/rs.h>
+
+namespace realsense_camera
+{
+// Points are stored as x, y, z float32 plus 4 bytes of padding, the layout used by depth_image_proc.
+const int POINTCLOUD_POINT_STEP = 16;
+
+/*
+ * Per-pixel viewing rays of a depth stream: the point of pixel i at depth z
+ * is (x[i] * z, y[i] * z, z). Lens distortion is folded into the table.
+ */
+struct DepthRayTable
+{
+  uint32_t width;
+  uint32_t height;
+  std::vector<float> x;
+  std::vector<float> y;
+};
+
+/*
+ * Viewing ray (x, y, 1) of a pixel, undoing the inverse Brown-Conrady distortion as
+ * rs_deproject_pixel_to_point does.
+ */
+void deprojectPixelRay(const rs_intrinsics &intrinsics, float u, float v, float &x, float &y);
+
+/*
+ * Build the ray table from the stream intrinsics.
+ */
+void makeDepthRayTable(const rs_intrinsics &intrinsics, DepthRayTable &table);
+
+/*
+ * Deproject the rows [row_begin, row_end) of a depth image to points in meters, depth_unit being the
+ * meters per depth unit. Points are written from the start of the points buffer. Organized output
+ * writes one point per pixel, NaN for invalid depth; otherwise only valid points are written.
+ * Returns the number of points written.
+ */
+size_t deprojectDepth(const uint16_t *depth, size_t depth_step, const DepthRayTable &table, size_t row_begin,
+    size_t row_end, float depth_unit, bool organized, uint8_t *points);
+}  // namespace realsense_camera
+#endif  // REALSENSE_CAMERA_POINTCLOUD_H
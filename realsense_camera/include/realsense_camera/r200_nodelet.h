@@ -57,6 +57,7 @@ protected:
     RS_OPTION_R200_AUTO_EXPOSURE_BOTTOM_EDGE
   };
   boost::shared_ptr<dynamic_reconfigure::Server<realsense_camera::r200_paramsConfig>> dynamic_reconf_server_;
+  int applied_dc_preset_ = -1;  // none applied yet
 
   rs_extrinsics color2ir2_extrinsic_;  // color frame is base frame
 
@@ -66,9 +67,10 @@ protected:
   std::vector<std::string> setDynamicReconfServer();
   void startDynamicReconfCallback();
   void configCallback(realsense_camera::r200_paramsConfig &config, uint32_t level);
+  void applyDepthControlPreset(int preset);
+  void setStreamProfile(rs_stream stream_index, int &width, int &height, int &fps);
   void getCameraExtrinsics();
-  void publishStaticTransforms();
-  void publishDynamicTransforms();
+  void buildTransformTable();
   void setFrameCallbacks();
   std::function<void(rs::frame f)> ir2_frame_handler_;
 };
@@ -0,0 +1,95 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#pragma once
+#ifndef REALSENSE_CAMERA_REGISTRATION_H
+#define REALSENSE_CAMERA_REGISTRATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <librealsense/rs.h>
+#include <realsense_camera/worker_pool.h>
+
+namespace realsense_camera
+{
+/*
+ * Registers depth to the color image and color to the depth image.
+ *
+ * The depth pixel rays, rotated into the color frame, are computed once per
+ * calibration; per frame only the scaling by depth, the translation and the
+ * color projection remain. Work is split across row bands of the depth image.
+ */
+class DepthRegistration
+{
+public:
+  DepthRegistration();
+
+  /*
+   * Set the calibration. The projection tables are rebuilt only if it differs from the current one.
+   */
+  void configure(const rs_intrinsics &depth_intrinsics, const rs_intrinsics &color_intrinsics,
+      const rs_extrinsics &depth_to_color);
+
+  bool isConfigured() const;
+
+  /*
+   * Map a depth image in millimeters to the color camera: out has the color resolution and each
+   * depth pixel fills its footprint, keeping the nearest depth where pixels overlap.
+   */
+  void registerDepthToColor(const uint16_t *depth, size_t depth_step, uint16_t *out, size_t out_step,
+      WorkerPool &pool) const;
+
+  /*
+   * Sample the color image at every valid depth pixel: out has the depth resolution and
+   * pixels without depth or outside the color image are zero.
+   */
+  void registerColorToDepth(const uint16_t *depth, size_t depth_step, const uint8_t *color, size_t color_step,
+      size_t bytes_per_pixel, uint8_t *out, size_t out_step, WorkerPool &pool) const;
+
+private:
+  struct RotatedRays
+  {
+    std::vector<float> x, y, z;
+    void resize(size_t count);
+  };
+
+  void projectToColor(float x, float y, float z, float &u, float &v) const;
+
+  bool configured_;
+  rs_intrinsics depth_intrinsics_;
+  rs_intrinsics color_intrinsics_;
+  rs_extrinsics depth_to_color_;
+  RotatedRays centers_;   // depth_width x depth_height
+  RotatedRays corners_;   // (depth_width + 1) x (depth_height + 1), pixel corners
+};
+}  // namespace realsense_camera
+#endif  // REALSENSE_CAMERA_REGISTRATION_H
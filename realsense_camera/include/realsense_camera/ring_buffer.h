@@ -0,0 +1,218 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#pragma once
+#ifndef REALSENSE_CAMERA_RING_BUFFER_H
+#define REALSENSE_CAMERA_RING_BUFFER_H
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <utility>
+
+namespace realsense_camera
+{
+/*
+ * Bounded lock-free ring buffer.
+ *
+ * Meant for one producer (a librealsense callback) and one consumer (a worker
+ * thread). Each slot carries a sequence number, so the producer may also pop
+ * to discard the oldest element when the ring is full. The consumer can block
+ * in wait() until the producer pushes; the producer only takes a lock when the
+ * consumer is actually sleeping.
+ */
+template<typename T>
+class RingBuffer
+{
+public:
+  explicit RingBuffer(size_t capacity = 1)
+  {
+    reset(capacity);
+  }
+
+  /*
+   * Resize and empty the ring. Not thread safe, call before the producer and consumer start.
+   */
+  void reset(size_t capacity)
+  {
+    capacity_ = (capacity > 0) ? capacity : 1;
+    cells_.reset(new Cell[capacity_]);
+    for (size_t i = 0; i < capacity_; ++i)
+    {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueue_pos_.store(0, std::memory_order_relaxed);
+    dequeue_pos_.store(0, std::memory_order_relaxed);
+    waiting_.store(false);
+  }
+
+  /*
+   * Append an element. Returns false, leaving the element untouched, when the ring is full.
+   */
+  bool push(T &&item)
+  {
+    Cell *cell;
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      cell = &cells_[pos % capacity_];
+      intptr_t diff = static_cast<intptr_t>(cell->sequence.load(std::memory_order_acquire)) -
+          static_cast<intptr_t>(pos);
+      if (diff == 0)
+      {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        {
+          break;
+        }
+      }
+      else if (diff < 0)
+      {
+        return false;
+      }
+      else
+      {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->data = std::move(item);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+
+    // Pairs with the fence in wait(): either the consumer sees the element or we see it waiting.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting_.load(std::memory_order_relaxed))
+    {
+      std::unique_lock<std::mutex> lock(wait_mutex_);
+      wait_cv_.notify_one();
+    }
+    return true;
+  }
+
+  /*
+   * Remove the oldest element. Returns false when the ring is empty.
+   */
+  bool pop(T &item)
+  {
+    Cell *cell;
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+      cell = &cells_[pos % capacity_];
+      intptr_t diff = static_cast<intptr_t>(cell->sequence.load(std::memory_order_acquire)) -
+          static_cast<intptr_t>(pos + 1);
+      if (diff == 0)
+      {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        {
+          break;
+        }
+      }
+      else if (diff < 0)
+      {
+        return false;
+      }
+      else
+      {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    item = std::move(cell->data);
+    cell->sequence.store(pos + capacity_, std::memory_order_release);
+    return true;
+  }
+
+  /*
+   * Number of queued elements, approximate while the producer or consumer is running.
+   */
+  size_t size() const
+  {
+    size_t enqueued = enqueue_pos_.load(std::memory_order_relaxed);
+    size_t dequeued = dequeue_pos_.load(std::memory_order_relaxed);
+    return (enqueued > dequeued) ? enqueued - dequeued : 0;
+  }
+
+  bool empty() const
+  {
+    return size() == 0;
+  }
+
+  size_t capacity() const
+  {
+    return capacity_;
+  }
+
+  /*
+   * Block the consumer until an element is pushed, wake() is called or the timeout expires.
+   * Returns true if the ring may hold elements.
+   */
+  template<typename Rep, typename Period>
+  bool wait(const std::chrono::duration<Rep, Period> &timeout)
+  {
+    std::unique_lock<std::mutex> lock(wait_mutex_);
+    waiting_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (empty())
+    {
+      wait_cv_.wait_for(lock, timeout);
+    }
+    waiting_.store(false, std::memory_order_relaxed);
+    return !empty();
+  }
+
+  /*
+   * Wake a consumer blocked in wait(), e.g. on shutdown.
+   */
+  void wake()
+  {
+    std::unique_lock<std::mutex> lock(wait_mutex_);
+    wait_cv_.notify_all();
+  }
+
+private:
+  struct Cell
+  {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t capacity_;
+  // Keep the producer and consumer positions on separate cache lines
+  alignas(64) std::atomic<size_t> enqueue_pos_;
+  alignas(64) std::atomic<size_t> dequeue_pos_;
+  alignas(64) std::atomic<bool> waiting_;
+  std::mutex wait_mutex_;
+  std::condition_variable wait_cv_;
+};
+}  // namespace realsense_camera
+#endif  // REALSENSE_CAMERA_RING_BUFFER_H
@@ -0,0 +1,91 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#pragma once
+#ifndef REALSENSE_CAMERA_TRANSFORM_TABLE_H
+#define REALSENSE_CAMERA_TRANSFORM_TABLE_H
+
+#include <string>
+#include <vector>
+
+#include <ros/ros.h>
+#include <geometry_msgs/TransformStamped.h>
+#include <librealsense/rs.h>
+
+namespace realsense_camera
+{
+/*
+ * Return the extrinsic mapping points the other way, with rotation R^T and translation -R^T t.
+ */
+rs_extrinsics invertExtrinsic(const rs_extrinsics &extrinsic);
+
+/*
+ * The camera transform tree, built once from the extrinsics and frame ids.
+ *
+ * Every edge is kept as a ready TransformStamped, so publishing the whole tree only
+ * restamps the entries and sends them as a single tfMessage.
+ */
+class TransformTable
+{
+public:
+  void clear();
+
+  /*
+   * Add the pose of a sensor frame in the base frame. The extrinsic maps points from the
+   * sensor into the base sensor, both in optical axes (x right, y down, z forward); the
+   * translation and full rotation are converted to the x forward, z up axes of the
+   * non-optical frames. Returns false, adding an identity rotation, if the extrinsic
+   * rotation is not orthonormal.
+   */
+  bool addExtrinsic(const std::string &parent_frame_id, const std::string &child_frame_id,
+      const rs_extrinsics &extrinsic);
+
+  /*
+   * Add the fixed rotation from a frame to its optical frame.
+   */
+  void addOptical(const std::string &frame_id, const std::string &optical_frame_id);
+
+  void addIdentity(const std::string &parent_frame_id, const std::string &child_frame_id);
+
+  /*
+   * Stamp every entry with the given time and return the table.
+   */
+  const std::vector<geometry_msgs::TransformStamped> &stamp(const ros::Time &stamp);
+
+  size_t size() const;
+
+private:
+  void add(const std::string &parent_frame_id, const std::string &child_frame_id,
+      const double translation[3], const double rotation[3][3]);
+
+  std::vector<geometry_msgs::TransformStamped> transforms_;
+};
+}  // namespace realsense_camera
+#endif  // REALSENSE_CAMERA_TRANSFORM_TABLE_H
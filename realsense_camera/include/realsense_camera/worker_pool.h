@@ -0,0 +1,107 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#pragma once
+#ifndef REALSENSE_CAMERA_WORKER_POOL_H
+#define REALSENSE_CAMERA_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+namespace realsense_camera
+{
+/*
+ * Fixed set of threads shared by the image kernels of all streams.
+ *
+ * parallelFor() splits an index range into chunks and blocks until they are
+ * done. The calling thread executes chunks too, so several streams can run
+ * parallel loops at the same time without deadlocking the pool. For the same
+ * reason the camera nodelets of one manager share a single pool, which keeps
+ * the threads of the process at one per core however many cameras it runs.
+ */
+class WorkerPool
+{
+public:
+  WorkerPool();
+  ~WorkerPool();
+
+  /*
+   * Return the pool of this process, starting it with thread_count threads for the first
+   * reference. Later references share it as it is; it stops with the last reference.
+   */
+  static std::shared_ptr<WorkerPool> acquire(unsigned thread_count);
+
+  /*
+   * Start the pool. With thread_count 0 one thread per CPU core is used, counting the caller.
+   */
+  void start(unsigned thread_count);
+
+  /*
+   * Stop and join the threads. Pending chunks are still executed by their callers.
+   */
+  void stop();
+
+  /*
+   * Number of threads that execute a parallel loop, including the caller.
+   */
+  unsigned getConcurrency() const;
+
+  /*
+   * Call fn(begin, end) over [0, count) in chunks of at least min_chunk indices.
+   */
+  void parallelFor(size_t count, size_t min_chunk, const std::function<void(size_t, size_t)> &fn);
+
+private:
+  struct Job;
+  struct Task
+  {
+    Job *job;
+    size_t begin, end;
+  };
+
+  void run();
+  bool runTask(std::unique_lock<std::mutex> &lock);
+
+  std::vector<std::thread> threads_;
+  std::deque<Task> tasks_;
+  std::mutex mutex_;
+  std::condition_variable task_cv_;
+  std::condition_variable done_cv_;
+  bool running_;
+};
+}  // namespace realsense_camera
+#endif  // REALSENSE_CAMERA_WORKER_POOL_H
@@ -40,7 +40,10 @@
 
 #include <realsense_camera/zr300_paramsConfig.h>
 #include <realsense_camera/IMUInfo.h>
+#include <realsense_camera/IMUArray.h>
 #include <realsense_camera/GetIMUInfo.h>
+#include <realsense_camera/imu_fusion.h>
+#include <realsense_camera/orientation_filter.h>
 #include <realsense_camera/r200_nodelet.h>
 
 namespace realsense_camera
@@ -58,20 +61,46 @@ protected:
   bool enable_imu_;
   std::string imu_frame_id_;
   std::string imu_optical_frame_id_;
-  float imu_angular_vel_[3];
-  float imu_linear_accel_[3];
-  float imu_angular_vel_cov_[9] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
-  float imu_linear_accel_cov_[9] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
-  double imu_ts_;
-  double prev_imu_ts_;
+  struct IMUSample
+  {
+    int source;        // RS_EVENT_IMU_GYRO or RS_EVENT_IMU_ACCEL
+    double timestamp;  // device ms
+    float axes[3];
+    ros::Time stamp;   // set by the publisher thread
+  };
+  int imu_queue_size_;
+  RingBuffer<IMUSample> imu_ring_;
+  std::atomic<bool> imu_running_ = {false};
+  std::atomic<uint64_t> imu_received_ = {0};
+  std::atomic<uint64_t> imu_published_ = {0};
+  std::atomic<uint64_t> imu_overwritten_ = {0};
+  uint64_t reported_imu_overwritten_ = 0;  // diagnostics thread only
   ros::Publisher imu_publisher_;
+  ros::Publisher imu_batch_publisher_;
+  double imu_batch_period_;
+  std::atomic<uint64_t> imu_batches_ = {0};
+  ros::Publisher imu_fused_publisher_;
+  rs_motion_intrinsics imu_intrinsics_;
+  MotionFusion imu_fusion_;
+  std::atomic<uint64_t> imu_fused_ = {0};
+  std::atomic<uint64_t> imu_fusion_dropped_ = {0};
+  bool enable_orientation_;
+  bool enable_imu_tf_;
+  std::string imu_world_frame_id_;
+  OrientationFilter imu_orientation_;  // publisher thread only
+  // publisher thread buffers, reused across batches
+  std::vector<IMUSample> imu_samples_;
+  std::vector<MotionSample> gyro_samples_;
+  std::vector<MotionSample> accel_samples_;
+  std::vector<FusedMotionSample> fused_samples_;
   boost::shared_ptr<boost::thread> imu_thread_;
   std::function<void(rs::motion_data)> motion_handler_;
   std::function<void(rs::timestamp_data)> timestamp_handler_;
-  std::mutex imu_mutex_;
+  DeviceClockModel motion_clock_model_;  // IMU and fisheye, guarded by clock_mutex_
+  uint64_t reported_motion_clock_resets_ = 0;
 
   rs_extrinsics color2fisheye_extrinsic_;  // color frame is base frame
-  rs_extrinsics color2imu_extrinsic_;      // color frame is base frame
+  rs_extrinsics imu2color_extrinsic_;      // color frame is base frame
 
   // Member Functions.
   void getParameters();
@@ -82,12 +111,21 @@ protected:
   void startDynamicReconfCallback();
   void configCallback(realsense_camera::zr300_paramsConfig &config, uint32_t level);
   void getCameraExtrinsics();
-  void publishStaticTransforms();
-  void publishDynamicTransforms();
+  void buildTransformTable();
   void publishIMU();
+  void publishIMUSample(const IMUSample &sample);
+  void publishFusedIMU(const std::vector<IMUSample> &samples, bool publish);
+  void loadIMUCalibration();
+  void addIMUBatchSample(realsense_camera::IMUArrayPtr &batch, const IMUSample &sample, const ros::Time &stamp);
   void setStreams();
+  bool requiresStreaming();
   void setIMUCallbacks();
   void setFrameCallbacks();
+  DeviceClockModel &getClockModel(rs_stream stream_index);
+  void resetClockModels();
+  void diagnoseClockSync(diagnostic_updater::DiagnosticStatusWrapper &stat);
+  void setupDiagnostics();
+  void diagnoseIMU(diagnostic_updater::DiagnosticStatusWrapper &stat);
   std::function<void(rs::frame f)> fisheye_frame_handler_;
   void stopIMU();
 };
@@ -0,0 +1,231 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <realsense_camera/aggregator_nodelet.h>
+
+PLUGINLIB_EXPORT_CLASS(realsense_camera::AggregatorNodelet, nodelet::Nodelet)
+
+namespace realsense_camera
+{
+  /*
+   * Nodelet Destructor.
+   */
+  AggregatorNodelet::~AggregatorNodelet()
+  {
+    aggregate_timer_.stop();
+    if (frame_hub_)
+    {
+      for (int sink : sinks_)
+      {
+        frame_hub_->removeSink(sink);
+      }
+    }
+  }
+
+  /*
+   * Initialize the nodelet.
+   */
+  void AggregatorNodelet::onInit()
+  {
+    if (getParameters() == false)
+    {
+      return;
+    }
+
+    sync_.configure(channels_.size(), history_, max_skew_ms_ * 0.001);
+    frame_hub_ = FrameHub::acquire();
+    for (size_t i = 0; i < channels_.size(); i++)
+    {
+      sinks_.push_back(frame_hub_->addSink(channels_[i].camera, channels_[i].stream,
+          [this, i](const sensor_msgs::ImageConstPtr &image,  // NOLINT(build/c++11)
+              const sensor_msgs::CameraInfoConstPtr &camera_info)
+          {
+            sync_.add(i, image, camera_info);
+          }));
+    }
+
+    frameset_pub_ = pnh_.advertise<realsense_camera::Frameset>(FRAMESET, 1);
+
+    diagnostic_updater_.reset(new diagnostic_updater::Updater(nh_, pnh_, nodelet_name_));
+    diagnostic_updater_->setHardwareID(nodelet_name_);
+    diagnostic_updater_->add("Multi-camera Alignment", this, &AggregatorNodelet::diagnoseAlignment);
+    stats_start_ = std::chrono::steady_clock::now();
+    diagnostic_timer_ = nh_.createTimer(ros::Duration(DIAGNOSTICS_PERIOD), &AggregatorNodelet::updateDiagnostics,
+        this);
+
+    aggregate_timer_ = nh_.createTimer(ros::Duration(1.0 / rate_), &AggregatorNodelet::aggregate, this);
+    ROS_INFO_STREAM(nodelet_name_ << " - Aggregating " << channels_.size() << " camera streams at " << rate_
+        << " Hz");
+  }
+
+  /*
+   * Get the nodelet parameters. Returns false when no camera stream is configured.
+   */
+  bool AggregatorNodelet::getParameters()
+  {
+    nodelet_name_ = getName();
+    nh_ = getNodeHandle();
+    pnh_ = getPrivateNodeHandle();
+
+    std::vector<std::string> cameras;
+    std::vector<std::string> streams;
+    pnh_.param("cameras", cameras, std::vector<std::string>());
+    pnh_.param("streams", streams, std::vector<std::string>(1, DEPTH_NAMESPACE));
+    pnh_.param("rate", rate_, AGGREGATOR_RATE);
+    pnh_.param("max_skew_ms", max_skew_ms_, AGGREGATOR_MAX_SKEW_MS);
+    pnh_.param("history", history_, AGGREGATOR_HISTORY);
+    pnh_.param("frame_id", frame_id_, DEFAULT_AGGREGATOR_FRAME_ID);
+
+    if (rate_ <= 0.0)
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - Invalid rate " << rate_ << "; using " << AGGREGATOR_RATE);
+      rate_ = AGGREGATOR_RATE;
+    }
+    if (max_skew_ms_ < 0.0)
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - Invalid max_skew_ms " << max_skew_ms_ << "; using "
+          << AGGREGATOR_MAX_SKEW_MS);
+      max_skew_ms_ = AGGREGATOR_MAX_SKEW_MS;
+    }
+    if (history_ < 1)
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - Invalid history " << history_ << "; using " << AGGREGATOR_HISTORY);
+      history_ = AGGREGATOR_HISTORY;
+    }
+
+    // The stream names are the topic namespaces of the camera nodelets.
+    const std::string stream_names[STREAM_COUNT] =
+    {
+      DEPTH_NAMESPACE, COLOR_NAMESPACE, IR_NAMESPACE, IR2_NAMESPACE, FISHEYE_NAMESPACE
+    };
+    std::vector<int> stream_ids;
+    for (const std::string &name : streams)
+    {
+      const std::string *found = std::find(stream_names, stream_names + STREAM_COUNT, name);
+      if (found == stream_names + STREAM_COUNT)
+      {
+        ROS_WARN_STREAM(nodelet_name_ << " - Unknown stream '" << name << "'; ignoring it");
+        continue;
+      }
+      stream_ids.push_back(static_cast<int>(found - stream_names));
+    }
+
+    // Cameras are the namespaces of their nodelets, relative to the namespace of the aggregator.
+    for (const std::string &camera : cameras)
+    {
+      for (int stream : stream_ids)
+      {
+        channels_.push_back({nh_.resolveName(camera), stream});
+      }
+    }
+    if (channels_.empty())
+    {
+      ROS_ERROR_STREAM(nodelet_name_ << " - No cameras or streams to aggregate; set the cameras parameter");
+      return false;
+    }
+    return true;
+  }
+
+  /*
+   * Collect the aligned frameset of this period, if the cameras delivered one.
+   */
+  void AggregatorNodelet::aggregate(const ros::TimerEvent &event)
+  {
+    AlignedFrameset frameset;
+    if (sync_.collect(frameset) == false)
+    {
+      return;
+    }
+    frame_hub_->publishFrameset(nodelet_name_, frameset);
+    if (frameset_pub_.getNumSubscribers() > 0)
+    {
+      publishFrameset(frameset);
+    }
+  }
+
+  /*
+   * Publish the frameset as a message. Unlike the hub listeners, this copies the images.
+   */
+  void AggregatorNodelet::publishFrameset(const AlignedFrameset &frameset)
+  {
+    realsense_camera::FramesetPtr msg = boost::make_shared<realsense_camera::Frameset>();
+    msg->header.stamp = frameset.stamp;
+    msg->header.frame_id = frame_id_;
+    msg->images.resize(frameset.images.size());
+    msg->camera_infos.resize(frameset.images.size());
+    for (size_t i = 0; i < frameset.images.size(); i++)
+    {
+      msg->images[i] = *frameset.images[i];
+      msg->images[i].header.stamp = msg->header.stamp;
+      msg->camera_infos[i] = *frameset.camera_infos[i];
+      msg->camera_infos[i].header.stamp = msg->header.stamp;
+    }
+    frameset_pub_.publish(msg);
+  }
+
+  /*
+   * Report the framesets collected, the cross-camera skew of their frames and the periods
+   * without a set.
+   */
+  void AggregatorNodelet::diagnoseAlignment(diagnostic_updater::DiagnosticStatusWrapper &stat)
+  {
+    MultiCameraSynchronizer::Statistics stats = sync_.takeStatistics();
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    double elapsed_sec = std::chrono::duration<double>(now - stats_start_).count();
+    stats_start_ = now;
+
+    if (stats.collected == 0)
+    {
+      stat.summary(diagnostic_msgs::DiagnosticStatus::WARN, (stats.skewed > 0) ?
+          "Camera frames are further apart than max_skew_ms" : "No framesets");
+    }
+    else
+    {
+      stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Multi-camera alignment");
+    }
+    stat.add("Channels", channels_.size());
+    stat.add("Framesets", stats.collected);
+    stat.add("Rate", (elapsed_sec > 0.0) ? stats.collected / elapsed_sec : 0.0);
+    stat.add("Mean skew ms", (stats.collected > 0) ? stats.total_skew_ms / stats.collected : 0.0);
+    stat.add("Max skew ms", stats.max_skew_ms);
+    stat.add("Incomplete periods", stats.incomplete);
+    stat.add("Skewed periods", stats.skewed);
+    stat.add("Stale periods", stats.stale);
+  }
+
+  void AggregatorNodelet::updateDiagnostics(const ros::TimerEvent &event)
+  {
+    diagnostic_updater_->update();
+  }
+}  // namespace realsense_camera
@@ -28,11 +28,15 @@
  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *******************************************************************************/
 
+#include <cstring>
 #include <string>
 #include <algorithm>
 #include <vector>
 #include <map>
+#include <utility>
 #include <realsense_camera/base_nodelet.h>
+#include <realsense_camera/image_utils.h>
+#include <realsense_camera/simd.h>
 
 using cv::Mat;
 using cv::Scalar;
@@ -44,6 +48,22 @@ namespace realsense_camera
 {
   const std::map<std::string, std::string> CAMERA_NAME_TO_VALIDATED_FIRMWARE
         (MAP_START_VALUES, MAP_START_VALUES + MAP_START_VALUES_SIZE);
+
+  /*
+   * Options the camera adjusts by itself while their auto mode is on, with that mode.
+   */
+  const std::pair<rs_option, rs_option> AUTO_MANAGED_OPTIONS[] =
+  {
+    {RS_OPTION_COLOR_EXPOSURE, RS_OPTION_COLOR_ENABLE_AUTO_EXPOSURE},
+    {RS_OPTION_COLOR_GAIN, RS_OPTION_COLOR_ENABLE_AUTO_EXPOSURE},
+    {RS_OPTION_COLOR_WHITE_BALANCE, RS_OPTION_COLOR_ENABLE_AUTO_WHITE_BALANCE},
+    {RS_OPTION_R200_LR_EXPOSURE, RS_OPTION_R200_LR_AUTO_EXPOSURE_ENABLED},
+    {RS_OPTION_R200_LR_GAIN, RS_OPTION_R200_LR_AUTO_EXPOSURE_ENABLED},
+    {RS_OPTION_FISHEYE_EXPOSURE, RS_OPTION_FISHEYE_ENABLE_AUTO_EXPOSURE},
+    {RS_OPTION_FISHEYE_GAIN, RS_OPTION_FISHEYE_ENABLE_AUTO_EXPOSURE},
+    {RS_OPTION_F200_LASER_POWER, RS_OPTION_SR300_AUTO_RANGE_ENABLE_LASER},
+    {RS_OPTION_F200_MOTION_RANGE, RS_OPTION_SR300_AUTO_RANGE_ENABLE_MOTION_VERSUS_RANGE}
+  };
   /*
    * Nodelet Destructor.
    */
@@ -55,12 +75,21 @@ namespace realsense_camera
     }
 
     stopCamera();
+    stopFrameWorkers();
+    // The last nodelet to let go stops the pool.
+    worker_pool_.reset();
 
-    if (rs_context_)
+    if (frame_hub_)
     {
-      rs_delete_context(rs_context_, &rs_error_);
-      rs_context_ = NULL;
-      checkError();
+      frame_hub_->removeSource(frame_source_);
+      frame_hub_.reset();
+    }
+
+    if (device_registry_)
+    {
+      // The last nodelet to let go deletes the context.
+      device_registry_->release(rs_device_);
+      device_registry_.reset();
     }
 
     // Kill all old system progress groups
@@ -82,26 +111,57 @@ namespace realsense_camera
    */
   void BaseNodelet::onInit() try
   {
+    startup_start_ = std::chrono::steady_clock::now();
+    startup_phase_start_ = startup_start_;
     getParameters();
+    worker_pool_ = WorkerPool::acquire(worker_threads_);
+    if (worker_threads_ > 0 && worker_pool_->getConcurrency() != static_cast<unsigned>(worker_threads_))
+    {
+      ROS_INFO_STREAM(nodelet_name_ << " - Sharing the worker pool of the manager, with "
+          << worker_pool_->getConcurrency() << " threads");
+    }
+    endStartupPhase("parameters");
 
-    while (false == connectToCamera())  // Poll for camera and connect if found
+    if (waitForCamera() == false)
     {
-      ROS_INFO_STREAM(nodelet_name_ << " - Sleeping 5 seconds then retrying to connect");
-      ros::Duration(5).sleep();
+      return;  // shutting down
     }
+    endStartupPhase("connect");
 
+    setupStreamDemand();
     advertiseTopics();
+    topics_advertised_ = true;
+    setupFrameHub();
+    updateStreamDemand();
     advertiseServices();
+    setupDiagnostics();
+    endStartupPhase("advertise");
     std::vector<std::string> dynamic_params = setDynamicReconfServer();
     getCameraOptions();
     setStaticCameraOptions(dynamic_params);
-    setStreams();
-    startCamera();
+    setupOptionRefresh();
+    endStartupPhase("options");
+    {
+      std::unique_lock<std::mutex> lock(stream_mutex_);
+      setStreams();
+      startFrameWorkers();
+
+      // Time the first frames from the start of onInit, as after a profile switch.
+      profile_switch_start_ = startup_start_;
+      first_frame_event_ = "start";
+      for (int stream = 0; stream < STREAM_COUNT; stream++)
+      {
+        awaiting_first_frame_[stream] = isStreamWanted(stream);
+      }
+      startCamera();
+    }
+    endStartupPhase("streams");
 
     // Start transforms thread
     if (enable_tf_ == true)
     {
       getCameraExtrinsics();
+      buildTransformTable();
 
       if (enable_tf_dynamic_ == true)
       {
@@ -114,8 +174,11 @@ namespace realsense_camera
       }
     }
 
+    endStartupPhase("transforms");
+
     // Start dynamic reconfigure callback
     startDynamicReconfCallback();
+    reportStartup();
   }
   catch(const rs::error & e)
   {
@@ -150,8 +213,24 @@ namespace realsense_camera
     pnh_.param("enable_depth", enable_[RS_STREAM_DEPTH], ENABLE_DEPTH);
     pnh_.param("enable_rgb", enable_[RS_STREAM_COLOR], ENABLE_COLOR);
     pnh_.param("enable_ir", enable_[RS_STREAM_INFRARED], ENABLE_IR);
+    pnh_.param("enable_pointcloud", enable_pointcloud_, ENABLE_PC);
+    pnh_.param("organized_pointcloud", organized_pointcloud_, ORGANIZED_PC);
+    pnh_.param("enable_registration", enable_registration_, ENABLE_REGISTRATION);
+    pnh_.param("decimation_factor", decimation_factor_, DECIMATION_FACTOR);
+    std::string decimation_mode;
+    pnh_.param("decimation_mode", decimation_mode, DECIMATION_MEDIAN);
+    std::string color_format;
+    pnh_.param("color_format", color_format, DEFAULT_COLOR_FORMAT);
+    pnh_.param("converted_color_encoding", converted_color_encoding_, sensor_msgs::image_encodings::RGB8);
+    pnh_.param("worker_threads", worker_threads_, WORKER_THREADS);
     pnh_.param("enable_tf", enable_tf_, ENABLE_TF);
     pnh_.param("enable_tf_dynamic", enable_tf_dynamic_, ENABLE_TF_DYNAMIC);
+    pnh_.param("tf_publish_rate", tf_publish_rate_, TF_PUBLISH_RATE);
+    pnh_.param("option_refresh_interval", option_refresh_interval_, OPTION_REFRESH_INTERVAL);
+    pnh_.param("reconnect_min_delay", reconnect_min_delay_, RECONNECT_MIN_DELAY);
+    pnh_.param("reconnect_max_delay", reconnect_max_delay_, RECONNECT_MAX_DELAY);
+    pnh_.param("enable_lazy_streams", enable_lazy_streams_, ENABLE_LAZY_STREAMS);
+    pnh_.param("lazy_stream_debounce", lazy_stream_debounce_, LAZY_STREAM_DEBOUNCE);
     pnh_.param("depth_width", width_[RS_STREAM_DEPTH], DEPTH_WIDTH);
     pnh_.param("depth_height", height_[RS_STREAM_DEPTH], DEPTH_HEIGHT);
     pnh_.param("rgb_width", width_[RS_STREAM_COLOR], COLOR_WIDTH);
@@ -165,6 +244,115 @@ namespace realsense_camera
     pnh_.param("depth_optical_frame_id", optical_frame_id_[RS_STREAM_DEPTH], DEFAULT_DEPTH_OPTICAL_FRAME_ID);
     pnh_.param("rgb_optical_frame_id", optical_frame_id_[RS_STREAM_COLOR], DEFAULT_COLOR_OPTICAL_FRAME_ID);
     pnh_.param("ir_optical_frame_id", optical_frame_id_[RS_STREAM_INFRARED], DEFAULT_IR_OPTICAL_FRAME_ID);
+    pnh_.param("image_pool_max_mb", image_pool_max_mb_, IMAGE_POOL_MAX_MB);
+    pnh_.param("frame_queue_size", frame_queue_size_, FRAME_QUEUE_SIZE);
+    pnh_.param("frame_drop_policy", frame_drop_policy_, DEFAULT_FRAME_DROP_POLICY);
+    pnh_.param("frame_max_age_ms", frame_max_age_ms_, FRAME_MAX_AGE_MS);
+    pnh_.param("frameset_tolerance_ms", frameset_tolerance_ms_, FRAMESET_TOLERANCE_MS);
+    pnh_.param("enable_clock_sync", enable_clock_sync_, ENABLE_CLOCK_SYNC);
+    pnh_.param("clock_sync_window", clock_sync_window_, CLOCK_SYNC_WINDOW);
+    pnh_.param("clock_sync_outlier_ms", clock_sync_outlier_ms_, CLOCK_SYNC_OUTLIER_MS);
+
+    if (tf_publish_rate_ <= 0.0)
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - Invalid tf_publish_rate " << tf_publish_rate_ << "; using "
+          << TF_PUBLISH_RATE);
+      tf_publish_rate_ = TF_PUBLISH_RATE;
+    }
+    if (reconnect_min_delay_ <= 0.0)
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - Invalid reconnect_min_delay " << reconnect_min_delay_ << "; using "
+          << RECONNECT_MIN_DELAY);
+      reconnect_min_delay_ = RECONNECT_MIN_DELAY;
+    }
+    if (reconnect_max_delay_ < reconnect_min_delay_)
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - Invalid reconnect_max_delay " << reconnect_max_delay_ << "; using "
+          << reconnect_min_delay_);
+      reconnect_max_delay_ = reconnect_min_delay_;
+    }
+    if (worker_threads_ < 0)
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - Invalid worker_threads " << worker_threads_ << "; using "
+          << WORKER_THREADS);
+      worker_threads_ = WORKER_THREADS;
+    }
+    if (option_refresh_interval_ < 0.0)
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - Invalid option_refresh_interval " << option_refresh_interval_
+          << "; using " << OPTION_REFRESH_INTERVAL);
+      option_refresh_interval_ = OPTION_REFRESH_INTERVAL;
+    }
+    if (decimation_factor_ != 2 && decimation_factor_ != 4)
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - Invalid decimation_factor " << decimation_factor_ << "; using "
+          << DECIMATION_FACTOR);
+      decimation_factor_ = DECIMATION_FACTOR;
+    }
+    if (decimation_mode == DECIMATION_MIN_VALID)
+    {
+      decimation_mode_ = DEPTH_DECIMATION_MIN_VALID;
+    }
+    else
+    {
+      if (decimation_mode != DECIMATION_MEDIAN)
+      {
+        ROS_WARN_STREAM(nodelet_name_ << " - Unknown decimation_mode '" << decimation_mode << "'; using "
+            << DECIMATION_MEDIAN);
+      }
+      decimation_mode_ = DEPTH_DECIMATION_MEDIAN;
+    }
+    if (color_format == COLOR_FORMAT_YUYV)
+    {
+      // Publish the native pixels, converting only for the subscribers of the converted topics.
+      format_[RS_STREAM_COLOR] = RS_FORMAT_YUYV;
+      encoding_[RS_STREAM_COLOR] = YUYV_ENCODING;
+      cv_type_[RS_STREAM_COLOR] = CV_8UC2;
+      unit_step_size_[RS_STREAM_COLOR] = sizeof(unsigned char) * 2;
+    }
+    else if (color_format != COLOR_FORMAT_RGB8)
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - Unknown color_format '" << color_format << "'; using "
+          << COLOR_FORMAT_RGB8);
+    }
+    if (converted_color_encoding_ == sensor_msgs::image_encodings::BGR8)
+    {
+      color_conversion_ = YUYV_TO_BGR8;
+    }
+    else
+    {
+      if (converted_color_encoding_ != sensor_msgs::image_encodings::RGB8)
+      {
+        ROS_WARN_STREAM(nodelet_name_ << " - Unknown converted_color_encoding '" << converted_color_encoding_
+            << "'; using " << sensor_msgs::image_encodings::RGB8);
+        converted_color_encoding_ = sensor_msgs::image_encodings::RGB8;
+      }
+      color_conversion_ = YUYV_TO_RGB8;
+    }
+    if (frame_queue_size_ < 1)
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - Invalid frame_queue_size " << frame_queue_size_ << "; using 1");
+      frame_queue_size_ = 1;
+    }
+    if (frame_drop_policy_ != FRAME_DROP_OLDEST && frame_drop_policy_ != FRAME_DROP_NEWEST &&
+        frame_drop_policy_ != FRAME_DROP_MAX_AGE)
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - Unknown frame_drop_policy '" << frame_drop_policy_ << "'; using "
+          << DEFAULT_FRAME_DROP_POLICY);
+      frame_drop_policy_ = DEFAULT_FRAME_DROP_POLICY;
+    }
+    if (clock_sync_window_ <= 0.0)
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - Invalid clock_sync_window " << clock_sync_window_ << "; using "
+          << CLOCK_SYNC_WINDOW);
+      clock_sync_window_ = CLOCK_SYNC_WINDOW;
+    }
+    if (clock_sync_outlier_ms_ <= 0.0)
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - Invalid clock_sync_outlier_ms " << clock_sync_outlier_ms_ << "; using "
+          << CLOCK_SYNC_OUTLIER_MS);
+      clock_sync_outlier_ms_ = CLOCK_SYNC_OUTLIER_MS;
+    }
 
     // set IR stream to match depth
     width_[RS_STREAM_INFRARED] = width_[RS_STREAM_DEPTH];
@@ -173,40 +361,96 @@ namespace realsense_camera
   }
 
   /*
-   * Connect to camera.
+   * Retry connectToCamera until it succeeds. The delay between attempts doubles from
+   * reconnect_min_delay up to reconnect_max_delay, and a new video device node ends the wait early.
+   * Returns false when ROS shuts down first.
+   */
+  bool BaseNodelet::waitForCamera()
+  {
+    // Watch before the first attempt so that a camera plugged in during it is not missed.
+    bool watching = device_watcher_.open();
+    double delay = reconnect_min_delay_;
+    bool connected;
+    while (false == (connected = connectToCamera()))  // Poll for camera and connect if found
+    {
+      if (!ros::ok())
+      {
+        break;
+      }
+      ROS_INFO_STREAM(nodelet_name_ << " - Retrying to connect in " << delay << " seconds"
+          << (watching ? " or when a device appears" : ""));
+      if (device_watcher_.wait(delay, DEVICE_SETTLE_TIME) == true)
+      {
+        ROS_INFO_STREAM(nodelet_name_ << " - Device appeared; retrying to connect");
+        delay = reconnect_min_delay_;
+      }
+      else
+      {
+        delay = std::min(delay * 2.0, reconnect_max_delay_);
+      }
+    }
+    device_watcher_.close();
+    return connected;
+  }
+
+  /*
+   * Record the time since the previous startup phase ended.
+   */
+  void BaseNodelet::endStartupPhase(const std::string &phase)
+  {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    double elapsed_ms = std::chrono::duration<double, std::milli>(now - startup_phase_start_).count();
+    startup_phases_.push_back(std::make_pair(phase, elapsed_ms));
+    startup_phase_start_ = now;
+  }
+
+  /*
+   * Log the startup phases on one line.
+   */
+  void BaseNodelet::reportStartup()
+  {
+    double total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+        startup_start_).count();
+    std::ostringstream phases;
+    for (size_t i = 0; i < startup_phases_.size(); i++)
+    {
+      phases << (i == 0 ? "" : ", ") << startup_phases_[i].first << " " << startup_phases_[i].second << " ms";
+    }
+    ROS_INFO_STREAM(nodelet_name_ << " - Started in " << total_ms << " ms (" << phases.str() << ")");
+  }
+
+  /*
+   * Connect to camera, taking it from the device registry shared by the nodelets of this process.
    */
   bool BaseNodelet::connectToCamera()
   {
-    rs_context_ = rs_create_context(RS_API_VERSION, &rs_error_);
+    if (!device_registry_)
+    {
+      device_registry_ = DeviceRegistry::acquire();
+    }
+    bool scanned = device_registry_->scan(*worker_pool_, device_generation_, &rs_error_);
     if (rs_error_)
     {
       ROS_ERROR_STREAM(nodelet_name_ << " - No cameras detected!");
     }
     checkError();
 
-    int num_of_cameras = rs_get_device_count(rs_context_, &rs_error_);
-    checkError();
+    std::vector<DeviceRegistry::Device> devices = device_registry_->getDevices();
 
     // Exit with error if no cameras are connected.
-    if (num_of_cameras < 1)
+    if (devices.size() < 1)
     {
       ROS_ERROR_STREAM(nodelet_name_ << " - No cameras detected!");
-      rs_delete_context(rs_context_, &rs_error_);
-      rs_context_ = NULL;
-      checkError();
       return false;
     }
 
-    // Print list of all cameras found
-    std::vector<int> camera_type_index = listCameras(num_of_cameras);
+    // Print list of all cameras found, once per enumeration
+    std::vector<int> camera_type_index = listCameras(devices, scanned);
 
     // Exit with error if no cameras of correct type are connected.
     if (camera_type_index.size() < 1)
     {
       ROS_ERROR_STREAM(nodelet_name_ << " - No '" << camera_type_ << "' cameras detected!");
-      rs_delete_context(rs_context_, &rs_error_);
-      rs_context_ = NULL;
-      checkError();
       return false;
     }
 
@@ -215,44 +459,24 @@ namespace realsense_camera
     {
       ROS_ERROR_STREAM(nodelet_name_ <<
           " - Multiple cameras of same type detected but no input serial_no or usb_port_id specified");
-      rs_delete_context(rs_context_, &rs_error_);
-      rs_context_ = NULL;
-      checkError();
       return false;
     }
 
-    // init rs_device_ before starting loop
-    rs_device_ = nullptr;
-
     // find camera
-    for (int i : camera_type_index)
-    {
-      rs_device* rs_detected_device = rs_get_device(rs_context_, i, &rs_error_);
-      checkError();
-
-      // check serial_no and usb_port_id
-      if ((serial_no_.empty() || serial_no_ == rs_get_device_serial(rs_detected_device, &rs_error_)) &&
-          (usb_port_id_.empty() || usb_port_id_ == rs_get_device_usb_port_id(rs_detected_device, &rs_error_)))
-      {
-        // device found
-        rs_device_ = rs_detected_device;
-        break;
-      }
-      // continue loop
-    }
-
+    std::string assigned_to;
+    rs_device_ = device_registry_->assign(nodelet_name_, camera_type_, serial_no_, usb_port_id_, assigned_to);
     if (rs_device_ == nullptr)
     {
       // camera not found
       string error_msg = " - Couldn't find camera to connect with ";
       error_msg += "serial_no = " + serial_no_ + ", ";
       error_msg += "usb_port_id = " + usb_port_id_;
+      if (!assigned_to.empty())
+      {
+        error_msg += "; it is used by " + assigned_to;
+      }
 
       ROS_ERROR_STREAM(nodelet_name_ << error_msg);
-
-      rs_delete_context(rs_context_, &rs_error_);
-      rs_context_ = NULL;
-      checkError();
       return false;
     }
 
@@ -265,73 +489,56 @@ namespace realsense_camera
   }
 
   /*
-   * List details of the detected cameras.
+   * List details of the detected cameras and return the indices of those of camera_type_.
+   * The details are printed only when print is true.
    */
-  std::vector<int> BaseNodelet::listCameras(int num_of_cameras)
+  std::vector<int> BaseNodelet::listCameras(const std::vector<DeviceRegistry::Device> &devices, bool print)
   {
-    // print list of detected cameras
     std::vector<int> camera_type_index;
-
-    for (int i = 0; i < num_of_cameras; i++)
+    for (size_t i = 0; i < devices.size(); i++)
     {
-      std::string detected_camera_msg = " - Detected the following camera:";
-      std::string warning_msg = " - Detected unvalidated firmware:";
-      // get device
-      rs_device* rs_detected_device = rs_get_device(rs_context_, i, &rs_error_);
-
-      // get camera serial number
-      std::string camera_serial_number = rs_get_device_serial(rs_detected_device, &rs_error_);
-      checkError();
-
-      // get camera name
-      std::string camera_name = rs_get_device_name(rs_detected_device, &rs_error_);
-      checkError();
-
-      // get camera firmware
-      std::string camera_fw = rs_get_device_firmware_version(rs_detected_device, &rs_error_);
-      checkError();
-
-      if (camera_name.find(camera_type_) != std::string::npos)
+      const DeviceRegistry::Device &device = devices[i];
+      if (device.name.find(camera_type_) != std::string::npos)
       {
         camera_type_index.push_back(i);
       }
+      if (print == false)
+      {
+        continue;
+      }
+
+      std::string detected_camera_msg = " - Detected the following camera:";
+      std::string warning_msg = " - Detected unvalidated firmware:";
+
       // print camera details
       detected_camera_msg = detected_camera_msg +
-            "\n\t\t\t\t- Serial No: " + camera_serial_number + ", USB Port ID: " +
-            rs_get_device_usb_port_id(rs_detected_device, &rs_error_) +
-            ", Name: " + camera_name +
-            ", Camera FW: " + camera_fw;
-      checkError();
-
-      std::string camera_warning_msg = checkFirmwareValidation("camera", camera_fw, camera_name, camera_serial_number);
+            "\n\t\t\t\t- Serial No: " + device.serial_no + ", USB Port ID: " + device.usb_port_id +
+            ", Name: " + device.name +
+            ", Camera FW: " + device.camera_fw;
 
+      std::string camera_warning_msg = checkFirmwareValidation("camera", device.camera_fw, device.name,
+            device.serial_no);
       if (!camera_warning_msg.empty())
       {
         warning_msg = warning_msg + "\n\t\t\t\t- " + camera_warning_msg;
       }
 
-      if (rs_supports(rs_detected_device, RS_CAPABILITIES_ADAPTER_BOARD, &rs_error_))
+      if (!device.adapter_fw.empty())
       {
-        const char * adapter_fw = rs_get_device_info(rs_detected_device,
-            RS_CAMERA_INFO_ADAPTER_BOARD_FIRMWARE_VERSION, &rs_error_);
-        checkError();
-        detected_camera_msg = detected_camera_msg + ", Adapter FW: " + adapter_fw;
-        std::string adapter_warning_msg = checkFirmwareValidation("adapter", adapter_fw, camera_name,
-              camera_serial_number);
+        detected_camera_msg = detected_camera_msg + ", Adapter FW: " + device.adapter_fw;
+        std::string adapter_warning_msg = checkFirmwareValidation("adapter", device.adapter_fw, device.name,
+              device.serial_no);
         if (!adapter_warning_msg.empty())
         {
           warning_msg = warning_msg + "\n\t\t\t\t- " + adapter_warning_msg;
         }
       }
 
-      if (rs_supports(rs_detected_device, RS_CAPABILITIES_MOTION_EVENTS, &rs_error_))
+      if (!device.motion_module_fw.empty())
       {
-        const char * motion_module_fw = rs_get_device_info(rs_detected_device,
-            RS_CAMERA_INFO_MOTION_MODULE_FIRMWARE_VERSION, &rs_error_);
-        checkError();
-        detected_camera_msg = detected_camera_msg + ", Motion Module FW: " + motion_module_fw;
-        std::string motion_module_warning_msg = checkFirmwareValidation("motion_module", motion_module_fw, camera_name,
-              camera_serial_number);
+        detected_camera_msg = detected_camera_msg + ", Motion Module FW: " + device.motion_module_fw;
+        std::string motion_module_warning_msg = checkFirmwareValidation("motion_module", device.motion_module_fw,
+              device.name, device.serial_no);
         if (!motion_module_warning_msg.empty())
         {
           warning_msg = warning_msg + "\n\t\t\t\t- " + motion_module_warning_msg;
@@ -354,17 +561,186 @@ namespace realsense_camera
   {
     ros::NodeHandle color_nh(nh_, COLOR_NAMESPACE);
     image_transport::ImageTransport color_image_transport(color_nh);
-    camera_publisher_[RS_STREAM_COLOR] = color_image_transport.advertiseCamera(IMAGE_RAW, 1);
+    camera_publisher_[RS_STREAM_COLOR] = advertiseCameraTopic(color_image_transport, IMAGE_RAW);
+    if (format_[RS_STREAM_COLOR] == RS_FORMAT_YUYV)
+    {
+      converted_color_publisher_ = advertiseCameraTopic(color_image_transport, IMAGE_COLOR);
+      mono_color_publisher_ = advertiseCameraTopic(color_image_transport, IMAGE_MONO);
+    }
 
     ros::NodeHandle depth_nh(nh_, DEPTH_NAMESPACE);
     image_transport::ImageTransport depth_image_transport(depth_nh);
-    camera_publisher_[RS_STREAM_DEPTH] = depth_image_transport.advertiseCamera(IMAGE_RECT, 1);
+    camera_publisher_[RS_STREAM_DEPTH] = advertiseCameraTopic(depth_image_transport, IMAGE_RECT);
 
-    min_depth_pub_ = depth_nh.advertise<std_msgs::UInt16>(DATA_MIN, 1);
+    ros::SubscriberStatusCallback demand_cb = boost::bind(&BaseNodelet::updateStreamDemand, this);
+    min_depth_pub_ = depth_nh.advertise<std_msgs::UInt16>(DATA_MIN, 1, demand_cb, demand_cb);
+    depth_stats_pub_ = depth_nh.advertise<realsense_camera::DepthStatistics>(DATA_STATS, 1, demand_cb, demand_cb);
+    if (enable_pointcloud_ == true)
+    {
+      pointcloud_pub_ = depth_nh.advertise<sensor_msgs::PointCloud2>(POINTS, 1, demand_cb, demand_cb);
+    }
+    compressed_depth_pub_ = depth_nh.advertise<sensor_msgs::CompressedImage>(IMAGE_RECT + "/" + BANDED_RVL_TRANSPORT,
+        1, demand_cb, demand_cb);
+    frameset_pub_ = nh_.advertise<realsense_camera::Frameset>(FRAMESET, 1, demand_cb, demand_cb);
 
     ros::NodeHandle ir_nh(nh_, IR_NAMESPACE);
     image_transport::ImageTransport ir_image_transport(ir_nh);
-    camera_publisher_[RS_STREAM_INFRARED] = ir_image_transport.advertiseCamera(IMAGE_RECT, 1);
+    camera_publisher_[RS_STREAM_INFRARED] = advertiseCameraTopic(ir_image_transport, IMAGE_RECT);
+
+    ros::NodeHandle depth_decimated_nh(nh_, DEPTH_DECIMATED_NAMESPACE);
+    image_transport::ImageTransport depth_decimated_image_transport(depth_decimated_nh);
+    decimated_depth_publisher_ = advertiseCameraTopic(depth_decimated_image_transport, IMAGE_RECT);
+
+    if (enable_registration_ == true)
+    {
+      ros::NodeHandle depth_registered_nh(nh_, DEPTH_REGISTERED_NAMESPACE);
+      image_transport::ImageTransport depth_registered_image_transport(depth_registered_nh);
+      registered_depth_publisher_ = advertiseCameraTopic(depth_registered_image_transport, IMAGE_RAW);
+
+      ros::NodeHandle color_registered_nh(nh_, COLOR_REGISTERED_NAMESPACE);
+      image_transport::ImageTransport color_registered_image_transport(color_registered_nh);
+      registered_color_publisher_ = advertiseCameraTopic(color_registered_image_transport, IMAGE_RAW);
+    }
+  }
+
+  /*
+   * Advertise a camera topic whose subscriber changes update the stream demand.
+   */
+  image_transport::CameraPublisher BaseNodelet::advertiseCameraTopic(image_transport::ImageTransport &image_transport,
+      const std::string &topic)
+  {
+    image_transport::SubscriberStatusCallback image_cb = boost::bind(&BaseNodelet::updateStreamDemand, this);
+    ros::SubscriberStatusCallback info_cb = boost::bind(&BaseNodelet::updateStreamDemand, this);
+    return image_transport.advertiseCamera(topic, 1, image_cb, image_cb, info_cb, info_cb);
+  }
+
+  /*
+   * Create the debounce timer that applies subscriber demand to the enabled streams.
+   */
+  void BaseNodelet::setupStreamDemand()
+  {
+    std::unique_lock<std::mutex> lock(stream_demand_mutex_);
+    stream_demand_timer_ = nh_.createTimer(ros::Duration(lazy_stream_debounce_), &BaseNodelet::applyStreamDemand,
+        this, true, false);
+  }
+
+  /*
+   * Recompute the subscriber demand flags. Called on every subscriber connect and disconnect,
+   * so that the frame path only reads atomics instead of querying the publishers. The callbacks
+   * of several publishers and the frame hub run concurrently, so the update and the timer
+   * restart are serialized.
+   */
+  void BaseNodelet::updateStreamDemand()
+  {
+    if (topics_advertised_ == false)
+    {
+      return;
+    }
+
+    std::unique_lock<std::mutex> lock(stream_demand_mutex_);
+    for (int stream = 0; stream < STREAM_COUNT; stream++)
+    {
+      image_demand_[stream] = (camera_publisher_[stream].getNumSubscribers() > 0);
+    }
+    min_depth_demand_ = (min_depth_pub_.getNumSubscribers() > 0);
+    depth_stats_demand_ = (depth_stats_pub_.getNumSubscribers() > 0);
+    pointcloud_demand_ = (pointcloud_pub_.getNumSubscribers() > 0);
+    decimated_depth_demand_ = (decimated_depth_publisher_.getNumSubscribers() > 0);
+    compressed_depth_demand_ = (compressed_depth_pub_.getNumSubscribers() > 0);
+    converted_color_demand_ = (converted_color_publisher_.getNumSubscribers() > 0);
+    mono_color_demand_ = (mono_color_publisher_.getNumSubscribers() > 0);
+    registered_depth_demand_ = (registered_depth_publisher_.getNumSubscribers() > 0);
+    registered_color_demand_ = (registered_color_publisher_.getNumSubscribers() > 0);
+    frameset_topic_demand_ = (frameset_pub_.getNumSubscribers() > 0);
+    frameset_demand_ = frameset_topic_demand_ || frameset_listener_demand_;
+    bool registration_demand = registered_depth_demand_ || registered_color_demand_;
+
+    bool changed = false;
+    for (int stream = 0; stream < STREAM_COUNT; stream++)
+    {
+      bool demand = image_demand_[stream] || frameset_demand_ || aggregator_demand_[stream];
+      if (stream == RS_STREAM_DEPTH)
+      {
+        demand = demand || min_depth_demand_ || depth_stats_demand_ || pointcloud_demand_ || decimated_depth_demand_ ||
+            compressed_depth_demand_;
+      }
+      if (stream == RS_STREAM_COLOR)
+      {
+        demand = demand || converted_color_demand_ || mono_color_demand_;
+      }
+      if (stream == RS_STREAM_DEPTH || stream == RS_STREAM_COLOR)
+      {
+        demand = demand || registration_demand;
+      }
+      changed = (stream_demand_[stream].exchange(demand) != demand) || changed;
+    }
+
+    if (changed && enable_lazy_streams_ == true)
+    {
+      // Restart the one-shot timer so that bursts of (dis)connections cause a single reconfiguration.
+      stream_demand_timer_.stop();
+      stream_demand_timer_.setPeriod(ros::Duration(lazy_stream_debounce_));
+      stream_demand_timer_.start();
+    }
+  }
+
+  /*
+   * Enable and disable the streams to follow the subscriber demand.
+   */
+  void BaseNodelet::applyStreamDemand(const ros::TimerEvent &event)
+  {
+    std::unique_lock<std::mutex> lock(stream_mutex_);
+
+    bool changed = false;
+    for (int stream = 0; stream < STREAM_COUNT; stream++)
+    {
+      if (isStreamWanted(stream) != (rs_is_stream_enabled(rs_device_, static_cast<rs_stream>(stream), 0) == 1))
+      {
+        changed = true;
+      }
+    }
+
+    if (changed == true)
+    {
+      ROS_INFO_STREAM(nodelet_name_ << " - Subscriber demand changed, reconfiguring streams");
+      restartStreams();
+    }
+  }
+
+  /*
+   * Check if a stream should be running: it is enabled and, with lazy streams, has subscribers.
+   */
+  bool BaseNodelet::isStreamWanted(int stream)
+  {
+    if (enable_[stream] == false)
+    {
+      return false;
+    }
+    if (enable_lazy_streams_ == false || stream_demand_[stream] == true)
+    {
+      return true;
+    }
+
+    // Keep the first enabled stream running if another source, e.g. motion tracking, needs the device started.
+    if (requiresStreaming() == true)
+    {
+      for (int other = 0; other < STREAM_COUNT; other++)
+      {
+        if (enable_[other] == true && stream_demand_[other] == true)
+        {
+          return false;
+        }
+      }
+      for (int first = 0; first < stream; first++)
+      {
+        if (enable_[first] == true)
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+    return false;
   }
 
   /*
@@ -374,6 +750,8 @@ namespace realsense_camera
   {
     get_options_service_ = pnh_.advertiseService(SETTINGS_SERVICE,
         &BaseNodelet::getCameraOptionValues, this);
+    get_camera_options_service_ = pnh_.advertiseService(CAMERA_OPTIONS_SERVICE,
+        &BaseNodelet::getCameraOptionsService, this);
     set_power_service_ = pnh_.advertiseService(CAMERA_SET_POWER_SERVICE,
         &BaseNodelet::setPowerCameraService, this);
     force_power_service_ = pnh_.advertiseService(CAMERA_FORCE_POWER_SERVICE,
@@ -383,7 +761,8 @@ namespace realsense_camera
   }
 
   /*
-   * Get the latest values of the camera options.
+   * Get the latest values of the camera options from the option cache. The values an auto mode
+   * manages are as recent as the last option refresh.
    */
   bool BaseNodelet::getCameraOptionValues(realsense_camera::CameraConfiguration::Request & req,
       realsense_camera::CameraConfiguration::Response & res)
@@ -391,11 +770,11 @@ namespace realsense_camera
     std::string get_options_result_str;
     std::string opt_name, opt_value;
 
-    for (CameraOptions o : camera_options_)
+    std::unique_lock<std::mutex> lock(option_cache_mutex_);
+    for (const CameraOptions &o : camera_options_)
     {
       opt_name = rs_option_to_string(o.opt);
       std::transform(opt_name.begin(), opt_name.end(), opt_name.begin(), ::tolower);
-      o.value = rs_get_device_option(rs_device_, o.opt, 0);
       opt_value = boost::lexical_cast<std::string>(o.value);
       get_options_result_str += opt_name + ":" + opt_value + ";";
     }
@@ -404,6 +783,33 @@ namespace realsense_camera
     return true;
   }
 
+  /*
+   * Get the supported camera options with their cached values and ranges.
+   */
+  bool BaseNodelet::getCameraOptionsService(realsense_camera::GetCameraOptions::Request & req,
+      realsense_camera::GetCameraOptions::Response & res)
+  {
+    std::unique_lock<std::mutex> lock(option_cache_mutex_);
+    size_t count = camera_options_.size();
+    res.ids.resize(count);
+    res.names.resize(count);
+    res.values.resize(count);
+    res.min.resize(count);
+    res.max.resize(count);
+    res.step.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+      const CameraOptions &o = camera_options_[i];
+      res.ids[i] = o.opt;
+      res.names[i] = o.name;
+      res.values[i] = o.value;
+      res.min[i] = o.min;
+      res.max[i] = o.max;
+      res.step[i] = o.step;
+    }
+    return true;
+  }
+
   /*
    * Check for Nodelet subscribers
    */
@@ -411,15 +817,11 @@ namespace realsense_camera
   {
     for (int index=0; index < STREAM_COUNT; index++)
     {
-      if (camera_publisher_[index].getNumSubscribers() > 0)
+      if (stream_demand_[index] == true)
       {
         return true;
       }
     }
-    if (min_depth_pub_.getNumSubscribers() > 0)
-    {
-      return true;
-    }
     return false;
   }
 
@@ -446,6 +848,7 @@ namespace realsense_camera
   bool BaseNodelet::setPowerCameraService(realsense_camera::SetPower::Request & req,
       realsense_camera::SetPower::Response & res)
   {
+    std::unique_lock<std::mutex> lock(stream_mutex_);
     res.success = true;
 
     if (req.power_on == true)
@@ -481,6 +884,7 @@ namespace realsense_camera
   bool BaseNodelet::forcePowerCameraService(realsense_camera::ForcePower::Request & req,
       realsense_camera::ForcePower::Response & res)
   {
+    std::unique_lock<std::mutex> lock(stream_mutex_);
     if (req.power_on == true)
     {
       ROS_INFO_STREAM(nodelet_name_ << " - " << startCamera());
@@ -498,6 +902,8 @@ namespace realsense_camera
    */
   void BaseNodelet::getCameraOptions()
   {
+    std::unique_lock<std::mutex> options_lock(options_mutex_);
+    std::unique_lock<std::mutex> cache_lock(option_cache_mutex_);
     for (int i = 0; i < RS_OPTION_COUNT; ++i)
     {
       CameraOptions o = { (rs_option) i };
@@ -510,12 +916,74 @@ namespace realsense_camera
         if (o.min != o.max)
         {
           o.value = rs_get_device_option(rs_device_, o.opt, 0);
+          o.name = rs_option_to_string(o.opt);
+          std::transform(o.name.begin(), o.name.end(), o.name.begin(), ::tolower);
           camera_options_.push_back(o);
+          applied_options_[o.opt] = o.value;
         }
       }
     }
   }
 
+  /*
+   * Start the timer that re-reads the options the camera changes by itself under an auto mode.
+   * The set paths keep the other cached values current. An interval of 0 disables it.
+   */
+  void BaseNodelet::setupOptionRefresh()
+  {
+    if (option_refresh_interval_ > 0.0)
+    {
+      option_refresh_timer_ = nh_.createTimer(ros::Duration(option_refresh_interval_),
+          &BaseNodelet::refreshCameraOptions, this);
+    }
+  }
+
+  /*
+   * Read the options an auto mode may have changed from the camera into the option cache and the
+   * last applied values. Options that fail to read keep their cached value.
+   */
+  void BaseNodelet::refreshCameraOptions(const ros::TimerEvent &event)
+  {
+    std::unique_lock<std::mutex> options_lock(options_mutex_);
+    for (size_t i = 0; i < camera_options_.size(); ++i)
+    {
+      rs_option opt = camera_options_[i].opt;
+      if (isAutoManaged(opt) == false)
+      {
+        continue;
+      }
+
+      // Runs beside the callers of checkError, so the error is kept local.
+      rs_error *error = NULL;
+      double value = rs_get_device_option(rs_device_, opt, &error);
+      if (error)
+      {
+        rs_free_error(error);
+        continue;
+      }
+      applied_options_[opt] = value;
+
+      std::unique_lock<std::mutex> cache_lock(option_cache_mutex_);
+      camera_options_[i].value = value;
+    }
+  }
+
+  /*
+   * Store an applied option value in the option cache.
+   */
+  void BaseNodelet::updateCachedOption(rs_option opt, double value)
+  {
+    std::unique_lock<std::mutex> lock(option_cache_mutex_);
+    for (CameraOptions &o : camera_options_)
+    {
+      if (o.opt == opt)
+      {
+        o.value = value;
+        break;
+      }
+    }
+  }
+
   /*
    * Set the static camera options.
    */
@@ -563,31 +1031,187 @@ namespace realsense_camera
             opt_val = val;
           }
           ROS_INFO_STREAM(nodelet_name_ << " - Setting camera option " << opt_name << " = " << opt_val);
-          rs_set_device_option(rs_device_, o.opt, opt_val, &rs_error_);
-          checkError();
+          queueCameraOption(o.opt, opt_val);
         }
       }
     }
+    applyCameraOptions();
   }
 
   /*
-  * Set up the callbacks for the camera streams
-  */
-  void BaseNodelet::setFrameCallbacks()
+   * Queue a camera option for the next applyCameraOptions, unless the camera already holds the value.
+   * The options the camera adjusts under an auto mode are always queued while that mode is on.
+   */
+  void BaseNodelet::queueCameraOption(rs_option opt, double value)
   {
-    depth_frame_handler_ = [&](rs::frame frame)  // NOLINT(build/c++11)
+    std::unique_lock<std::mutex> lock(options_mutex_);
+    std::map<rs_option, double>::const_iterator applied = applied_options_.find(opt);
+    if (applied != applied_options_.end() && applied->second == value && isAutoManaged(opt) == false)
     {
-      publishStreamTopic(RS_STREAM_DEPTH, frame);
-    };
+      return;
+    }
+    addPendingOption(opt, value);
+  }
 
-    color_frame_handler_ = [&](rs::frame frame)  // NOLINT(build/c++11)
+  /*
+   * Queue a group of options the camera takes together, such as the auto exposure window.
+   * The whole group is queued if any of its values changed.
+   */
+  void BaseNodelet::queueCameraOptions(const rs_option *opts, const double *values, size_t count)
+  {
+    std::unique_lock<std::mutex> lock(options_mutex_);
+    bool changed = false;
+    for (size_t i = 0; i < count && !changed; ++i)
     {
-      publishStreamTopic(RS_STREAM_COLOR, frame);
-    };
+      std::map<rs_option, double>::const_iterator applied = applied_options_.find(opts[i]);
+      changed = (applied == applied_options_.end() || applied->second != values[i] || isAutoManaged(opts[i]));
+    }
+
+    if (changed)
+    {
+      for (size_t i = 0; i < count; ++i)
+      {
+        addPendingOption(opts[i], values[i]);
+      }
+    }
+  }
+
+  /*
+   * Forget the last applied value of an option changed behind the shadow copy, so the next
+   * queued value is always sent.
+   */
+  void BaseNodelet::forgetCameraOption(rs_option opt)
+  {
+    std::unique_lock<std::mutex> lock(options_mutex_);
+    applied_options_.erase(opt);
+  }
+
+  /*
+   * Add an option to the queue, or update its queued value. An auto mode is queued ahead of the
+   * options it manages, so that a value set with the mode turned off is not overridden by it.
+   */
+  void BaseNodelet::addPendingOption(rs_option opt, double value)
+  {
+    std::vector<rs_option>::iterator pending = std::find(pending_options_.begin(), pending_options_.end(), opt);
+    if (pending != pending_options_.end())
+    {
+      pending_values_[pending - pending_options_.begin()] = value;
+      return;
+    }
+
+    size_t position = pending_options_.size();
+    for (const std::pair<rs_option, rs_option> &managed : AUTO_MANAGED_OPTIONS)
+    {
+      if (managed.second != opt)
+      {
+        continue;
+      }
+      pending = std::find(pending_options_.begin(), pending_options_.end(), managed.first);
+      position = std::min(position, static_cast<size_t>(pending - pending_options_.begin()));
+    }
+    pending_options_.insert(pending_options_.begin() + position, opt);
+    pending_values_.insert(pending_values_.begin() + position, value);
+  }
+
+  /*
+   * Whether the camera may change an option by itself, because its auto mode is on. Modes the
+   * camera does not support are never in the last applied values. The caller holds options_mutex_.
+   */
+  bool BaseNodelet::isAutoManaged(rs_option opt)
+  {
+    for (const std::pair<rs_option, rs_option> &managed : AUTO_MANAGED_OPTIONS)
+    {
+      if (managed.first != opt)
+      {
+        continue;
+      }
+      std::map<rs_option, double>::const_iterator mode = applied_options_.find(managed.second);
+      if (mode != applied_options_.end() && mode->second != 0.0)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /*
+   * Send the queued options to the camera in one rs_set_device_options call, in the order
+   * they were queued. If the batch fails they are retried one at a time, so one rejected
+   * option does not hold back the others.
+   */
+  void BaseNodelet::applyCameraOptions()
+  {
+    std::unique_lock<std::mutex> lock(options_mutex_);
+    if (pending_options_.empty())
+    {
+      return;
+    }
+
+    // Runs from the reconfigure callbacks beside the callers of checkError, so the error is kept local.
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t applied = 0;
+    rs_error *error = NULL;
+    rs_set_device_options(rs_device_, pending_options_.data(), pending_options_.size(), pending_values_.data(),
+        &error);
+    if (error)
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - Batched camera option update failed: "
+          << rs_get_error_message(error) << "; setting the options one at a time");
+      rs_free_error(error);
+
+      for (size_t i = 0; i < pending_options_.size(); ++i)
+      {
+        error = NULL;
+        rs_set_device_option(rs_device_, pending_options_[i], pending_values_[i], &error);
+        if (error)
+        {
+          ROS_WARN_STREAM(nodelet_name_ << " - Failed to set camera option "
+              << rs_option_to_string(pending_options_[i]) << ": " << rs_get_error_message(error));
+          rs_free_error(error);
+          applied_options_.erase(pending_options_[i]);
+          continue;
+        }
+        applied_options_[pending_options_[i]] = pending_values_[i];
+        updateCachedOption(pending_options_[i], pending_values_[i]);
+        applied++;
+      }
+    }
+    else
+    {
+      for (size_t i = 0; i < pending_options_.size(); ++i)
+      {
+        applied_options_[pending_options_[i]] = pending_values_[i];
+        updateCachedOption(pending_options_[i], pending_values_[i]);
+      }
+      applied = pending_options_.size();
+    }
+
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    ROS_INFO_STREAM(nodelet_name_ << " - Applied " << applied << " of " << pending_options_.size()
+        << " changed camera options in " << elapsed_ms << " ms");
+
+    pending_options_.clear();
+    pending_values_.clear();
+  }
+
+  /*
+  * Set up the callbacks for the camera streams
+  */
+  void BaseNodelet::setFrameCallbacks()
+  {
+    depth_frame_handler_ = [&](rs::frame frame)  // NOLINT(build/c++11)
+    {
+      queueFrame(RS_STREAM_DEPTH, frame);
+    };
+
+    color_frame_handler_ = [&](rs::frame frame)  // NOLINT(build/c++11)
+    {
+      queueFrame(RS_STREAM_COLOR, frame);
+    };
 
     ir_frame_handler_ = [&](rs::frame frame)  // NOLINT(build/c++11)
     {
-      publishStreamTopic(RS_STREAM_INFRARED, frame);
+      queueFrame(RS_STREAM_INFRARED, frame);
     };
 
     rs_set_frame_callback_cpp(rs_device_, RS_STREAM_DEPTH, new rs::frame_callback(depth_frame_handler_), &rs_error_);
@@ -599,7 +1223,7 @@ namespace realsense_camera
     // Need to add this check due to a bug in librealsense which calls the IR callback
     // if INFRARED stream is disable AND INFRARED2 stream is enabled
     // https://github.com/IntelRealSense/librealsense/issues/393
-    if (enable_[RS_STREAM_INFRARED])
+    if (rs_is_stream_enabled(rs_device_, RS_STREAM_INFRARED, 0) == 1)
     {
       rs_set_frame_callback_cpp(rs_device_, RS_STREAM_INFRARED, new rs::frame_callback(ir_frame_handler_), &rs_error_);
       checkError();
@@ -614,17 +1238,143 @@ namespace realsense_camera
     // Enable streams
     for (int stream=0; stream < STREAM_COUNT; stream++)
     {
-      if (enable_[stream] == true)
+      if (isStreamWanted(stream) == true)
       {
         enableStream(static_cast<rs_stream>(stream), width_[stream], height_[stream], format_[stream], fps_[stream]);
       }
-      else if (enable_[stream] == false)
+      else
       {
         disableStream(static_cast<rs_stream>(stream));
       }
     }
   }
 
+  /*
+   * Request a new resolution and frame rate for a stream from dynamic reconfigure. The
+   * camera restarts at most once per reconfigure, in setDepthEnable, for every profile
+   * changed before it. The infrared streams follow the depth profile. A profile the camera
+   * does not support is rejected and the current one written back.
+   */
+  void BaseNodelet::setStreamProfile(rs_stream stream_index, int &width, int &height, int &fps)
+  {
+    std::unique_lock<std::mutex> lock(stream_mutex_);
+    if (width == width_[stream_index] && height == height_[stream_index] && fps == fps_[stream_index])
+    {
+      return;
+    }
+
+    if (mode_.compare("manual") != 0)
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - " << STREAM_DESC[stream_index] << " profile " << width << "x" << height
+          << " at " << fps << " fps is used only in manual mode");
+    }
+    else if (isStreamModeSupported(stream_index, width, height, fps) == false)
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - " << STREAM_DESC[stream_index] << " does not support " << width << "x"
+          << height << " at " << fps << " fps; keeping " << width_[stream_index] << "x" << height_[stream_index]
+          << " at " << fps_[stream_index] << " fps");
+      width = width_[stream_index];
+      height = height_[stream_index];
+      fps = fps_[stream_index];
+      return;
+    }
+    else
+    {
+      ROS_INFO_STREAM(nodelet_name_ << " - Switching " << STREAM_DESC[stream_index] << " to " << width << "x"
+          << height << " at " << fps << " fps");
+      profile_changed_[stream_index] = true;
+    }
+
+    width_[stream_index] = width;
+    height_[stream_index] = height;
+    fps_[stream_index] = fps;
+    if (stream_index == RS_STREAM_DEPTH)
+    {
+      width_[RS_STREAM_INFRARED] = width;
+      height_[RS_STREAM_INFRARED] = height;
+      fps_[RS_STREAM_INFRARED] = fps;
+      profile_changed_[RS_STREAM_INFRARED] = profile_changed_[RS_STREAM_DEPTH];
+    }
+  }
+
+  /*
+   * Check the camera modes for one with the stream format and the given profile.
+   */
+  bool BaseNodelet::isStreamModeSupported(rs_stream stream_index, int width, int height, int fps)
+  {
+    int count = rs_get_stream_mode_count(rs_device_, stream_index, &rs_error_);
+    checkError();
+    for (int i = 0; i < count; i++)
+    {
+      int mode_width, mode_height, mode_fps;
+      rs_format mode_format;
+      rs_get_stream_mode(rs_device_, stream_index, i, &mode_width, &mode_height, &mode_format, &mode_fps, &rs_error_);
+      checkError();
+      if (mode_width == width && mode_height == height && mode_fps == fps && mode_format == format_[stream_index])
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /*
+   * Restart the camera with the current stream flags and profiles; the caller holds
+   * stream_mutex_. Streams whose profile changed get their calibration, camera_info and
+   * image pool rebuilt while the camera is stopped, and their first frame is timed.
+   */
+  void BaseNodelet::restartStreams()
+  {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    profile_switch_start_ = start;
+    first_frame_event_ = "profile switch";
+    stopCamera();
+
+    bool switched = false;
+    {
+      // Keep the publisher threads out while the calibration and pools change, and drop the
+      // frames queued before the stop; their timestamps belong to the old clock models.
+      std::vector<std::unique_lock<std::mutex>> frame_locks = lockFrames();
+      flushFrameQueues();
+
+      for (int stream = 0; stream < STREAM_COUNT; stream++)
+      {
+        if (profile_changed_[stream] == true)
+        {
+          // enableStream sets a stream up again only when it is disabled and has no camera_info
+          disableStream(static_cast<rs_stream>(stream));
+          camera_info_ptr_[stream].reset();
+          profile_changed_[stream] = false;
+          awaiting_first_frame_[stream] = isStreamWanted(stream);
+          switched = true;
+        }
+      }
+      setStreams();
+    }
+
+    if (switched == true)
+    {
+      profile_switches_++;
+    }
+    startCamera();
+
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    restart_ms_ = elapsed_ms;
+    ROS_INFO_STREAM(nodelet_name_ << " - Restarted the camera in " << elapsed_ms << " ms");
+  }
+
+  /*
+   * Report the time from the nodelet start or a profile switch to the first frame of a stream.
+   */
+  void BaseNodelet::reportFirstFrame(rs_stream stream_index)
+  {
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+        profile_switch_start_).count();
+    first_frame_ms_[stream_index] = elapsed_ms;
+    ROS_INFO_STREAM(nodelet_name_ << " - First " << STREAM_DESC[stream_index] << " frame "
+        << elapsed_ms << " ms after the " << first_frame_event_);
+  }
+
   /*
    * Enable individual streams.
    */
@@ -650,6 +1400,9 @@ namespace realsense_camera
       // Allocate image resources
       getStreamCalibData(stream_index);
       step_[stream_index] = camera_info_ptr_[stream_index]->width * unit_step_size_[stream_index];
+      image_pool_[stream_index].configure(camera_info_ptr_[stream_index]->width,
+          camera_info_ptr_[stream_index]->height, step_[stream_index], encoding_[stream_index],
+          static_cast<size_t>(image_pool_max_mb_) * 1024 * 1024);
     }
     ts_[stream_index] = -1;
   }
@@ -666,6 +1419,7 @@ namespace realsense_camera
       ROS_ERROR_STREAM(nodelet_name_ << " - Verify camera firmware version and/or calibration data!");
     }
     checkError();
+    intrinsics_[stream_index] = intrinsic;
 
     sensor_msgs::CameraInfo * camera_info = new sensor_msgs::CameraInfo();
     camera_info_ptr_[stream_index] = sensor_msgs::CameraInfoPtr(camera_info);
@@ -727,6 +1481,11 @@ namespace realsense_camera
     {
       camera_info->D.push_back(intrinsic.coeffs[i]);
     }
+
+    if (stream_index == RS_STREAM_DEPTH && enable_pointcloud_ == true)
+    {
+      makeDepthRayTable(intrinsic, depth_ray_table_);
+    }
   }
 
   /*
@@ -749,7 +1508,28 @@ namespace realsense_camera
   {
     if (rs_is_device_streaming(rs_device_, 0) == 0)
     {
+      bool has_stream = false;
+      for (int stream = 0; stream < STREAM_COUNT; stream++)
+      {
+        has_stream = has_stream || (rs_is_stream_enabled(rs_device_, static_cast<rs_stream>(stream), 0) == 1);
+      }
+      if (has_stream == false)
+      {
+        return "Camera is idle until a stream has subscribers";
+      }
+
       ROS_INFO_STREAM(nodelet_name_ << " - Starting camera");
+      {
+        // The publisher threads may still be draining frames queued before a stop.
+        std::vector<std::unique_lock<std::mutex>> frame_locks = lockFrames();
+        cacheDepthScale();
+        setupDecimation();
+        setupColorConversion();
+        setupRegistration();
+        setupFrameset();
+        // Device timestamps restart with the streams.
+        resetClockModels();
+      }
       // Set up the callbacks for each stream
       setFrameCallbacks();
       try
@@ -790,7 +1570,26 @@ namespace realsense_camera
   }
 
   /*
-   * Set depth enable
+   * Read the device depth scale once per stream start instead of on every frame.
+   */
+  void BaseNodelet::cacheDepthScale()
+  {
+    if (enable_[RS_STREAM_DEPTH] == true)
+    {
+      depth_scale_meters_ = rs_get_device_depth_scale(rs_device_, &rs_error_);
+      checkError();
+      depth_scale_factor_ = makeDepthScaleFactor(static_cast<double>(depth_scale_meters_) /
+          static_cast<double>(MILLIMETER_METERS));
+      if (depth_scale_meters_ != MILLIMETER_METERS)
+      {
+        ROS_INFO_STREAM(nodelet_name_ << " - Scaling depth to millimeters using "
+            << getInstructionSetName() << " kernel");
+      }
+    }
+  }
+
+  /*
+   * Set depth enable, and restart the camera for it or for the pending stream profiles.
    */
   void BaseNodelet::setDepthEnable(bool &enable_depth)
   {
@@ -812,300 +1611,1160 @@ namespace realsense_camera
       enable_[RS_STREAM_DEPTH] = true;
     }
 
-    if (enable_[RS_STREAM_DEPTH] != rs_is_stream_enabled(rs_device_, RS_STREAM_DEPTH, 0))
+    std::unique_lock<std::mutex> lock(stream_mutex_);
+    bool restart = (isStreamWanted(RS_STREAM_DEPTH) != rs_is_stream_enabled(rs_device_, RS_STREAM_DEPTH, 0));
+    for (int stream = 0; stream < STREAM_COUNT; stream++)
     {
-      stopCamera();
-      setStreams();
-      startCamera();
+      restart = restart || profile_changed_[stream];
+    }
+    if (restart == true)
+    {
+      restartStreams();
     }
   }
 
   /*
-   * Determine the timestamp for the publish topic.
+   * Determine the timestamp for the publish topic, through the clock model of the stream.
    */
   ros::Time BaseNodelet::getTimestamp(rs_stream stream_index, double frame_ts)
   {
-    return ros::Time(camera_start_ts_) + ros::Duration(frame_ts * 0.001);
+    return toHostTime(getClockModel(stream_index), frame_ts);
   }
 
   /*
-   * Publish native stream topic.
+   * Return the clock model of the clock that stamps a stream. Each timestamp domain needs its
+   * own model, as one fit over two clocks would be neither. The streams of the camera share its
+   * clock; cameras with streams stamped by another clock override this.
    */
-  void BaseNodelet::publishStreamTopic(rs_stream stream_index, rs::frame &frame) try
+  DeviceClockModel &BaseNodelet::getClockModel(rs_stream stream_index)
   {
-    // mutex to ensure only one frame per stream is processed at a time
-    std::unique_lock<std::mutex> lock(frame_mutex_[stream_index]);
+    return clock_model_;
+  }
 
-    double frame_ts = frame.get_timestamp();
-    if (ts_[stream_index] != frame_ts)  // Publish frames only if its not duplicate
-    {
-      cv::Mat image_mat = cv::Mat(camera_info_ptr_[stream_index]->height,
-                camera_info_ptr_[stream_index]->width, cv_type_[stream_index], cv::Scalar(0, 0, 0));
-      image_mat.data = (unsigned char *) (frame.get_data());
-      if (stream_index == RS_STREAM_DEPTH)
-      {
-        float depth_scale_meters = rs_get_device_depth_scale(rs_device_, &rs_error_);
-        if (depth_scale_meters != MILLIMETER_METERS) // if depth is not in mm
-        {
-          // scale depth to mm
-          image_mat.convertTo(image_mat,
-                           cv_type_[stream_index],
-                           static_cast<double>(depth_scale_meters) / static_cast<double>(MILLIMETER_METERS));
-        }
-        if (min_depth_pub_.getNumSubscribers() > 0)
-        {
-          std_msgs::UInt16 min_depth;
-          min_depth.data = 65535;
-          cv::MatConstIterator_<uint16_t> it = image_mat.begin<uint16_t>();
-          cv::MatConstIterator_<uint16_t> it_end = image_mat.end<uint16_t>();
-          for (; it != it_end; ++it)
-          {
-            if ((*it < min_depth.data) && (*it > 0))
-            {
-              min_depth.data = *it;
-            }
-          }
-          min_depth_pub_.publish(min_depth);
-        }
-      }
+  /*
+   * Restart the clock models, applying the configured window and outlier limit.
+   */
+  void BaseNodelet::resetClockModels()
+  {
+    std::unique_lock<std::mutex> lock(clock_mutex_);
+    clock_model_.configure(clock_sync_window_, clock_sync_outlier_ms_);
+  }
 
-      // Publish stream only if there is at least one subscriber.
-      if (camera_publisher_[stream_index].getNumSubscribers() > 0)
+  /*
+   * Map a device timestamp in ms to host time through its clock model. Without clock
+   * synchronization, or before the first arrival, the device time is offset by the start time.
+   */
+  ros::Time BaseNodelet::toHostTime(const DeviceClockModel &model, double device_ms)
+  {
+    if (enable_clock_sync_)
+    {
+      std::unique_lock<std::mutex> lock(clock_mutex_);
+      if (model.isValid())
       {
-        sensor_msgs::ImagePtr msg = cv_bridge::CvImage(std_msgs::Header(),
-                                                       encoding_[stream_index],
-                                                       image_mat).toImageMsg();
-        msg->header.frame_id = optical_frame_id_[stream_index];
-        // Publish timestamp to synchronize frames.
-        msg->header.stamp = getTimestamp(stream_index, frame_ts);
-        msg->width = image_mat.cols;
-        msg->height = image_mat.rows;
-        msg->is_bigendian = false;
-        msg->step = step_[stream_index];
-        camera_info_ptr_[stream_index]->header.stamp = msg->header.stamp;
-        camera_publisher_[stream_index].publish(msg, camera_info_ptr_[stream_index]);
+        return ros::Time(model.toHost(device_ms));
       }
     }
-    ts_[stream_index] = frame_ts;
-  }
-  catch(const rs::error & e)
-  {
-    ROS_ERROR_STREAM(nodelet_name_ << " - " << "RealSense error calling "
-        << e.get_failed_function() << "(" << e.get_failed_args() << "):\n    "
-        << e.what());
-    ros::shutdown();
-  }
-  catch(const std::exception & e)
-  {
-    ROS_ERROR_STREAM(nodelet_name_ << " - " << e.what());
-    ros::shutdown();
-  }
-  catch(...)
-  {
-    ROS_ERROR_STREAM(nodelet_name_ << " - Caught unknown exception...shutting down!");
-    ros::shutdown();
+    return ros::Time(camera_start_ts_) + ros::Duration(device_ms * 0.001);
   }
 
   /*
-   * Get the camera extrinsics
+   * Start one publisher thread per stream to drain the frame queues.
    */
-  void BaseNodelet::getCameraExtrinsics()
+  void BaseNodelet::startFrameWorkers()
   {
-    // Get offset between base frame and depth frame
-    rs_get_device_extrinsics(rs_device_, RS_STREAM_DEPTH, RS_STREAM_COLOR, &color2depth_extrinsic_, &rs_error_);
-    if (rs_error_)
+    frame_workers_running_ = true;
+    for (int stream = 0; stream < STREAM_COUNT; stream++)
     {
-      ROS_ERROR_STREAM(nodelet_name_ << " - Verify camera is calibrated!");
+      frame_queue_[stream].ring.reset(frame_queue_size_);
+      frame_worker_[stream] = std::thread(&BaseNodelet::processFrames, this, static_cast<rs_stream>(stream));
     }
-    checkError();
+  }
 
-    // Get offset between base frame and infrared frame
-    rs_get_device_extrinsics(rs_device_, RS_STREAM_INFRARED, RS_STREAM_COLOR, &color2ir_extrinsic_, &rs_error_);
-    if (rs_error_)
+  /*
+   * Stop the publisher threads and release the frames still queued.
+   */
+  void BaseNodelet::stopFrameWorkers()
+  {
+    frame_workers_running_ = false;
+    for (int stream = 0; stream < STREAM_COUNT; stream++)
     {
-      ROS_ERROR_STREAM(nodelet_name_ << " - Verify camera is calibrated!");
+      frame_queue_[stream].ring.wake();
+      if (frame_worker_[stream].joinable())
+      {
+        frame_worker_[stream].join();
+      }
+      QueuedFrame queued;
+      while (frame_queue_[stream].ring.pop(queued))
+      {
+        frame_queue_[stream].dropped++;
+      }
     }
-    checkError();
   }
 
   /*
-   * Publish Static transforms.
+   * Lock the frame mutexes of all streams, which keeps the publisher threads out of publishStreamTopic.
    */
-  void BaseNodelet::publishStaticTransforms()
+  std::vector<std::unique_lock<std::mutex>> BaseNodelet::lockFrames()
   {
-    // Publish transforms for the cameras
-    ROS_INFO_STREAM(nodelet_name_ << " - Publishing camera transforms (/tf_static)");
-
-    tf::Quaternion q_c2co;
-    tf::Quaternion q_d2do;
-    tf::Quaternion q_i2io;
-    geometry_msgs::TransformStamped b2d_msg;
-    geometry_msgs::TransformStamped d2do_msg;
-    geometry_msgs::TransformStamped b2c_msg;
-    geometry_msgs::TransformStamped c2co_msg;
-    geometry_msgs::TransformStamped b2i_msg;
-    geometry_msgs::TransformStamped i2io_msg;
-
-    // Get the current timestamp for all static transforms
-    transform_ts_ = ros::Time::now();
-
-    // The color frame is used as the base frame.
-    // Hence no additional transformation is done from base frame to color frame.
-    b2c_msg.header.stamp = transform_ts_;
-    b2c_msg.header.frame_id = base_frame_id_;
-    b2c_msg.child_frame_id = frame_id_[RS_STREAM_COLOR];
-    b2c_msg.transform.translation.x = 0;
-    b2c_msg.transform.translation.y = 0;
-    b2c_msg.transform.translation.z = 0;
-    b2c_msg.transform.rotation.x = 0;
-    b2c_msg.transform.rotation.y = 0;
-    b2c_msg.transform.rotation.z = 0;
-    b2c_msg.transform.rotation.w = 1;
-    static_tf_broadcaster_.sendTransform(b2c_msg);
-
-    // Transform color frame to color optical frame
-    q_c2co.setRPY(-M_PI/2, 0.0, -M_PI/2);
-    c2co_msg.header.stamp = transform_ts_;
-    c2co_msg.header.frame_id = frame_id_[RS_STREAM_COLOR];
-    c2co_msg.child_frame_id = optical_frame_id_[RS_STREAM_COLOR];
-    c2co_msg.transform.translation.x = 0;
-    c2co_msg.transform.translation.y = 0;
-    c2co_msg.transform.translation.z = 0;
-    c2co_msg.transform.rotation.x = q_c2co.getX();
-    c2co_msg.transform.rotation.y = q_c2co.getY();
-    c2co_msg.transform.rotation.z = q_c2co.getZ();
-    c2co_msg.transform.rotation.w = q_c2co.getW();
-    static_tf_broadcaster_.sendTransform(c2co_msg);
-
-    // Transform base frame to depth frame
-    b2d_msg.header.stamp = transform_ts_;
-    b2d_msg.header.frame_id = base_frame_id_;
-    b2d_msg.child_frame_id = frame_id_[RS_STREAM_DEPTH];
-    b2d_msg.transform.translation.x =  color2depth_extrinsic_.translation[2];
-    b2d_msg.transform.translation.y = -color2depth_extrinsic_.translation[0];
-    b2d_msg.transform.translation.z = -color2depth_extrinsic_.translation[1];
-    b2d_msg.transform.rotation.x = 0;
-    b2d_msg.transform.rotation.y = 0;
-    b2d_msg.transform.rotation.z = 0;
-    b2d_msg.transform.rotation.w = 1;
-    static_tf_broadcaster_.sendTransform(b2d_msg);
-
-    // Transform depth frame to depth optical frame
-    q_d2do.setRPY(-M_PI/2, 0.0, -M_PI/2);
-    d2do_msg.header.stamp = transform_ts_;
-    d2do_msg.header.frame_id = frame_id_[RS_STREAM_DEPTH];
-    d2do_msg.child_frame_id = optical_frame_id_[RS_STREAM_DEPTH];
-    d2do_msg.transform.translation.x = 0;
-    d2do_msg.transform.translation.y = 0;
-    d2do_msg.transform.translation.z = 0;
-    d2do_msg.transform.rotation.x = q_d2do.getX();
-    d2do_msg.transform.rotation.y = q_d2do.getY();
-    d2do_msg.transform.rotation.z = q_d2do.getZ();
-    d2do_msg.transform.rotation.w = q_d2do.getW();
-    static_tf_broadcaster_.sendTransform(d2do_msg);
-
-    // Transform base frame to infrared frame
-    b2i_msg.header.stamp = transform_ts_;
-    b2i_msg.header.frame_id = base_frame_id_;
-    b2i_msg.child_frame_id = frame_id_[RS_STREAM_INFRARED];
-    b2i_msg.transform.translation.x =  color2ir_extrinsic_.translation[2];
-    b2i_msg.transform.translation.y = -color2ir_extrinsic_.translation[0];
-    b2i_msg.transform.translation.z = -color2ir_extrinsic_.translation[1];
-    b2i_msg.transform.rotation.x = 0;
-    b2i_msg.transform.rotation.y = 0;
-    b2i_msg.transform.rotation.z = 0;
-    b2i_msg.transform.rotation.w = 1;
-    static_tf_broadcaster_.sendTransform(b2i_msg);
-
-    // Transform infrared frame to infrared optical frame
-    q_i2io.setRPY(-M_PI/2, 0.0, -M_PI/2);
-    i2io_msg.header.stamp = transform_ts_;
-    i2io_msg.header.frame_id = frame_id_[RS_STREAM_INFRARED];
-    i2io_msg.child_frame_id = optical_frame_id_[RS_STREAM_INFRARED];
-    i2io_msg.transform.translation.x = 0;
-    i2io_msg.transform.translation.y = 0;
-    i2io_msg.transform.translation.z = 0;
-    i2io_msg.transform.rotation.x = q_i2io.getX();
-    i2io_msg.transform.rotation.y = q_i2io.getY();
-    i2io_msg.transform.rotation.z = q_i2io.getZ();
-    i2io_msg.transform.rotation.w = q_i2io.getW();
-    static_tf_broadcaster_.sendTransform(i2io_msg);
+    std::vector<std::unique_lock<std::mutex>> frame_locks;
+    for (int stream = 0; stream < STREAM_COUNT; stream++)
+    {
+      frame_locks.emplace_back(frame_mutex_[stream]);
+    }
+    return frame_locks;
   }
 
   /*
-   * Publish Dynamic transforms.
+   * Drop the queued frames of all streams; the camera is stopped, so no new ones arrive.
    */
-  void BaseNodelet::publishDynamicTransforms()
+  void BaseNodelet::flushFrameQueues()
   {
-    tf::Transform tr;
-    tf::Quaternion q;
-
-    // The color frame is used as the base frame.
-    // Hence no additional transformation is done from base frame to color frame.
-    tr.setOrigin(tf::Vector3(0, 0, 0));
-    tr.setRotation(tf::Quaternion(0, 0, 0, 1));
-    dynamic_tf_broadcaster_.sendTransform(tf::StampedTransform(tr, transform_ts_,
-          base_frame_id_, frame_id_[RS_STREAM_COLOR]));
-
-    // Transform color frame to color optical frame
-    tr.setOrigin(tf::Vector3(0, 0, 0));
-    q.setRPY(-M_PI/2, 0.0, -M_PI/2);
-    tr.setRotation(q);
-    dynamic_tf_broadcaster_.sendTransform(tf::StampedTransform(tr, transform_ts_,
-          frame_id_[RS_STREAM_COLOR], optical_frame_id_[RS_STREAM_COLOR]));
-
-    // Transform base frame to depth frame
-    tr.setOrigin(tf::Vector3(
-           color2depth_extrinsic_.translation[2],
-          -color2depth_extrinsic_.translation[0],
-          -color2depth_extrinsic_.translation[1]));
-    tr.setRotation(tf::Quaternion(0, 0, 0, 1));
-    dynamic_tf_broadcaster_.sendTransform(tf::StampedTransform(tr, transform_ts_,
-          base_frame_id_, frame_id_[RS_STREAM_DEPTH]));
-
-    // Transform depth frame to depth optical frame
-    tr.setOrigin(tf::Vector3(0, 0, 0));
-    q.setRPY(-M_PI/2, 0.0, -M_PI/2);
-    tr.setRotation(q);
-    dynamic_tf_broadcaster_.sendTransform(tf::StampedTransform(tr, transform_ts_,
-          frame_id_[RS_STREAM_DEPTH], optical_frame_id_[RS_STREAM_DEPTH]));
-
-    // Transform base frame to infrared frame
-    tr.setOrigin(tf::Vector3(
-           color2ir_extrinsic_.translation[2],
-          -color2ir_extrinsic_.translation[0],
-          -color2ir_extrinsic_.translation[1]));
-    tr.setRotation(tf::Quaternion(0, 0, 0, 1));
-    dynamic_tf_broadcaster_.sendTransform(tf::StampedTransform(tr, transform_ts_,
-          base_frame_id_, frame_id_[RS_STREAM_INFRARED]));
-
-    // Transform infrared frame to infrared optical frame
-    tr.setOrigin(tf::Vector3(0, 0, 0));
-    q.setRPY(-M_PI/2, 0.0, -M_PI/2);
-    tr.setRotation(q);
-    dynamic_tf_broadcaster_.sendTransform(tf::StampedTransform(tr, transform_ts_,
-          frame_id_[RS_STREAM_INFRARED], optical_frame_id_[RS_STREAM_INFRARED]));
+    for (int stream = 0; stream < STREAM_COUNT; stream++)
+    {
+      QueuedFrame queued;
+      while (frame_queue_[stream].ring.pop(queued))
+      {
+        frame_queue_[stream].dropped++;
+      }
+    }
   }
 
   /*
-   * Prepare transforms.
+   * Hand a frame from the librealsense callback to its stream queue, applying the drop policy when full.
    */
-  void BaseNodelet::prepareTransforms()
+  void BaseNodelet::queueFrame(rs_stream stream_index, rs::frame &frame)
   {
-    // Publish transforms for the cameras
-    ROS_INFO_STREAM(nodelet_name_ << " - Publishing camera transforms (/tf)");
-
-    ros::Rate loop_rate(1);
+    if (enable_clock_sync_)
+    {
+      // Pair the device timestamp with its arrival before any queueing delay. The earliest
+      // arrival of each interval is kept, whichever stream of the clock delivered it.
+      ros::Time arrival = ros::Time::now();
+      std::unique_lock<std::mutex> lock(clock_mutex_);
+      getClockModel(stream_index).addSample(frame.get_timestamp(), arrival.toSec());
+    }
 
-    while (ros::ok())
+    if (awaiting_first_frame_[stream_index].load(std::memory_order_relaxed) &&
+        awaiting_first_frame_[stream_index].exchange(false))
     {
-      // update the time stamp for publication
-      transform_ts_ = ros::Time::now();
+      reportFirstFrame(stream_index);
+    }
 
-      publishDynamicTransforms();
+    FrameQueue &queue = frame_queue_[stream_index];
+    QueuedFrame queued;
+    queued.frame = std::move(frame);
+    queued.enqueue_time = std::chrono::steady_clock::now();
 
-      loop_rate.sleep();
+    if (queue.ring.push(std::move(queued)))
+    {
+      queue.enqueued++;
+      return;
+    }
+
+    if (frame_drop_policy_ != FRAME_DROP_NEWEST)
+    {
+      // Make room by discarding the oldest queued frame.
+      QueuedFrame oldest;
+      if (queue.ring.pop(oldest))
+      {
+        queue.dropped++;
+      }
+      if (queue.ring.push(std::move(queued)))
+      {
+        queue.enqueued++;
+        return;
+      }
+    }
+    queue.dropped++;
+  }
+
+  /*
+   * Publisher thread body: drain the stream queue until the workers are stopped.
+   */
+  void BaseNodelet::processFrames(rs_stream stream_index)
+  {
+    FrameQueue &queue = frame_queue_[stream_index];
+    const std::chrono::milliseconds timeout(FRAME_WORKER_TIMEOUT_MS);
+    const std::chrono::duration<double, std::milli> max_age(frame_max_age_ms_);
+    bool check_age = (frame_drop_policy_ == FRAME_DROP_MAX_AGE);
+    QueuedFrame queued;
+
+    while (frame_workers_running_)
+    {
+      if (queue.ring.pop(queued) == false)
+      {
+        queue.ring.wait(timeout);
+        continue;
+      }
+
+      if (check_age && (std::chrono::steady_clock::now() - queued.enqueue_time) > max_age)
+      {
+        queue.dropped++;
+      }
+      else
+      {
+        publishStreamTopic(stream_index, queued.frame);
+        queue.published++;
+      }
+      // Return the frame buffer to librealsense before waiting for the next one.
+      queued.frame = rs::frame();
+    }
+  }
+
+  /*
+   * Publish native stream topic.
+   */
+  void BaseNodelet::publishStreamTopic(rs_stream stream_index, rs::frame &frame) try
+  {
+    // mutex to ensure only one frame per stream is processed at a time
+    std::unique_lock<std::mutex> lock(frame_mutex_[stream_index]);
+
+    double frame_ts = frame.get_timestamp();
+    if (camera_info_ptr_[stream_index] == NULL ||
+        static_cast<uint32_t>(frame.get_width()) != camera_info_ptr_[stream_index]->width ||
+        static_cast<uint32_t>(frame.get_height()) != camera_info_ptr_[stream_index]->height)
+    {
+      // Queued before a profile switch; the image pool no longer matches it.
+      return;
+    }
+    if (ts_[stream_index] != frame_ts)  // Publish frames only if its not duplicate
+    {
+      bool publish_image = image_demand_[stream_index].load(std::memory_order_relaxed);
+      bool publish_min_depth = (stream_index == RS_STREAM_DEPTH && min_depth_demand_.load(std::memory_order_relaxed));
+      bool publish_stats = (stream_index == RS_STREAM_DEPTH && depth_stats_demand_.load(std::memory_order_relaxed));
+      bool publish_cloud = (stream_index == RS_STREAM_DEPTH && pointcloud_demand_.load(std::memory_order_relaxed));
+      bool publish_decimated = (stream_index == RS_STREAM_DEPTH &&
+          decimated_depth_demand_.load(std::memory_order_relaxed));
+      bool publish_compressed = (stream_index == RS_STREAM_DEPTH &&
+          compressed_depth_demand_.load(std::memory_order_relaxed));
+      bool publish_registered = (stream_index == RS_STREAM_DEPTH &&
+          (registered_depth_demand_.load(std::memory_order_relaxed) ||
+          registered_color_demand_.load(std::memory_order_relaxed)));
+      bool keep_color = (stream_index == RS_STREAM_COLOR && registered_color_demand_.load(std::memory_order_relaxed));
+      bool publish_converted = (stream_index == RS_STREAM_COLOR &&
+          (converted_color_demand_.load(std::memory_order_relaxed) ||
+          mono_color_demand_.load(std::memory_order_relaxed)));
+      bool publish_frameset = frameset_demand_.load(std::memory_order_relaxed);
+      bool publish_aggregated = aggregator_demand_[stream_index].load(std::memory_order_relaxed);
+
+      if (publish_image || publish_min_depth || publish_stats || publish_cloud || publish_decimated ||
+          publish_compressed || publish_registered || keep_color || publish_converted || publish_frameset ||
+          publish_aggregated)
+      {
+        // Write the frame once into a recycled message; it is handed to intra-process
+        // subscribers as a shared pointer without further copies.
+        sensor_msgs::ImagePtr msg = image_pool_[stream_index].acquire();
+        copyFrameToImage(frame.get_data(), step_[stream_index], *msg);
+        msg->header.frame_id = optical_frame_id_[stream_index];
+        // Publish timestamp to synchronize frames.
+        msg->header.stamp = getTimestamp(stream_index, frame_ts);
+
+        if (stream_index == RS_STREAM_DEPTH)
+        {
+          // the filters work in mm and rescale the depth first when any of them is enabled
+          bool scaled = filterDepth(*msg);
+
+          if (publish_min_depth || publish_stats)
+          {
+            // scaling to mm, if needed, is fused with the statistics pass
+            publishDepthStatistics(*msg, !scaled, publish_min_depth, publish_stats);
+          }
+          else if (!scaled && depth_scale_meters_ != MILLIMETER_METERS)  // if depth is not in mm
+          {
+            // scale depth to mm in place on the outgoing buffer
+            scaleDepth(reinterpret_cast<uint16_t *>(msg->data.data()), msg->data.size() / sizeof(uint16_t),
+                depth_scale_factor_);
+          }
+
+          if (publish_cloud)
+          {
+            publishPointCloud(*msg);
+          }
+
+          if (publish_decimated)
+          {
+            publishDecimatedDepth(*msg);
+          }
+
+          if (publish_compressed)
+          {
+            publishCompressedDepth(*msg);
+          }
+
+          if (publish_registered)
+          {
+            publishRegisteredImages(*msg);
+          }
+        }
+        else if (publish_converted || (keep_color && format_[RS_STREAM_COLOR] == RS_FORMAT_YUYV))
+        {
+          // YUYV color is registered after conversion, which then runs once for both uses.
+          publishConvertedColor(*msg, keep_color);
+        }
+        else if (keep_color)
+        {
+          // Color is registered to depth when the next depth frame arrives.
+          std::unique_lock<std::mutex> color_lock(latest_color_mutex_);
+          latest_color_image_ = msg;
+        }
+
+        // Every consumer shares the one camera info of this frame.
+        sensor_msgs::CameraInfoConstPtr frame_info;
+        if (publish_image || publish_frameset || publish_aggregated)
+        {
+          frame_info = stampCameraInfo(*camera_info_ptr_[stream_index], msg->header.stamp);
+        }
+
+        if (publish_frameset)
+        {
+          publishFrameset(stream_index, msg, frame_info);
+        }
+
+        if (publish_aggregated)
+        {
+          publishToAggregators(stream_index, msg, frame_info);
+        }
+
+        // Publish stream only if there is at least one subscriber.
+        if (publish_image)
+        {
+          camera_publisher_[stream_index].publish(msg, frame_info);
+        }
+      }
+    }
+    ts_[stream_index] = frame_ts;
+  }
+  catch(const rs::error & e)
+  {
+    ROS_ERROR_STREAM(nodelet_name_ << " - " << "RealSense error calling "
+        << e.get_failed_function() << "(" << e.get_failed_args() << "):\n    "
+        << e.what());
+    ros::shutdown();
+  }
+  catch(const std::exception & e)
+  {
+    ROS_ERROR_STREAM(nodelet_name_ << " - " << e.what());
+    ros::shutdown();
+  }
+  catch(...)
+  {
+    ROS_ERROR_STREAM(nodelet_name_ << " - Caught unknown exception...shutting down!");
+    ros::shutdown();
+  }
+
+  /*
+   * Update the depth filter settings from the dynamic reconfigure callback.
+   */
+  void BaseNodelet::setDepthFilters(const DepthFilterSettings &settings)
+  {
+    std::unique_lock<std::mutex> lock(depth_filter_mutex_);
+    if (settings.enable_temporal && !depth_filter_settings_.enable_temporal)
+    {
+      // do not blend with the average left over from the last time the filter was on
+      reset_temporal_filter_ = true;
+    }
+    depth_filter_settings_ = settings;
+  }
+
+  /*
+   * Run the enabled depth filters in place on the outgoing depth image, in the order
+   * spatial, temporal and hole filling. Returns true when the image was filtered, in which
+   * case it has already been rescaled to mm.
+   */
+  bool BaseNodelet::filterDepth(sensor_msgs::Image &image)
+  {
+    DepthFilterSettings settings;
+    bool reset_temporal;
+    {
+      std::unique_lock<std::mutex> lock(depth_filter_mutex_);
+      settings = depth_filter_settings_;
+      reset_temporal = reset_temporal_filter_;
+      reset_temporal_filter_ = false;
+    }
+    if (!settings.enable_spatial && !settings.enable_temporal && !settings.enable_hole_filling)
+    {
+      return false;
+    }
+
+    uint16_t *depth = reinterpret_cast<uint16_t *>(image.data.data());
+    if (depth_scale_meters_ != MILLIMETER_METERS)
+    {
+      scaleDepth(depth, image.data.size() / sizeof(uint16_t), depth_scale_factor_);
+    }
+
+    if (settings.enable_spatial)
+    {
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      spatialFilterDepth(depth, image.width, image.height, image.step, settings.spatial_alpha,
+          settings.spatial_delta, settings.spatial_iterations, spatial_filter_scratch_);
+      recordFilterTime(spatial_filter_timing_, start);
+    }
+
+    if (settings.enable_temporal)
+    {
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      if (reset_temporal)
+      {
+        temporal_filter_.reset();
+      }
+      temporal_filter_.apply(depth, image.width, image.height, image.step, settings.temporal_alpha,
+          settings.temporal_delta, settings.temporal_persistence);
+      recordFilterTime(temporal_filter_timing_, start);
+    }
+
+    if (settings.enable_hole_filling)
+    {
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      fillDepthHoles(depth, image.width, image.height, image.step, settings.hole_filling_mode,
+          hole_filling_scratch_);
+      recordFilterTime(hole_filling_timing_, start);
+    }
+    return true;
+  }
+
+  /*
+   * Add the time spent in one filter since start to its timing.
+   */
+  void BaseNodelet::recordFilterTime(FilterTiming &timing, std::chrono::steady_clock::time_point start)
+  {
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::unique_lock<std::mutex> lock(depth_filter_mutex_);
+    timing.frames++;
+    timing.total_ms += elapsed_ms;
+    timing.max_ms = std::max(timing.max_ms, elapsed_ms);
+  }
+
+  /*
+   * Scale the depth image to mm if needed and publish its statistics, in a single pass.
+   */
+  void BaseNodelet::publishDepthStatistics(sensor_msgs::Image &image, bool scale, bool publish_min_depth,
+      bool publish_stats)
+  {
+    DepthFrameStatistics stats;
+    computeDepthStatistics(reinterpret_cast<uint16_t *>(image.data.data()), image.data.size() / sizeof(uint16_t),
+        (scale && depth_scale_meters_ != MILLIMETER_METERS) ? &depth_scale_factor_ : NULL, publish_stats, stats);
+
+    if (publish_min_depth)
+    {
+      std_msgs::UInt16 min_depth;
+      min_depth.data = stats.min;
+      min_depth_pub_.publish(min_depth);
+    }
+
+    if (publish_stats)
+    {
+      realsense_camera::DepthStatisticsPtr stats_msg = boost::make_shared<realsense_camera::DepthStatistics>();
+      stats_msg->header = image.header;
+      stats_msg->min = stats.min;
+      stats_msg->max = stats.max;
+      stats_msg->mean = (stats.valid > 0) ? static_cast<float>(stats.sum) / stats.valid : 0.0f;
+      stats_msg->valid_ratio = (stats.count > 0) ? static_cast<float>(stats.valid) / stats.count : 0.0f;
+      stats_msg->histogram_bin_width = 1 << DEPTH_HISTOGRAM_BIN_SHIFT;
+      stats_msg->histogram.assign(stats.histogram, stats.histogram + DEPTH_HISTOGRAM_BINS);
+      depth_stats_pub_.publish(stats_msg);
+    }
+  }
+
+  /*
+   * Deproject the depth image, already in millimeters, to a point cloud using all cores.
+   */
+  void BaseNodelet::publishPointCloud(const sensor_msgs::Image &depth_image)
+  {
+    if (depth_image.width != depth_ray_table_.width || depth_image.height != depth_ray_table_.height)
+    {
+      ROS_WARN_STREAM_THROTTLE(5, nodelet_name_ << " - Depth image size does not match the point cloud ray table");
+      return;
+    }
+
+    sensor_msgs::PointCloud2Ptr cloud = boost::make_shared<sensor_msgs::PointCloud2>();
+    cloud->header = depth_image.header;
+    cloud->fields.resize(3);
+    const char *names[] = {"x", "y", "z"};
+    for (int i = 0; i < 3; i++)
+    {
+      cloud->fields[i].name = names[i];
+      cloud->fields[i].offset = i * sizeof(float);
+      cloud->fields[i].datatype = sensor_msgs::PointField::FLOAT32;
+      cloud->fields[i].count = 1;
+    }
+    cloud->is_bigendian = false;
+    cloud->point_step = POINTCLOUD_POINT_STEP;
+    cloud->data.resize(static_cast<size_t>(depth_image.width) * depth_image.height * POINTCLOUD_POINT_STEP);
+
+    const uint16_t *depth = reinterpret_cast<const uint16_t *>(depth_image.data.data());
+    size_t row_bytes = static_cast<size_t>(depth_image.width) * POINTCLOUD_POINT_STEP;
+    bool organized = organized_pointcloud_;
+    // Point count of each band, stored at the band's first row
+    std::vector<size_t> band_points(depth_image.height, 0);
+
+    worker_pool_->parallelFor(depth_image.height, 8, [&](size_t begin, size_t end)  // NOLINT(build/c++11)
+    {
+      band_points[begin] = deprojectDepth(depth, depth_image.step, depth_ray_table_, begin, end, MILLIMETER_METERS,
+          organized, &cloud->data[begin * row_bytes]);
+    });
+
+    if (organized)
+    {
+      cloud->width = depth_image.width;
+      cloud->height = depth_image.height;
+      cloud->is_dense = false;
+    }
+    else
+    {
+      // Close the gaps between the bands
+      size_t total = 0;
+      for (size_t row = 0; row < band_points.size(); row++)
+      {
+        if (band_points[row] > 0)
+        {
+          memmove(&cloud->data[total * POINTCLOUD_POINT_STEP], &cloud->data[row * row_bytes],
+              band_points[row] * POINTCLOUD_POINT_STEP);
+          total += band_points[row];
+        }
+      }
+      cloud->data.resize(total * POINTCLOUD_POINT_STEP);
+      cloud->width = total;
+      cloud->height = 1;
+      cloud->is_dense = true;
+    }
+    cloud->row_step = cloud->width * POINTCLOUD_POINT_STEP;
+    pointcloud_pub_.publish(cloud);
+  }
+
+  /*
+   * Prepare the decimated depth buffers and the camera info scaled to the decimated resolution.
+   */
+  void BaseNodelet::setupDecimation()
+  {
+    if (rs_is_stream_enabled(rs_device_, RS_STREAM_DEPTH, 0) == 0 || camera_info_ptr_[RS_STREAM_DEPTH] == NULL)
+    {
+      return;
+    }
+
+    sensor_msgs::CameraInfoPtr info = boost::make_shared<sensor_msgs::CameraInfo>(*camera_info_ptr_[RS_STREAM_DEPTH]);
+    double scale = 1.0 / decimation_factor_;
+    info->width = info->width / decimation_factor_;
+    info->height = info->height / decimation_factor_;
+    // Pixel centers move with the block size: c' = (c + 0.5) / factor - 0.5
+    info->K.at(0) *= scale;
+    info->K.at(2) = (info->K.at(2) + 0.5) * scale - 0.5;
+    info->K.at(4) *= scale;
+    info->K.at(5) = (info->K.at(5) + 0.5) * scale - 0.5;
+    info->P.at(0) *= scale;
+    info->P.at(2) = (info->P.at(2) + 0.5) * scale - 0.5;
+    info->P.at(5) *= scale;
+    info->P.at(6) = (info->P.at(6) + 0.5) * scale - 0.5;
+    decimated_depth_info_ptr_ = info;
+
+    decimated_depth_pool_.configure(info->width, info->height, info->width * sizeof(uint16_t),
+        encoding_[RS_STREAM_DEPTH], static_cast<size_t>(image_pool_max_mb_) * 1024 * 1024);
+  }
+
+  /*
+   * Publish the decimated depth image.
+   */
+  void BaseNodelet::publishDecimatedDepth(const sensor_msgs::Image &depth_image)
+  {
+    sensor_msgs::ImagePtr msg = decimated_depth_pool_.acquire();
+    if (msg->width != depth_image.width / decimation_factor_ || msg->height != depth_image.height / decimation_factor_)
+    {
+      return;
+    }
+
+    decimateDepth(reinterpret_cast<const uint16_t *>(depth_image.data.data()), depth_image.width, depth_image.height,
+        depth_image.step, decimation_factor_, decimation_mode_, reinterpret_cast<uint16_t *>(msg->data.data()),
+        msg->step, decimation_scratch_);
+    msg->header = depth_image.header;
+    decimated_depth_publisher_.publish(msg, stampCameraInfo(*decimated_depth_info_ptr_, msg->header.stamp));
+  }
+
+  /*
+   * Encode the depth image losslessly and publish it. The bands of the image are encoded in
+   * parallel on the worker pool into the encoder's reusable buffers, and the message is one
+   * of a few recycled buffers whenever the subscribers have released it.
+   */
+  void BaseNodelet::publishCompressedDepth(const sensor_msgs::Image &depth_image)
+  {
+    sensor_msgs::CompressedImagePtr msg;
+    for (sensor_msgs::CompressedImagePtr &buffer : compressed_depth_buffers_)
+    {
+      if (buffer.use_count() == 1)
+      {
+        msg = buffer;
+        break;
+      }
+    }
+    if (!msg)
+    {
+      msg = boost::make_shared<sensor_msgs::CompressedImage>();
+      if (compressed_depth_buffers_.size() < COMPRESSED_DEPTH_BUFFERS)
+      {
+        compressed_depth_buffers_.push_back(msg);
+      }
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t band_count = depth_encoder_.begin(reinterpret_cast<const uint16_t *>(depth_image.data.data()),
+        depth_image.width, depth_image.height, depth_image.step);
+    worker_pool_->parallelFor(band_count, 1, [&](size_t begin, size_t end)  // NOLINT(build/c++11)
+    {
+      for (size_t band = begin; band < end; band++)
+      {
+        depth_encoder_.encodeBand(band);
+      }
+    });
+    size_t encoded_bytes = depth_encoder_.finish(msg->data);
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    msg->header = depth_image.header;
+    msg->format = DEPTH_CODEC_FORMAT;
+    compressed_depth_pub_.publish(msg);
+
+    std::unique_lock<std::mutex> lock(depth_codec_mutex_);
+    depth_encode_timing_.frames++;
+    depth_encode_timing_.total_ms += elapsed_ms;
+    depth_encode_timing_.max_ms = std::max(depth_encode_timing_.max_ms, elapsed_ms);
+    depth_raw_bytes_ += depth_image.data.size();
+    depth_encoded_bytes_ += encoded_bytes;
+  }
+
+  /*
+   * Prepare the output buffers of the images converted from native YUYV color.
+   */
+  void BaseNodelet::setupColorConversion()
+  {
+    if (format_[RS_STREAM_COLOR] != RS_FORMAT_YUYV || rs_is_stream_enabled(rs_device_, RS_STREAM_COLOR, 0) == 0 ||
+        camera_info_ptr_[RS_STREAM_COLOR] == NULL)
+    {
+      return;
+    }
+
+    const sensor_msgs::CameraInfo &info = *camera_info_ptr_[RS_STREAM_COLOR];
+    size_t pool_cap = static_cast<size_t>(image_pool_max_mb_) * 1024 * 1024;
+    converted_color_pool_.configure(info.width, info.height, info.width * sizeof(unsigned char) * 3,
+        converted_color_encoding_, pool_cap);
+    mono_color_pool_.configure(info.width, info.height, info.width * sizeof(unsigned char),
+        sensor_msgs::image_encodings::MONO8, pool_cap);
+  }
+
+  /*
+   * Convert native YUYV color for the subscribers of the converted topics, and keep the
+   * converted color for registration when requested.
+   */
+  void BaseNodelet::publishConvertedColor(const sensor_msgs::Image &yuyv_image, bool keep_color)
+  {
+    if (mono_color_demand_.load(std::memory_order_relaxed))
+    {
+      sensor_msgs::ImagePtr msg = mono_color_pool_.acquire();
+      if (convertColorImage(yuyv_image, YUYV_TO_MONO8, *msg))
+      {
+        mono_color_publisher_.publish(msg, stampCameraInfo(*camera_info_ptr_[RS_STREAM_COLOR], msg->header.stamp));
+      }
+    }
+
+    bool publish_color = converted_color_demand_.load(std::memory_order_relaxed);
+    if (publish_color || keep_color)
+    {
+      sensor_msgs::ImagePtr msg = converted_color_pool_.acquire();
+      if (convertColorImage(yuyv_image, color_conversion_, *msg) == false)
+      {
+        return;
+      }
+      if (keep_color)
+      {
+        std::unique_lock<std::mutex> color_lock(latest_color_mutex_);
+        latest_color_image_ = msg;
+      }
+      if (publish_color)
+      {
+        converted_color_publisher_.publish(msg,
+            stampCameraInfo(*camera_info_ptr_[RS_STREAM_COLOR], msg->header.stamp));
+      }
+    }
+  }
+
+  /*
+   * Convert a YUYV image into a pooled image of the same size, in bands on the worker pool.
+   */
+  bool BaseNodelet::convertColorImage(const sensor_msgs::Image &yuyv_image, YuyvConversion conversion,
+      sensor_msgs::Image &image)
+  {
+    if (image.width != yuyv_image.width || image.height != yuyv_image.height)
+    {
+      return false;
+    }
+
+    worker_pool_->parallelFor(yuyv_image.height, 8, [&](size_t begin, size_t end)  // NOLINT(build/c++11)
+    {
+      convertYuyv(&yuyv_image.data[begin * yuyv_image.step], yuyv_image.step, yuyv_image.width, end - begin,
+          conversion, &image.data[begin * image.step], image.step);
+    });
+    image.header = yuyv_image.header;
+    return true;
+  }
+
+  /*
+   * Prepare the registration tables and output buffers for the current depth and color calibration.
+   */
+  void BaseNodelet::setupRegistration()
+  {
+    if (enable_registration_ == false || rs_is_stream_enabled(rs_device_, RS_STREAM_DEPTH, 0) == 0 ||
+        rs_is_stream_enabled(rs_device_, RS_STREAM_COLOR, 0) == 0)
+    {
+      return;
+    }
+
+    rs_extrinsics depth_to_color;
+    rs_get_device_extrinsics(rs_device_, RS_STREAM_DEPTH, RS_STREAM_COLOR, &depth_to_color, &rs_error_);
+    if (rs_error_)
+    {
+      ROS_ERROR_STREAM(nodelet_name_ << " - Verify camera is calibrated!");
+    }
+    checkError();
+
+    std::unique_lock<std::mutex> lock(registration_mutex_);
+    registration_.configure(intrinsics_[RS_STREAM_DEPTH], intrinsics_[RS_STREAM_COLOR], depth_to_color);
+
+    // Registered depth has the color geometry and calibration, registered color the depth ones.
+    const rs_intrinsics &depth = intrinsics_[RS_STREAM_DEPTH];
+    const rs_intrinsics &color = intrinsics_[RS_STREAM_COLOR];
+    size_t pool_cap = static_cast<size_t>(image_pool_max_mb_) * 1024 * 1024;
+    registered_depth_pool_.configure(color.width, color.height, color.width * sizeof(uint16_t),
+        encoding_[RS_STREAM_DEPTH], pool_cap);
+    bool yuyv = (format_[RS_STREAM_COLOR] == RS_FORMAT_YUYV);
+    registered_color_bpp_ = yuyv ? sizeof(unsigned char) * 3 : unit_step_size_[RS_STREAM_COLOR];
+    registered_color_pool_.configure(depth.width, depth.height, depth.width * registered_color_bpp_,
+        yuyv ? converted_color_encoding_ : encoding_[RS_STREAM_COLOR], pool_cap);
+    registered_depth_info_ptr_ = boost::make_shared<sensor_msgs::CameraInfo>(*camera_info_ptr_[RS_STREAM_COLOR]);
+    registered_color_info_ptr_ = boost::make_shared<sensor_msgs::CameraInfo>(*camera_info_ptr_[RS_STREAM_DEPTH]);
+
+    std::unique_lock<std::mutex> color_lock(latest_color_mutex_);
+    latest_color_image_.reset();
+  }
+
+  /*
+   * Publish depth registered to color and color registered to depth, for the topics with subscribers.
+   */
+  void BaseNodelet::publishRegisteredImages(const sensor_msgs::Image &depth_image)
+  {
+    std::unique_lock<std::mutex> lock(registration_mutex_);
+    if (registration_.isConfigured() == false ||
+        depth_image.width != static_cast<uint32_t>(intrinsics_[RS_STREAM_DEPTH].width) ||
+        depth_image.height != static_cast<uint32_t>(intrinsics_[RS_STREAM_DEPTH].height))
+    {
+      return;
+    }
+    const uint16_t *depth = reinterpret_cast<const uint16_t *>(depth_image.data.data());
+
+    if (registered_depth_demand_ == true)
+    {
+      sensor_msgs::ImagePtr msg = registered_depth_pool_.acquire();
+      registration_.registerDepthToColor(depth, depth_image.step, reinterpret_cast<uint16_t *>(msg->data.data()),
+          msg->step, *worker_pool_);
+      msg->header.stamp = depth_image.header.stamp;
+      msg->header.frame_id = optical_frame_id_[RS_STREAM_COLOR];
+      registered_depth_publisher_.publish(msg, stampCameraInfo(*registered_depth_info_ptr_, msg->header.stamp));
+    }
+
+    if (registered_color_demand_ == true)
+    {
+      sensor_msgs::ImageConstPtr color_image;
+      {
+        std::unique_lock<std::mutex> color_lock(latest_color_mutex_);
+        color_image = latest_color_image_;
+      }
+      if (color_image && color_image->width == static_cast<uint32_t>(intrinsics_[RS_STREAM_COLOR].width) &&
+          color_image->height == static_cast<uint32_t>(intrinsics_[RS_STREAM_COLOR].height))
+      {
+        sensor_msgs::ImagePtr msg = registered_color_pool_.acquire();
+        registration_.registerColorToDepth(depth, depth_image.step, color_image->data.data(), color_image->step,
+            registered_color_bpp_, msg->data.data(), msg->step, *worker_pool_);
+        msg->header.stamp = depth_image.header.stamp;
+        msg->header.frame_id = optical_frame_id_[RS_STREAM_DEPTH];
+        registered_color_publisher_.publish(msg, stampCameraInfo(*registered_color_info_ptr_, msg->header.stamp));
+      }
+    }
+  }
+
+  /*
+   * Match the frames of the streaming, enabled streams into framesets. Unless configured,
+   * frames match within half the shortest frame period.
+   */
+  void BaseNodelet::setupFrameset()
+  {
+    std::vector<int> frameset_streams;
+    int max_fps = 0;
+    for (int stream = 0; stream < STREAM_COUNT; stream++)
+    {
+      if (enable_[stream] == true && rs_is_stream_enabled(rs_device_, static_cast<rs_stream>(stream), 0) == 1)
+      {
+        frameset_streams.push_back(stream);
+        max_fps = std::max(max_fps, fps_[stream]);
+      }
+    }
+    double tolerance_sec = frameset_tolerance_ms_ * 0.001;
+    if (tolerance_sec <= 0.0 && max_fps > 0)
+    {
+      tolerance_sec = 0.5 / max_fps;
+    }
+    frameset_sync_.configure(frameset_streams, tolerance_sec, FRAMESET_MAX_PENDING);
+  }
+
+  /*
+   * Add a processed frame and the camera info published with it to the frameset synchronizer,
+   * and hand on the set it completes. In-process listeners share the frames of the streams; the
+   * frameset topic is only built for its subscribers, as its message holds the frames by value.
+   * There every image and camera info of the set is stamped with the stamp of its first stream.
+   */
+  void BaseNodelet::publishFrameset(rs_stream stream_index, const sensor_msgs::ImageConstPtr &image,
+      const sensor_msgs::CameraInfoConstPtr &camera_info)
+  {
+    AlignedFrameset aligned;
+    if (frameset_sync_.add(stream_index, image, camera_info, aligned) == false)
+    {
+      return;
+    }
+
+    if (frameset_listener_demand_.load(std::memory_order_relaxed))
+    {
+      frame_hub_->publishFrameset(frame_source_, aligned);
+    }
+    if (frameset_topic_demand_.load(std::memory_order_relaxed) == false)
+    {
+      return;
+    }
+
+    realsense_camera::FramesetPtr frameset = boost::make_shared<realsense_camera::Frameset>();
+    frameset->header.stamp = aligned.stamp;
+    frameset->header.frame_id = base_frame_id_;
+    frameset->images.resize(aligned.images.size());
+    frameset->camera_infos.resize(aligned.images.size());
+    for (size_t i = 0; i < aligned.images.size(); i++)
+    {
+      frameset->images[i] = *aligned.images[i];
+      frameset->images[i].header.stamp = frameset->header.stamp;
+      frameset->camera_infos[i] = *aligned.camera_infos[i];
+      frameset->camera_infos[i].header.stamp = frameset->header.stamp;
+    }
+    frameset_pub_.publish(frameset);
+  }
+
+  /*
+   * Offer the streams of this camera to the frame aggregators of the process. The hub reports
+   * the streams they want and whether in-process listeners want the framesets of the camera,
+   * which then count as subscribed.
+   */
+  void BaseNodelet::setupFrameHub()
+  {
+    frame_source_ = nh_.getNamespace();
+    frame_hub_ = FrameHub::acquire();
+    frame_hub_->addSource(frame_source_, STREAM_COUNT,
+        [this](const std::vector<bool> &wanted, bool framesets_wanted)  // NOLINT(build/c++11)
+        {
+          for (int stream = 0; stream < STREAM_COUNT; stream++)
+          {
+            aggregator_demand_[stream] = wanted[stream];
+          }
+          frameset_listener_demand_ = framesets_wanted;
+          updateStreamDemand();
+        });
+  }
+
+  /*
+   * Hand a processed frame and its camera info to the frame aggregators.
+   */
+  void BaseNodelet::publishToAggregators(rs_stream stream_index, const sensor_msgs::ImageConstPtr &image,
+      const sensor_msgs::CameraInfoConstPtr &camera_info)
+  {
+    frame_hub_->publish(frame_source_, stream_index, image, camera_info);
+  }
+
+  /*
+   * Get the camera extrinsics
+   */
+  void BaseNodelet::getCameraExtrinsics()
+  {
+    // Get offset between base frame and depth frame
+    rs_get_device_extrinsics(rs_device_, RS_STREAM_DEPTH, RS_STREAM_COLOR, &color2depth_extrinsic_, &rs_error_);
+    if (rs_error_)
+    {
+      ROS_ERROR_STREAM(nodelet_name_ << " - Verify camera is calibrated!");
+    }
+    checkError();
+
+    // Get offset between base frame and infrared frame
+    rs_get_device_extrinsics(rs_device_, RS_STREAM_INFRARED, RS_STREAM_COLOR, &color2ir_extrinsic_, &rs_error_);
+    if (rs_error_)
+    {
+      ROS_ERROR_STREAM(nodelet_name_ << " - Verify camera is calibrated!");
+    }
+    checkError();
+  }
+
+  /*
+   * Build the transform table from the extrinsics and frame ids.
+   */
+  void BaseNodelet::buildTransformTable()
+  {
+    transform_table_.clear();
+
+    // The color frame is used as the base frame.
+    // Hence no additional transformation is done from base frame to color frame.
+    transform_table_.addIdentity(base_frame_id_, frame_id_[RS_STREAM_COLOR]);
+    transform_table_.addOptical(frame_id_[RS_STREAM_COLOR], optical_frame_id_[RS_STREAM_COLOR]);
+
+    addSensorTransforms(frame_id_[RS_STREAM_DEPTH], optical_frame_id_[RS_STREAM_DEPTH], color2depth_extrinsic_);
+    addSensorTransforms(frame_id_[RS_STREAM_INFRARED], optical_frame_id_[RS_STREAM_INFRARED], color2ir_extrinsic_);
+  }
+
+  /*
+   * Add the transforms from the base frame to a sensor frame and from it to its optical frame.
+   */
+  void BaseNodelet::addSensorTransforms(const std::string &frame_id, const std::string &optical_frame_id,
+      const rs_extrinsics &extrinsic)
+  {
+    if (!transform_table_.addExtrinsic(base_frame_id_, frame_id, extrinsic))
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - Invalid extrinsic rotation for " << frame_id
+          << "; publishing identity rotation.");
+    }
+    transform_table_.addOptical(frame_id, optical_frame_id);
+  }
+
+  /*
+   * Publish Static transforms.
+   */
+  void BaseNodelet::publishStaticTransforms()
+  {
+    // Publish transforms for the cameras
+    ROS_INFO_STREAM(nodelet_name_ << " - Publishing camera transforms (/tf_static)");
+
+    // Get the current timestamp for all static transforms
+    transform_ts_ = ros::Time::now();
+    static_tf_broadcaster_.sendTransform(transform_table_.stamp(transform_ts_));
+  }
+
+  /*
+   * Publish Dynamic transforms.
+   */
+  void BaseNodelet::publishDynamicTransforms()
+  {
+    // The whole tree goes out as one tfMessage
+    dynamic_tf_broadcaster_.sendTransform(transform_table_.stamp(transform_ts_));
+  }
+
+  /*
+   * Prepare transforms.
+   */
+  void BaseNodelet::prepareTransforms()
+  {
+    // Publish transforms for the cameras
+    ROS_INFO_STREAM(nodelet_name_ << " - Publishing camera transforms (/tf) at " << tf_publish_rate_ << " Hz");
+
+    ros::Rate loop_rate(tf_publish_rate_);
+
+    while (ros::ok())
+    {
+      // update the time stamp for publication
+      transform_ts_ = ros::Time::now();
+
+      publishDynamicTransforms();
+
+      loop_rate.sleep();
+    }
+  }
+
+  /*
+   * Set up the diagnostics updater and its periodic publishing.
+   */
+  void BaseNodelet::setupDiagnostics()
+  {
+    diagnostic_updater_.reset(new diagnostic_updater::Updater(nh_, pnh_, nodelet_name_));
+    diagnostic_updater_->setHardwareID(rs_get_device_serial(rs_device_, &rs_error_));
+    checkError();
+    diagnostic_updater_->add("Image Pools", this, &BaseNodelet::diagnoseImagePools);
+    diagnostic_updater_->add("Frame Queues", this, &BaseNodelet::diagnoseFrameQueues);
+    diagnostic_updater_->add("Stream Profiles", this, &BaseNodelet::diagnoseStreamProfiles);
+    diagnostic_updater_->add("Depth Filters", this, &BaseNodelet::diagnoseDepthFilters);
+    diagnostic_updater_->add("Depth Compression", this, &BaseNodelet::diagnoseDepthCompression);
+    diagnostic_updater_->add("Frameset Sync", this, &BaseNodelet::diagnoseFrameset);
+    diagnostic_updater_->add("Clock Sync", this, &BaseNodelet::diagnoseClockSync);
+
+    diagnostic_timer_ = nh_.createTimer(ros::Duration(DIAGNOSTICS_PERIOD), &BaseNodelet::updateDiagnostics, this);
+  }
+
+  /*
+   * Publish the diagnostics.
+   */
+  void BaseNodelet::updateDiagnostics(const ros::TimerEvent &event)
+  {
+    diagnostic_updater_->update();
+  }
+
+  /*
+   * Report the image pool counters of the enabled streams.
+   */
+  void BaseNodelet::diagnoseImagePools(diagnostic_updater::DiagnosticStatusWrapper &stat)
+  {
+    stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Image pools");
+    for (int stream = 0; stream < STREAM_COUNT; stream++)
+    {
+      if (enable_[stream] == true)
+      {
+        ImagePool::Statistics pool_stats = image_pool_[stream].getStatistics();
+        stat.add(STREAM_DESC[stream] + " hits", pool_stats.hits);
+        stat.add(STREAM_DESC[stream] + " misses", pool_stats.misses);
+        stat.add(STREAM_DESC[stream] + " outstanding", pool_stats.outstanding);
+        stat.add(STREAM_DESC[stream] + " pooled bytes", pool_stats.pooled_bytes);
+      }
+    }
+  }
+
+  /*
+   * Report the capture-to-publish queue counters of the enabled streams.
+   */
+  void BaseNodelet::diagnoseFrameQueues(diagnostic_updater::DiagnosticStatusWrapper &stat)
+  {
+    stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Frame queues (" + frame_drop_policy_ + ")");
+    for (int stream = 0; stream < STREAM_COUNT; stream++)
+    {
+      if (enable_[stream] == true)
+      {
+        uint64_t dropped = frame_queue_[stream].dropped;
+        stat.add(STREAM_DESC[stream] + " enqueued", frame_queue_[stream].enqueued.load());
+        stat.add(STREAM_DESC[stream] + " dropped", dropped);
+        stat.add(STREAM_DESC[stream] + " published", frame_queue_[stream].published.load());
+        stat.add(STREAM_DESC[stream] + " queued", frame_queue_[stream].ring.size());
+        if (dropped > frame_queue_[stream].reported_dropped)
+        {
+          stat.mergeSummary(diagnostic_msgs::DiagnosticStatus::WARN, "Frames dropped");
+        }
+        frame_queue_[stream].reported_dropped = dropped;
+      }
+    }
+  }
+
+  /*
+   * Report the profile of each enabled stream, and the restart and first frame times of the
+   * last profile switch.
+   */
+  void BaseNodelet::diagnoseStreamProfiles(diagnostic_updater::DiagnosticStatusWrapper &stat)
+  {
+    std::unique_lock<std::mutex> lock(stream_mutex_);
+    stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Stream profiles (" + mode_ + " mode)");
+    stat.add("Profile switches", profile_switches_.load());
+    stat.add("Last restart ms", restart_ms_.load());
+    for (int stream = 0; stream < STREAM_COUNT; stream++)
+    {
+      if (enable_[stream] == true)
+      {
+        std::ostringstream profile;
+        profile << width_[stream] << "x" << height_[stream] << " at " << fps_[stream] << " fps";
+        stat.add(STREAM_DESC[stream] + " profile", profile.str());
+        stat.add(STREAM_DESC[stream] + " first frame ms", first_frame_ms_[stream].load());
+        if (awaiting_first_frame_[stream])
+        {
+          stat.mergeSummary(diagnostic_msgs::DiagnosticStatus::WARN, "Waiting for the first frame after a switch");
+        }
+      }
+    }
+  }
+
+  /*
+   * Report the mean and worst time per frame of each depth filter since the last report.
+   */
+  void BaseNodelet::diagnoseDepthFilters(diagnostic_updater::DiagnosticStatusWrapper &stat)
+  {
+    std::unique_lock<std::mutex> lock(depth_filter_mutex_);
+    stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Depth filters");
+    const std::string names[] = {"Spatial", "Temporal", "Hole filling"};
+    FilterTiming *timings[] = {&spatial_filter_timing_, &temporal_filter_timing_, &hole_filling_timing_};
+    bool enabled[] = {depth_filter_settings_.enable_spatial, depth_filter_settings_.enable_temporal,
+        depth_filter_settings_.enable_hole_filling};
+    for (int i = 0; i < 3; i++)
+    {
+      FilterTiming &timing = *timings[i];
+      stat.add(names[i] + " enabled", enabled[i]);
+      stat.add(names[i] + " frames", timing.frames);
+      stat.add(names[i] + " mean ms", (timing.frames > 0) ? timing.total_ms / timing.frames : 0.0);
+      stat.add(names[i] + " max ms", timing.max_ms);
+      timing = FilterTiming();
+    }
+  }
+
+  /*
+   * Report the compression ratio and the encoding time per frame since the last report.
+   */
+  void BaseNodelet::diagnoseDepthCompression(diagnostic_updater::DiagnosticStatusWrapper &stat)
+  {
+    std::unique_lock<std::mutex> lock(depth_codec_mutex_);
+    stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Depth compression (" + DEPTH_CODEC_FORMAT + ")");
+    stat.add("Frames", depth_encode_timing_.frames);
+    stat.add("Compression ratio", (depth_encoded_bytes_ > 0) ?
+        static_cast<double>(depth_raw_bytes_) / depth_encoded_bytes_ : 0.0);
+    stat.add("Mean encode ms", (depth_encode_timing_.frames > 0) ?
+        depth_encode_timing_.total_ms / depth_encode_timing_.frames : 0.0);
+    stat.add("Max encode ms", depth_encode_timing_.max_ms);
+    depth_encode_timing_ = FilterTiming();
+    depth_raw_bytes_ = 0;
+    depth_encoded_bytes_ = 0;
+  }
+
+  /*
+   * Report the matched framesets, the frames dropped unmatched and the time the first frame
+   * of a set waited for the others since the last report.
+   */
+  void BaseNodelet::diagnoseFrameset(diagnostic_updater::DiagnosticStatusWrapper &stat)
+  {
+    FramesetSynchronizer::Statistics frameset_stats = frameset_sync_.takeStatistics();
+    uint64_t matched_frames = frameset_stats.matched * frameset_stats.streams;
+    stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Frameset sync");
+    stat.add("Streams", frameset_stats.streams);
+    stat.add("Framesets", frameset_stats.matched);
+    stat.add("Unmatched frames", frameset_stats.unmatched_frames);
+    stat.add("Match rate", (matched_frames + frameset_stats.unmatched_frames > 0) ?
+        static_cast<double>(matched_frames) / (matched_frames + frameset_stats.unmatched_frames) : 0.0);
+    stat.add("Mean wait ms", (frameset_stats.matched > 0) ?
+        frameset_stats.total_wait_ms / frameset_stats.matched : 0.0);
+    stat.add("Max wait ms", frameset_stats.max_wait_ms);
+  }
+
+  /*
+   * Report the offset and skew of the camera clock.
+   */
+  void BaseNodelet::diagnoseClockSync(diagnostic_updater::DiagnosticStatusWrapper &stat)
+  {
+    if (enable_clock_sync_ == false)
+    {
+      stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Clock sync disabled");
+      return;
+    }
+    stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "Clock sync");
+    addClockStatistics(stat, "Camera", clock_model_, reported_clock_resets_);
+  }
+
+  /*
+   * Add the statistics of one clock model, warning when its fit restarted since the last report.
+   */
+  void BaseNodelet::addClockStatistics(diagnostic_updater::DiagnosticStatusWrapper &stat, const std::string &name,
+      const DeviceClockModel &model, uint64_t &reported_resets)
+  {
+    DeviceClockModel::Statistics clock_stats;
+    {
+      std::unique_lock<std::mutex> lock(clock_mutex_);
+      clock_stats = model.getStatistics();
+    }
+    stat.add(name + " offset s", clock_stats.offset_sec);
+    stat.add(name + " skew ppm", clock_stats.skew_ppm);
+    stat.add(name + " residual ms", clock_stats.residual_ms);
+    stat.add(name + " window s", clock_stats.span_sec);
+    stat.add(name + " accepted", clock_stats.accepted);
+    stat.add(name + " rejected", clock_stats.rejected);
+    stat.add(name + " resets", clock_stats.resets);
+    if (clock_stats.resets > reported_resets)
+    {
+      stat.mergeSummary(diagnostic_msgs::DiagnosticStatus::WARN, "Clock model restarted");
     }
+    reported_resets = clock_stats.resets;
   }
 
   /*
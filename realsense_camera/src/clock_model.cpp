@@ -0,0 +1,238 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+#include <realsense_camera/clock_model.h>
+
+namespace realsense_camera
+{
+  namespace
+  {
+    const double NOMINAL_SEC_PER_MS = 0.001;
+    const double INTERVAL_MS = 100.0;          // one window sample per interval of device time
+    const double MIN_SKEW_SPAN_MS = 2000.0;    // shorter windows assume the nominal rate
+    const double MAX_SKEW = 500e-9;            // 500 ppm, far beyond any crystal tolerance
+    const double DEVICE_RESET_MS = 1000.0;     // a larger step backwards is a device clock reset
+    const size_t MIN_GATED_SAMPLES = 8;
+    const int MAX_CONSECUTIVE_REJECTS = 5;
+  }  // namespace
+
+  DeviceClockModel::DeviceClockModel()
+  {
+    configure(20.0, 5.0);
+  }
+
+  /*
+   * Set the fitted window length and the outlier limit, and restart the model.
+   */
+  void DeviceClockModel::configure(double window_sec, double outlier_ms)
+  {
+    capacity_ = std::max(static_cast<size_t>(window_sec * 1000.0 / INTERVAL_MS), static_cast<size_t>(2));
+    outlier_sec_ = outlier_ms * 0.001;
+    window_.assign(capacity_, Sample());
+    reset();
+  }
+
+  /*
+   * Forget the fit and the counters, e.g. when the device starts streaming again.
+   */
+  void DeviceClockModel::reset()
+  {
+    restart();
+    accepted_ = 0;
+    rejected_ = 0;
+    resets_ = 0;
+  }
+
+  void DeviceClockModel::restart()
+  {
+    started_ = false;
+    head_ = 0;
+    count_ = 0;
+    intercept_ = 0.0;
+    slope_ = 0.0;
+    residual_sec_ = 0.0;
+    consecutive_rejects_ = 0;
+  }
+
+  /*
+   * Add the arrival of a device timestamp at the given host time.
+   */
+  void DeviceClockModel::addSample(double device_ms, double host_sec)
+  {
+    if (started_ && device_ms - origin_device_ms_ < last_x_ - DEVICE_RESET_MS)
+    {
+      resets_++;
+      restart();
+    }
+    if (!started_)
+    {
+      started_ = true;
+      origin_device_ms_ = device_ms;
+      origin_host_sec_ = host_sec;
+      last_x_ = 0.0;
+      interval_start_ = 0.0;
+      interval_min_ = {0.0, 0.0};
+      return;
+    }
+
+    double x = device_ms - origin_device_ms_;
+    Sample sample = {x, host_sec - origin_host_sec_ - x * NOMINAL_SEC_PER_MS};
+    if (x - interval_start_ >= INTERVAL_MS)
+    {
+      commitInterval();
+      interval_start_ = x;
+      interval_min_ = sample;
+    }
+    else if (sample.y < interval_min_.y)
+    {
+      interval_min_ = sample;
+    }
+    if (count_ == 0)
+    {
+      // Until the first interval closes the offset is the earliest arrival so far.
+      intercept_ = std::min(intercept_, sample.y);
+    }
+    last_x_ = std::max(last_x_, x);
+  }
+
+  /*
+   * Gate the earliest arrival of the closed interval against the fit and add it to the window.
+   */
+  void DeviceClockModel::commitInterval()
+  {
+    if (count_ >= MIN_GATED_SAMPLES &&
+        std::abs(interval_min_.y - (intercept_ + slope_ * interval_min_.x)) > outlier_sec_)
+    {
+      rejected_++;
+      if (++consecutive_rejects_ < MAX_CONSECUTIVE_REJECTS)
+      {
+        return;
+      }
+      // The clocks stepped against each other; refit from the new arrivals only.
+      resets_++;
+      head_ = 0;
+      count_ = 0;
+    }
+    consecutive_rejects_ = 0;
+    accepted_++;
+
+    window_[head_] = interval_min_;
+    head_ = (head_ + 1) % capacity_;
+    count_ = std::min(count_ + 1, capacity_);
+    fit();
+  }
+
+  /*
+   * Least-squares line through the window, with the nominal rate while the window is short.
+   */
+  void DeviceClockModel::fit()
+  {
+    double mean_x = 0.0;
+    double mean_y = 0.0;
+    double min_x = window_[0].x;
+    double max_x = window_[0].x;
+    for (size_t i = 0; i < count_; i++)
+    {
+      mean_x += window_[i].x;
+      mean_y += window_[i].y;
+      min_x = std::min(min_x, window_[i].x);
+      max_x = std::max(max_x, window_[i].x);
+    }
+    mean_x /= count_;
+    mean_y /= count_;
+
+    double sxx = 0.0;
+    double sxy = 0.0;
+    for (size_t i = 0; i < count_; i++)
+    {
+      double dx = window_[i].x - mean_x;
+      sxx += dx * dx;
+      sxy += dx * (window_[i].y - mean_y);
+    }
+    slope_ = 0.0;
+    if (max_x - min_x >= MIN_SKEW_SPAN_MS && sxx > 0.0)
+    {
+      slope_ = std::max(-MAX_SKEW, std::min(MAX_SKEW, sxy / sxx));
+    }
+    intercept_ = mean_y - slope_ * mean_x;
+
+    double sum_sq = 0.0;
+    for (size_t i = 0; i < count_; i++)
+    {
+      double residual = window_[i].y - (intercept_ + slope_ * window_[i].x);
+      sum_sq += residual * residual;
+    }
+    residual_sec_ = std::sqrt(sum_sq / count_);
+  }
+
+  bool DeviceClockModel::isValid() const
+  {
+    return started_;
+  }
+
+  /*
+   * Host time in seconds of a device timestamp in ms.
+   */
+  double DeviceClockModel::toHost(double device_ms) const
+  {
+    double x = device_ms - origin_device_ms_;
+    return origin_host_sec_ + x * NOMINAL_SEC_PER_MS + intercept_ + slope_ * x;
+  }
+
+  DeviceClockModel::Statistics DeviceClockModel::getStatistics() const
+  {
+    Statistics stats;
+    double newest_ms = origin_device_ms_ + last_x_;
+    stats.offset_sec = started_ ? toHost(newest_ms) - newest_ms * NOMINAL_SEC_PER_MS : 0.0;
+    stats.skew_ppm = -slope_ * 1e9;  // a fast device clock gains on the host
+    stats.residual_ms = residual_sec_ * 1000.0;
+    stats.span_sec = 0.0;
+    if (count_ > 0)
+    {
+      double min_x = window_[0].x;
+      double max_x = window_[0].x;
+      for (size_t i = 1; i < count_; i++)
+      {
+        min_x = std::min(min_x, window_[i].x);
+        max_x = std::max(max_x, window_[i].x);
+      }
+      stats.span_sec = (max_x - min_x) * 0.001;
+    }
+    stats.samples = count_;
+    stats.accepted = accepted_;
+    stats.rejected = rejected_;
+    stats.resets = resets_;
+    return stats;
+  }
+}  // namespace realsense_camera
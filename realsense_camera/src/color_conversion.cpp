@@ -0,0 +1,285 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <algorithm>
+
+#include <realsense_camera/simd.h>
+#include <realsense_camera/color_conversion.h>
+
+namespace realsense_camera
+{
+  namespace
+  {
+    inline uint8_t clampByte(int32_t value)
+    {
+      return static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+    }
+
+    /*
+     * Convert one pixel to the color channels in memory order, red first unless bgr.
+     */
+    inline void convertPixel(int32_t y, int32_t u, int32_t v, bool bgr, uint8_t *out)
+    {
+      y = 298 * (y - 16) + 128;
+      u -= 128;
+      v -= 128;
+      uint8_t red = clampByte((y + 409 * v) >> 8);
+      uint8_t blue = clampByte((y + 516 * u) >> 8);
+      out[0] = bgr ? blue : red;
+      out[1] = clampByte((y - 100 * u - 208 * v) >> 8);
+      out[2] = bgr ? red : blue;
+    }
+
+    void convertRowScalar(const uint8_t *yuyv, uint32_t begin, uint32_t width, YuyvConversion conversion,
+        uint8_t *out)
+    {
+      for (uint32_t x = begin; x + 2 <= width; x += 2)
+      {
+        const uint8_t *pair = yuyv + 2 * x;
+        if (conversion == YUYV_TO_MONO8)
+        {
+          out[x] = pair[0];
+          out[x + 1] = pair[2];
+        }
+        else
+        {
+          bool bgr = (conversion == YUYV_TO_BGR8);
+          convertPixel(pair[0], pair[1], pair[3], bgr, out + 3 * x);
+          convertPixel(pair[2], pair[1], pair[3], bgr, out + 3 * x + 3);
+        }
+      }
+    }
+
+#ifdef REALSENSE_CAMERA_X86_KERNELS
+    inline int32_t coefficientPair(int16_t low, int16_t high)
+    {
+      return static_cast<int32_t>((static_cast<uint32_t>(static_cast<uint16_t>(high)) << 16) |
+          static_cast<uint16_t>(low));
+    }
+
+    /*
+     * Convert eight pixels to 16-bit red, green and blue values, see convertPixel.
+     */
+    __attribute__((target("sse4.1")))
+    inline void convertPixelsSSE41(__m128i yuyv, __m128i &red, __m128i &green, __m128i &blue)
+    {
+      const __m128i luma_mask = _mm_set1_epi16(0x00FF);
+      const __m128i u_shuffle = _mm_setr_epi8(1, -1, 1, -1, 5, -1, 5, -1, 9, -1, 9, -1, 13, -1, 13, -1);
+      const __m128i v_shuffle = _mm_setr_epi8(3, -1, 3, -1, 7, -1, 7, -1, 11, -1, 11, -1, 15, -1, 15, -1);
+      // Each product pairs a 16-bit value with its coefficient: (y, 1) . (298, 128) gives the
+      // rounded luma term and (u, v) . (cu, cv) the chroma term of a channel.
+      const __m128i luma_coefficients = _mm_set1_epi32(coefficientPair(298, 128));
+      const __m128i red_coefficients = _mm_set1_epi32(coefficientPair(0, 409));
+      const __m128i green_coefficients = _mm_set1_epi32(coefficientPair(-100, -208));
+      const __m128i blue_coefficients = _mm_set1_epi32(coefficientPair(516, 0));
+
+      __m128i y = _mm_sub_epi16(_mm_and_si128(yuyv, luma_mask), _mm_set1_epi16(16));
+      __m128i u = _mm_sub_epi16(_mm_shuffle_epi8(yuyv, u_shuffle), _mm_set1_epi16(128));
+      __m128i v = _mm_sub_epi16(_mm_shuffle_epi8(yuyv, v_shuffle), _mm_set1_epi16(128));
+
+      __m128i luma_lo = _mm_madd_epi16(_mm_unpacklo_epi16(y, _mm_set1_epi16(1)), luma_coefficients);
+      __m128i luma_hi = _mm_madd_epi16(_mm_unpackhi_epi16(y, _mm_set1_epi16(1)), luma_coefficients);
+      __m128i chroma_lo = _mm_unpacklo_epi16(u, v);
+      __m128i chroma_hi = _mm_unpackhi_epi16(u, v);
+
+      red = _mm_packs_epi32(
+          _mm_srai_epi32(_mm_add_epi32(luma_lo, _mm_madd_epi16(chroma_lo, red_coefficients)), 8),
+          _mm_srai_epi32(_mm_add_epi32(luma_hi, _mm_madd_epi16(chroma_hi, red_coefficients)), 8));
+      green = _mm_packs_epi32(
+          _mm_srai_epi32(_mm_add_epi32(luma_lo, _mm_madd_epi16(chroma_lo, green_coefficients)), 8),
+          _mm_srai_epi32(_mm_add_epi32(luma_hi, _mm_madd_epi16(chroma_hi, green_coefficients)), 8));
+      blue = _mm_packs_epi32(
+          _mm_srai_epi32(_mm_add_epi32(luma_lo, _mm_madd_epi16(chroma_lo, blue_coefficients)), 8),
+          _mm_srai_epi32(_mm_add_epi32(luma_hi, _mm_madd_epi16(chroma_hi, blue_coefficients)), 8));
+    }
+
+    /*
+     * Interleave sixteen pixels of three planes into 48 bytes.
+     */
+    __attribute__((target("sse4.1")))
+    inline void storePixelsSSE41(__m128i first, __m128i second, __m128i third, uint8_t *out)
+    {
+      const __m128i first_0 = _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5);
+      const __m128i first_1 = _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1);
+      const __m128i first_2 = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1);
+      const __m128i second_0 = _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1);
+      const __m128i second_1 = _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10);
+      const __m128i second_2 = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1);
+      const __m128i third_0 = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+      const __m128i third_1 = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1);
+      const __m128i third_2 = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15);
+
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_or_si128(_mm_or_si128(
+          _mm_shuffle_epi8(first, first_0), _mm_shuffle_epi8(second, second_0)), _mm_shuffle_epi8(third, third_0)));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 16), _mm_or_si128(_mm_or_si128(
+          _mm_shuffle_epi8(first, first_1), _mm_shuffle_epi8(second, second_1)), _mm_shuffle_epi8(third, third_1)));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 32), _mm_or_si128(_mm_or_si128(
+          _mm_shuffle_epi8(first, first_2), _mm_shuffle_epi8(second, second_2)), _mm_shuffle_epi8(third, third_2)));
+    }
+
+    __attribute__((target("sse4.1")))
+    void convertRowSSE41(const uint8_t *yuyv, uint32_t width, YuyvConversion conversion, uint8_t *out)
+    {
+      const __m128i luma_mask = _mm_set1_epi16(0x00FF);
+
+      uint32_t x = 0;
+      for (; x + 16 <= width; x += 16)
+      {
+        __m128i pixels_lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(yuyv + 2 * x));
+        __m128i pixels_hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(yuyv + 2 * x + 16));
+        if (conversion == YUYV_TO_MONO8)
+        {
+          _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x),
+              _mm_packus_epi16(_mm_and_si128(pixels_lo, luma_mask), _mm_and_si128(pixels_hi, luma_mask)));
+          continue;
+        }
+
+        __m128i red_lo, green_lo, blue_lo, red_hi, green_hi, blue_hi;
+        convertPixelsSSE41(pixels_lo, red_lo, green_lo, blue_lo);
+        convertPixelsSSE41(pixels_hi, red_hi, green_hi, blue_hi);
+        __m128i red = _mm_packus_epi16(red_lo, red_hi);
+        __m128i green = _mm_packus_epi16(green_lo, green_hi);
+        __m128i blue = _mm_packus_epi16(blue_lo, blue_hi);
+        if (conversion == YUYV_TO_BGR8)
+        {
+          storePixelsSSE41(blue, green, red, out + 3 * x);
+        }
+        else
+        {
+          storePixelsSSE41(red, green, blue, out + 3 * x);
+        }
+      }
+      convertRowScalar(yuyv, x, width, conversion, out);
+    }
+
+    /*
+     * Convert sixteen pixels to 16-bit red, green and blue values, eight per 128-bit lane.
+     */
+    __attribute__((target("avx2")))
+    inline void convertPixelsAVX2(__m256i yuyv, __m256i &red, __m256i &green, __m256i &blue)
+    {
+      const __m256i luma_mask = _mm256_set1_epi16(0x00FF);
+      const __m256i u_shuffle = _mm256_setr_epi8(1, -1, 1, -1, 5, -1, 5, -1, 9, -1, 9, -1, 13, -1, 13, -1,
+          1, -1, 1, -1, 5, -1, 5, -1, 9, -1, 9, -1, 13, -1, 13, -1);
+      const __m256i v_shuffle = _mm256_setr_epi8(3, -1, 3, -1, 7, -1, 7, -1, 11, -1, 11, -1, 15, -1, 15, -1,
+          3, -1, 3, -1, 7, -1, 7, -1, 11, -1, 11, -1, 15, -1, 15, -1);
+      const __m256i luma_coefficients = _mm256_set1_epi32(coefficientPair(298, 128));
+      const __m256i red_coefficients = _mm256_set1_epi32(coefficientPair(0, 409));
+      const __m256i green_coefficients = _mm256_set1_epi32(coefficientPair(-100, -208));
+      const __m256i blue_coefficients = _mm256_set1_epi32(coefficientPair(516, 0));
+
+      __m256i y = _mm256_sub_epi16(_mm256_and_si256(yuyv, luma_mask), _mm256_set1_epi16(16));
+      __m256i u = _mm256_sub_epi16(_mm256_shuffle_epi8(yuyv, u_shuffle), _mm256_set1_epi16(128));
+      __m256i v = _mm256_sub_epi16(_mm256_shuffle_epi8(yuyv, v_shuffle), _mm256_set1_epi16(128));
+
+      __m256i luma_lo = _mm256_madd_epi16(_mm256_unpacklo_epi16(y, _mm256_set1_epi16(1)), luma_coefficients);
+      __m256i luma_hi = _mm256_madd_epi16(_mm256_unpackhi_epi16(y, _mm256_set1_epi16(1)), luma_coefficients);
+      __m256i chroma_lo = _mm256_unpacklo_epi16(u, v);
+      __m256i chroma_hi = _mm256_unpackhi_epi16(u, v);
+
+      // unpack and pack both work within lanes, so the pixel order is preserved
+      red = _mm256_packs_epi32(
+          _mm256_srai_epi32(_mm256_add_epi32(luma_lo, _mm256_madd_epi16(chroma_lo, red_coefficients)), 8),
+          _mm256_srai_epi32(_mm256_add_epi32(luma_hi, _mm256_madd_epi16(chroma_hi, red_coefficients)), 8));
+      green = _mm256_packs_epi32(
+          _mm256_srai_epi32(_mm256_add_epi32(luma_lo, _mm256_madd_epi16(chroma_lo, green_coefficients)), 8),
+          _mm256_srai_epi32(_mm256_add_epi32(luma_hi, _mm256_madd_epi16(chroma_hi, green_coefficients)), 8));
+      blue = _mm256_packs_epi32(
+          _mm256_srai_epi32(_mm256_add_epi32(luma_lo, _mm256_madd_epi16(chroma_lo, blue_coefficients)), 8),
+          _mm256_srai_epi32(_mm256_add_epi32(luma_hi, _mm256_madd_epi16(chroma_hi, blue_coefficients)), 8));
+    }
+
+    __attribute__((target("avx2")))
+    void convertRowAVX2(const uint8_t *yuyv, uint32_t width, YuyvConversion conversion, uint8_t *out)
+    {
+      const __m256i luma_mask = _mm256_set1_epi16(0x00FF);
+
+      uint32_t x = 0;
+      for (; x + 32 <= width; x += 32)
+      {
+        __m256i pixels_lo = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(yuyv + 2 * x));
+        __m256i pixels_hi = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(yuyv + 2 * x + 32));
+        if (conversion == YUYV_TO_MONO8)
+        {
+          // packus works per 128-bit lane, restore the pixel order afterwards
+          _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x), _mm256_permute4x64_epi64(_mm256_packus_epi16(
+              _mm256_and_si256(pixels_lo, luma_mask), _mm256_and_si256(pixels_hi, luma_mask)), 0xD8));
+          continue;
+        }
+
+        __m256i red_lo, green_lo, blue_lo, red_hi, green_hi, blue_hi;
+        convertPixelsAVX2(pixels_lo, red_lo, green_lo, blue_lo);
+        convertPixelsAVX2(pixels_hi, red_hi, green_hi, blue_hi);
+        __m256i red = _mm256_permute4x64_epi64(_mm256_packus_epi16(red_lo, red_hi), 0xD8);
+        __m256i green = _mm256_permute4x64_epi64(_mm256_packus_epi16(green_lo, green_hi), 0xD8);
+        __m256i blue = _mm256_permute4x64_epi64(_mm256_packus_epi16(blue_lo, blue_hi), 0xD8);
+        if (conversion == YUYV_TO_BGR8)
+        {
+          std::swap(red, blue);
+        }
+        storePixelsSSE41(_mm256_castsi256_si128(red), _mm256_castsi256_si128(green), _mm256_castsi256_si128(blue),
+            out + 3 * x);
+        storePixelsSSE41(_mm256_extracti128_si256(red, 1), _mm256_extracti128_si256(green, 1),
+            _mm256_extracti128_si256(blue, 1), out + 3 * x + 48);
+      }
+      size_t out_offset = (conversion == YUYV_TO_MONO8) ? x : 3 * x;
+      convertRowSSE41(yuyv + 2 * x, width - x, conversion, out + out_offset);
+    }
+#endif
+  }  // namespace
+
+  /*
+   * Convert rows of a YUYV image.
+   */
+  void convertYuyv(const uint8_t *yuyv, size_t yuyv_step, uint32_t width, uint32_t rows, YuyvConversion conversion,
+      uint8_t *out, size_t out_step)
+  {
+    InstructionSet isa = getInstructionSet();
+    for (uint32_t y = 0; y < rows; ++y)
+    {
+      const uint8_t *yuyv_row = yuyv + y * yuyv_step;
+      uint8_t *out_row = out + y * out_step;
+      switch (isa)
+      {
+#ifdef REALSENSE_CAMERA_X86_KERNELS
+        case INSTRUCTION_SET_AVX2:
+          convertRowAVX2(yuyv_row, width, conversion, out_row);
+          break;
+        case INSTRUCTION_SET_SSE41:
+          convertRowSSE41(yuyv_row, width, conversion, out_row);
+          break;
+#endif
+        default:
+          convertRowScalar(yuyv_row, 0, width, conversion, out_row);
+          break;
+      }
+    }
+  }
+}  // namespace realsense_camera
@@ -0,0 +1,342 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+#include <realsense_camera/depth_codec.h>
+
+namespace realsense_camera
+{
+  namespace
+  {
+    const size_t DEPTH_CODEC_HEADER_FIELDS = 3;
+    const int NIBBLES_PER_WORD = 8;
+
+    /*
+     * Upper bound of the encoded size of a band in words. A row of n pixels takes at most
+     * 10 n + 2 nibbles: every run length needs no more nibbles than pixels plus one, and a
+     * zigzag-coded 16-bit delta needs at most six.
+     */
+    size_t maxBandWords(uint32_t width, uint32_t rows)
+    {
+      return (static_cast<size_t>(rows) * (10 * static_cast<size_t>(width) + 2) + NIBBLES_PER_WORD - 1) /
+          NIBBLES_PER_WORD;
+    }
+
+    class NibbleWriter
+    {
+    public:
+      explicit NibbleWriter(uint32_t *out) : out_(out), begin_(out) {}
+
+      inline void put(uint32_t value)
+      {
+        do
+        {
+          uint32_t nibble = value & 0x7;
+          value >>= 3;
+          if (value != 0)
+          {
+            nibble |= 0x8;
+          }
+          word_ = (word_ << 4) | nibble;
+          if (++count_ == NIBBLES_PER_WORD)
+          {
+            *out_++ = word_;
+            word_ = 0;
+            count_ = 0;
+          }
+        }
+        while (value != 0);
+      }
+
+      // Flush the last partial word and return the number of words written.
+      size_t finish()
+      {
+        if (count_ > 0)
+        {
+          *out_++ = word_ << (4 * (NIBBLES_PER_WORD - count_));
+          word_ = 0;
+          count_ = 0;
+        }
+        return out_ - begin_;
+      }
+
+    private:
+      uint32_t *out_;
+      uint32_t *begin_;
+      uint32_t word_ = 0;
+      int count_ = 0;
+    };
+
+    class NibbleReader
+    {
+    public:
+      NibbleReader(const uint8_t *data, size_t size) : in_(data), end_(data + size) {}
+
+      inline bool get(uint32_t &value)
+      {
+        value = 0;
+        uint32_t nibble;
+        int shift = 0;
+        do
+        {
+          if (count_ == 0)
+          {
+            if (end_ - in_ < 4)
+            {
+              return false;
+            }
+            memcpy(&word_, in_, sizeof(word_));
+            in_ += sizeof(word_);
+            count_ = NIBBLES_PER_WORD;
+          }
+          if (shift > 30)
+          {
+            return false;
+          }
+          nibble = word_ >> 28;
+          word_ <<= 4;
+          --count_;
+          value |= (nibble & 0x7) << shift;
+          shift += 3;
+        }
+        while (nibble & 0x8);
+        return true;
+      }
+
+    private:
+      const uint8_t *in_;
+      const uint8_t *end_;
+      uint32_t word_ = 0;
+      int count_ = 0;
+    };
+
+    void encodeRow(const uint16_t *row, uint32_t width, uint16_t &previous, NibbleWriter &writer)
+    {
+      uint32_t x = 0;
+      while (x < width)
+      {
+        uint32_t start = x;
+        while (x < width && row[x] == 0)
+        {
+          ++x;
+        }
+        writer.put(x - start);
+
+        start = x;
+        while (x < width && row[x] != 0)
+        {
+          ++x;
+        }
+        writer.put(x - start);
+
+        for (uint32_t i = start; i < x; ++i)
+        {
+          int32_t delta = static_cast<int32_t>(row[i]) - previous;
+          writer.put((static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31));
+          previous = row[i];
+        }
+      }
+    }
+
+    bool decodeRow(NibbleReader &reader, uint32_t width, uint16_t &previous, uint16_t *row)
+    {
+      uint32_t x = 0;
+      while (x < width)
+      {
+        uint32_t zeros, values;
+        if (!reader.get(zeros) || zeros > width - x)
+        {
+          return false;
+        }
+        std::fill(row + x, row + x + zeros, 0);
+        x += zeros;
+
+        if (!reader.get(values) || values > width - x)
+        {
+          return false;
+        }
+        for (uint32_t end = x + values; x < end; ++x)
+        {
+          uint32_t zigzag;
+          if (!reader.get(zigzag))
+          {
+            return false;
+          }
+          int32_t delta = static_cast<int32_t>(zigzag >> 1) ^ -static_cast<int32_t>(zigzag & 1);
+          previous = static_cast<uint16_t>(previous + delta);
+          row[x] = previous;
+        }
+      }
+      return true;
+    }
+  }  // namespace
+
+  /*
+   * Start encoding an image, sizing the band buffers for the worst case.
+   */
+  size_t DepthEncoder::begin(const uint16_t *depth, uint32_t width, uint32_t height, size_t step)
+  {
+    depth_ = depth;
+    width_ = width;
+    height_ = height;
+    step_ = step;
+
+    size_t band_count = (height + DEPTH_CODEC_BAND_ROWS - 1) / DEPTH_CODEC_BAND_ROWS;
+    bands_.resize(band_count);
+    band_sizes_.assign(band_count, 0);
+    for (std::vector<uint32_t> &band : bands_)
+    {
+      // only grows, so steady-state encoding reuses the buffers
+      band.resize(maxBandWords(width, DEPTH_CODEC_BAND_ROWS));
+    }
+    return band_count;
+  }
+
+  /*
+   * Encode one band of rows.
+   */
+  void DepthEncoder::encodeBand(size_t band)
+  {
+    uint32_t row_begin = band * DEPTH_CODEC_BAND_ROWS;
+    uint32_t row_end = std::min(row_begin + DEPTH_CODEC_BAND_ROWS, height_);
+    NibbleWriter writer(bands_[band].data());
+    uint16_t previous = 0;
+    for (uint32_t y = row_begin; y < row_end; ++y)
+    {
+      encodeRow(reinterpret_cast<const uint16_t *>(reinterpret_cast<const uint8_t *>(depth_) + y * step_), width_,
+          previous, writer);
+    }
+    band_sizes_[band] = writer.finish() * sizeof(uint32_t);
+  }
+
+  /*
+   * Concatenate the header and the encoded bands.
+   */
+  size_t DepthEncoder::finish(std::vector<uint8_t> &out)
+  {
+    std::vector<uint32_t> header = {width_, height_, DEPTH_CODEC_BAND_ROWS};
+    size_t total = 0;
+    for (size_t size : band_sizes_)
+    {
+      header.push_back(static_cast<uint32_t>(size));
+      total += size;
+    }
+
+    size_t header_bytes = header.size() * sizeof(uint32_t);
+    out.resize(header_bytes + total);
+    memcpy(out.data(), header.data(), header_bytes);
+    uint8_t *payload = out.data() + header_bytes;
+    for (size_t band = 0; band < bands_.size(); ++band)
+    {
+      memcpy(payload, bands_[band].data(), band_sizes_[band]);
+      payload += band_sizes_[band];
+    }
+    depth_ = NULL;
+    return out.size();
+  }
+
+  /*
+   * Encode an image on the calling thread.
+   */
+  size_t encodeDepth(const uint16_t *depth, uint32_t width, uint32_t height, size_t step, std::vector<uint8_t> &out)
+  {
+    DepthEncoder encoder;
+    size_t band_count = encoder.begin(depth, width, height, step);
+    for (size_t band = 0; band < band_count; ++band)
+    {
+      encoder.encodeBand(band);
+    }
+    return encoder.finish(out);
+  }
+
+  /*
+   * Decode an encoded image, validating every size against the data.
+   */
+  bool decodeDepth(const uint8_t *data, size_t size, uint32_t &width, uint32_t &height, std::vector<uint16_t> &depth)
+  {
+    uint32_t header[DEPTH_CODEC_HEADER_FIELDS];
+    if (size < sizeof(header))
+    {
+      return false;
+    }
+    memcpy(header, data, sizeof(header));
+    uint32_t band_rows = header[2];
+    if (band_rows == 0)
+    {
+      return false;
+    }
+
+    // The header is untrusted: bound the image before allocating it. A row codes at least
+    // its two run lengths, one byte, so the payload also bounds the row count.
+    if (static_cast<uint64_t>(header[0]) * header[1] > DEPTH_CODEC_MAX_PIXELS ||
+        (header[0] > 0 && header[1] > size - sizeof(header)))
+    {
+      return false;
+    }
+    size_t band_count = (static_cast<size_t>(header[1]) + band_rows - 1) / band_rows;
+    if ((size - sizeof(header)) / sizeof(uint32_t) < band_count)
+    {
+      return false;
+    }
+    std::vector<uint32_t> band_sizes(band_count);
+    for (size_t band = 0; band < band_count; ++band)
+    {
+      memcpy(&band_sizes[band], data + sizeof(header) + band * sizeof(uint32_t), sizeof(uint32_t));
+    }
+
+    width = header[0];
+    height = header[1];
+    depth.resize(static_cast<size_t>(width) * height);
+
+    size_t offset = sizeof(header) + band_count * sizeof(uint32_t);
+    for (size_t band = 0; band < band_count; ++band)
+    {
+      if (band_sizes[band] > size - offset)
+      {
+        return false;
+      }
+      NibbleReader reader(data + offset, band_sizes[band]);
+      uint16_t previous = 0;
+      uint32_t row_end = std::min<size_t>((band + 1) * band_rows, height);
+      for (uint32_t y = band * band_rows; y < row_end; ++y)
+      {
+        if (!decodeRow(reader, width, previous, depth.data() + static_cast<size_t>(y) * width))
+        {
+          return false;
+        }
+      }
+      offset += band_sizes[band];
+    }
+    return true;
+  }
+}  // namespace realsense_camera
@@ -0,0 +1,165 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+/*
+ * Benchmark of the lossless depth codec.
+ *
+ * Reports the compression ratio and the encode and decode throughput in MB/s of raw depth,
+ * on the worker pool and on a single thread. Recorded frames are given as 16-bit PNG files,
+ * otherwise a synthetic frame with a sloped floor, noise and holes is used.
+ *
+ * Usage: depth_codec_benchmark [iterations] [frame.png ...]
+ */
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include <realsense_camera/depth_codec.h>
+#include <realsense_camera/worker_pool.h>
+
+struct Frame
+{
+  std::string name;
+  cv::Mat depth;
+};
+
+cv::Mat makeSyntheticFrame(int width, int height)
+{
+  cv::Mat depth(height, width, CV_16UC1);
+  srand(1);
+  for (int y = 0; y < height; ++y)
+  {
+    for (int x = 0; x < width; ++x)
+    {
+      bool hole = (rand() % 20 == 0) || (x > width / 3 && x < width / 3 + 40 && y > height / 2);
+      int value = 600 + 4 * (height - y) + rand() % 8;
+      depth.at<uint16_t>(y, x) = hole ? 0 : static_cast<uint16_t>(value);
+    }
+  }
+  return depth;
+}
+
+double elapsedSeconds(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv)
+{
+  int iterations = (argc > 1) ? atoi(argv[1]) : 200;
+
+  std::vector<Frame> frames;
+  for (int i = 2; i < argc; ++i)
+  {
+    cv::Mat depth = cv::imread(argv[i], cv::IMREAD_ANYDEPTH);
+    if (depth.empty() || depth.type() != CV_16UC1)
+    {
+      fprintf(stderr, "skipping %s: not a 16-bit single channel image\n", argv[i]);
+      continue;
+    }
+    frames.push_back({argv[i], depth});
+  }
+  if (frames.empty())
+  {
+    frames.push_back({"synthetic 640x480", makeSyntheticFrame(640, 480)});
+    frames.push_back({"synthetic 1280x720", makeSyntheticFrame(1280, 720)});
+  }
+
+  realsense_camera::WorkerPool pool;
+  pool.start(0);
+  printf("worker pool concurrency: %u\n", pool.getConcurrency());
+  printf("%-32s %8s %14s %14s %14s %8s\n", "frame", "ratio", "encode MB/s", "pooled MB/s", "decode MB/s",
+      "lossless");
+
+  for (const Frame &frame : frames)
+  {
+    const uint16_t *depth = frame.depth.ptr<uint16_t>();
+    uint32_t width = frame.depth.cols;
+    uint32_t height = frame.depth.rows;
+    size_t step = frame.depth.step;
+    double raw_mb = static_cast<double>(width) * height * sizeof(uint16_t) * iterations / (1024.0 * 1024.0);
+
+    std::vector<uint8_t> encoded;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+      realsense_camera::encodeDepth(depth, width, height, step, encoded);
+    }
+    double encode_s = elapsedSeconds(start);
+
+    realsense_camera::DepthEncoder encoder;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+      size_t band_count = encoder.begin(depth, width, height, step);
+      pool.parallelFor(band_count, 1, [&](size_t begin, size_t end)  // NOLINT(build/c++11)
+      {
+        for (size_t band = begin; band < end; ++band)
+        {
+          encoder.encodeBand(band);
+        }
+      });
+      encoder.finish(encoded);
+    }
+    double pooled_s = elapsedSeconds(start);
+
+    std::vector<uint16_t> decoded;
+    uint32_t decoded_width = 0;
+    uint32_t decoded_height = 0;
+    bool valid = true;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+      valid = realsense_camera::decodeDepth(encoded.data(), encoded.size(), decoded_width, decoded_height, decoded) &&
+          valid;
+    }
+    double decode_s = elapsedSeconds(start);
+
+    bool lossless = valid && decoded_width == width && decoded_height == height;
+    for (uint32_t y = 0; lossless && y < height; ++y)
+    {
+      const uint16_t *row = frame.depth.ptr<uint16_t>(y);
+      lossless = std::equal(row, row + width, decoded.begin() + static_cast<size_t>(y) * width);
+    }
+
+    printf("%-32s %7.2fx %14.1f %14.1f %14.1f %8s\n", frame.name.c_str(),
+        static_cast<double>(width) * height * sizeof(uint16_t) / encoded.size(), raw_mb / encode_s,
+        raw_mb / pooled_s, raw_mb / decode_s, lossless ? "yes" : "NO");
+  }
+  pool.stop();
+  return 0;
+}
@@ -0,0 +1,613 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+
+#include <realsense_camera/simd.h>
+#include <realsense_camera/depth_filters.h>
+
+namespace realsense_camera
+{
+  namespace
+  {
+    // Filter weights are applied in 8-bit fixed point.
+    const int FILTER_ALPHA_SHIFT = 8;
+    const int32_t FILTER_ALPHA_ROUNDING = 1 << (FILTER_ALPHA_SHIFT - 1);
+
+    int32_t toFixedAlpha(float alpha)
+    {
+      return static_cast<int32_t>(std::lround(std::max(0.0f, std::min(alpha, 1.0f)) * (1 << FILTER_ALPHA_SHIFT)));
+    }
+
+    inline uint16_t *depthRow(uint16_t *depth, size_t step, uint32_t y)
+    {
+      return reinterpret_cast<uint16_t *>(reinterpret_cast<uint8_t *>(depth) + y * step);
+    }
+
+    inline const uint16_t *depthRow(const uint16_t *depth, size_t step, uint32_t y)
+    {
+      return reinterpret_cast<const uint16_t *>(reinterpret_cast<const uint8_t *>(depth) + y * step);
+    }
+
+    /*
+     * Blend a depth value towards a reference when both are valid and closer than delta.
+     */
+    inline uint16_t blendDepthValue(uint16_t value, uint16_t reference, int32_t alpha, uint16_t delta)
+    {
+      int32_t diff = static_cast<int32_t>(value) - reference;
+      if (value == 0 || reference == 0 || std::abs(diff) >= delta)
+      {
+        return value;
+      }
+      return static_cast<uint16_t>(reference + ((diff * alpha + FILTER_ALPHA_ROUNDING) >> FILTER_ALPHA_SHIFT));
+    }
+
+    inline int countBits(uint8_t bits)
+    {
+      int count = 0;
+      for (; bits != 0; bits &= bits - 1)
+      {
+        ++count;
+      }
+      return count;
+    }
+
+    void blendRowScalar(uint16_t *row, const uint16_t *reference, uint32_t begin, uint32_t width, int32_t alpha,
+        uint16_t delta)
+    {
+      for (uint32_t x = begin; x < width; ++x)
+      {
+        row[x] = blendDepthValue(row[x], reference[x], alpha, delta);
+      }
+    }
+
+    void transposeDepthScalar(const uint16_t *src, size_t src_step, uint32_t x_begin, uint32_t x_end,
+        uint32_t y_begin, uint32_t y_end, uint16_t *dst, size_t dst_step)
+    {
+      for (uint32_t y = y_begin; y < y_end; ++y)
+      {
+        const uint16_t *src_row = depthRow(src, src_step, y);
+        for (uint32_t x = x_begin; x < x_end; ++x)
+        {
+          depthRow(dst, dst_step, x)[y] = src_row[x];
+        }
+      }
+    }
+
+    /*
+     * Fill the holes of one row. The center row is padded by one zero pixel on each side and
+     * the rows above and below are offset by one pixel to line up with it.
+     */
+    void fillRowScalar(const uint16_t *above, const uint16_t *center, const uint16_t *below, uint32_t begin,
+        uint32_t width, HoleFillingMode mode, uint16_t *out)
+    {
+      for (uint32_t x = begin; x < width; ++x)
+      {
+        uint16_t value = center[x + 1];
+        if (value == 0)
+        {
+          uint16_t neighbours[4] = {center[x], center[x + 2], above[x + 1], below[x + 1]};
+          for (uint16_t neighbour : neighbours)
+          {
+            if (neighbour == 0)
+            {
+              continue;
+            }
+            if (value == 0 || (mode == HOLE_FILLING_NEAREST ? neighbour < value : neighbour > value))
+            {
+              value = neighbour;
+            }
+          }
+        }
+        out[x] = value;
+      }
+    }
+
+    void temporalFilterScalar(uint16_t *depth, uint16_t *average, uint8_t *history, uint32_t begin, uint32_t width,
+        int32_t alpha, uint16_t delta, int persistence)
+    {
+      for (uint32_t x = begin; x < width; ++x)
+      {
+        uint16_t value = depth[x];
+        uint8_t bits = history[x];
+        history[x] = static_cast<uint8_t>((bits << 1) | (value != 0 ? 1 : 0));
+        if (value != 0)
+        {
+          value = blendDepthValue(value, average[x], alpha, delta);
+          average[x] = value;
+        }
+        else if (persistence > 0 && countBits(bits) >= persistence)
+        {
+          value = average[x];
+        }
+        depth[x] = value;
+      }
+    }
+
+#ifdef REALSENSE_CAMERA_X86_KERNELS
+    /*
+     * Blend eight depth values towards their references, see blendDepthValue.
+     */
+    __attribute__((target("sse4.1")))
+    inline __m128i blendDepthSSE41(__m128i value, __m128i reference, __m128i alpha, __m128i max_diff)
+    {
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i rounding = _mm_set1_epi32(FILTER_ALPHA_ROUNDING);
+
+      __m128i diff = _mm_or_si128(_mm_subs_epu16(value, reference), _mm_subs_epu16(reference, value));
+      __m128i blend = _mm_cmpeq_epi16(_mm_min_epu16(diff, max_diff), diff);
+      blend = _mm_andnot_si128(_mm_cmpeq_epi16(value, zero), blend);
+      blend = _mm_andnot_si128(_mm_cmpeq_epi16(reference, zero), blend);
+
+      __m128i value_lo = _mm_cvtepu16_epi32(value);
+      __m128i value_hi = _mm_cvtepu16_epi32(_mm_srli_si128(value, 8));
+      __m128i ref_lo = _mm_cvtepu16_epi32(reference);
+      __m128i ref_hi = _mm_cvtepu16_epi32(_mm_srli_si128(reference, 8));
+      __m128i out_lo = _mm_add_epi32(ref_lo, _mm_srai_epi32(_mm_add_epi32(_mm_mullo_epi32(
+          _mm_sub_epi32(value_lo, ref_lo), alpha), rounding), FILTER_ALPHA_SHIFT));
+      __m128i out_hi = _mm_add_epi32(ref_hi, _mm_srai_epi32(_mm_add_epi32(_mm_mullo_epi32(
+          _mm_sub_epi32(value_hi, ref_hi), alpha), rounding), FILTER_ALPHA_SHIFT));
+      return _mm_blendv_epi8(value, _mm_packus_epi32(out_lo, out_hi), blend);
+    }
+
+    __attribute__((target("sse4.1")))
+    void blendRowSSE41(uint16_t *row, const uint16_t *reference, uint32_t width, int32_t alpha, uint16_t delta)
+    {
+      const __m128i alpha_v = _mm_set1_epi32(alpha);
+      const __m128i max_diff = _mm_set1_epi16(static_cast<int16_t>(delta - 1));
+
+      uint32_t x = 0;
+      for (; x + 8 <= width; x += 8)
+      {
+        __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x));
+        __m128i ref = _mm_loadu_si128(reinterpret_cast<const __m128i *>(reference + x));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(row + x), blendDepthSSE41(value, ref, alpha_v, max_diff));
+      }
+      blendRowScalar(row, reference, x, width, alpha, delta);
+    }
+
+    /*
+     * Transpose an 8x8 block of depth values.
+     */
+    __attribute__((target("sse4.1")))
+    void transposeBlockSSE41(const uint16_t *src, size_t src_step, uint16_t *dst, size_t dst_step)
+    {
+      __m128i r[8];
+      for (int i = 0; i < 8; ++i)
+      {
+        r[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(reinterpret_cast<const uint8_t *>(src) +
+            i * src_step));
+      }
+      __m128i t0 = _mm_unpacklo_epi16(r[0], r[1]);
+      __m128i t1 = _mm_unpackhi_epi16(r[0], r[1]);
+      __m128i t2 = _mm_unpacklo_epi16(r[2], r[3]);
+      __m128i t3 = _mm_unpackhi_epi16(r[2], r[3]);
+      __m128i t4 = _mm_unpacklo_epi16(r[4], r[5]);
+      __m128i t5 = _mm_unpackhi_epi16(r[4], r[5]);
+      __m128i t6 = _mm_unpacklo_epi16(r[6], r[7]);
+      __m128i t7 = _mm_unpackhi_epi16(r[6], r[7]);
+      __m128i u0 = _mm_unpacklo_epi32(t0, t2);
+      __m128i u1 = _mm_unpackhi_epi32(t0, t2);
+      __m128i u2 = _mm_unpacklo_epi32(t1, t3);
+      __m128i u3 = _mm_unpackhi_epi32(t1, t3);
+      __m128i u4 = _mm_unpacklo_epi32(t4, t6);
+      __m128i u5 = _mm_unpackhi_epi32(t4, t6);
+      __m128i u6 = _mm_unpacklo_epi32(t5, t7);
+      __m128i u7 = _mm_unpackhi_epi32(t5, t7);
+      r[0] = _mm_unpacklo_epi64(u0, u4);
+      r[1] = _mm_unpackhi_epi64(u0, u4);
+      r[2] = _mm_unpacklo_epi64(u1, u5);
+      r[3] = _mm_unpackhi_epi64(u1, u5);
+      r[4] = _mm_unpacklo_epi64(u2, u6);
+      r[5] = _mm_unpackhi_epi64(u2, u6);
+      r[6] = _mm_unpacklo_epi64(u3, u7);
+      r[7] = _mm_unpackhi_epi64(u3, u7);
+      for (int i = 0; i < 8; ++i)
+      {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(reinterpret_cast<uint8_t *>(dst) + i * dst_step), r[i]);
+      }
+    }
+
+    __attribute__((target("sse4.1")))
+    void transposeDepthSSE41(const uint16_t *src, uint32_t width, uint32_t height, size_t src_step, uint16_t *dst,
+        size_t dst_step)
+    {
+      uint32_t full_width = width & ~7u;
+      uint32_t full_height = height & ~7u;
+      for (uint32_t y = 0; y < full_height; y += 8)
+      {
+        const uint16_t *src_row = depthRow(src, src_step, y);
+        for (uint32_t x = 0; x < full_width; x += 8)
+        {
+          transposeBlockSSE41(src_row + x, src_step, depthRow(dst, dst_step, x) + y, dst_step);
+        }
+      }
+      transposeDepthScalar(src, src_step, full_width, width, 0, height, dst, dst_step);
+      transposeDepthScalar(src, src_step, 0, full_width, full_height, height, dst, dst_step);
+    }
+
+    __attribute__((target("sse4.1")))
+    void fillRowSSE41(const uint16_t *above, const uint16_t *center, const uint16_t *below, uint32_t width,
+        HoleFillingMode mode, uint16_t *out)
+    {
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i one = _mm_set1_epi16(1);
+
+      uint32_t x = 0;
+      for (; x + 8 <= width; x += 8)
+      {
+        __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i *>(center + x));
+        __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(center + x + 1));
+        __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i *>(center + x + 2));
+        __m128i up = _mm_loadu_si128(reinterpret_cast<const __m128i *>(above + x + 1));
+        __m128i down = _mm_loadu_si128(reinterpret_cast<const __m128i *>(below + x + 1));
+        __m128i fill;
+        if (mode == HOLE_FILLING_NEAREST)
+        {
+          // invalid neighbours wrap to 65535 and never win the minimum
+          fill = _mm_min_epu16(_mm_sub_epi16(left, one), _mm_sub_epi16(right, one));
+          fill = _mm_min_epu16(fill, _mm_min_epu16(_mm_sub_epi16(up, one), _mm_sub_epi16(down, one)));
+          fill = _mm_add_epi16(fill, one);
+        }
+        else
+        {
+          fill = _mm_max_epu16(_mm_max_epu16(left, right), _mm_max_epu16(up, down));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x),
+            _mm_blendv_epi8(value, fill, _mm_cmpeq_epi16(value, zero)));
+      }
+      fillRowScalar(above, center, below, x, width, mode, out);
+    }
+
+    /*
+     * Count the set bits of the low byte of each 16-bit lane.
+     */
+    __attribute__((target("sse4.1")))
+    inline __m128i countBitsSSE41(__m128i bits)
+    {
+      const __m128i nibble_counts = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+      const __m128i nibble_mask = _mm_set1_epi16(0x0F);
+      __m128i low = _mm_shuffle_epi8(nibble_counts, _mm_and_si128(bits, nibble_mask));
+      __m128i high = _mm_shuffle_epi8(nibble_counts, _mm_and_si128(_mm_srli_epi16(bits, 4), nibble_mask));
+      return _mm_add_epi16(low, high);
+    }
+
+    __attribute__((target("sse4.1")))
+    void temporalFilterSSE41(uint16_t *depth, uint16_t *average, uint8_t *history, uint32_t width, int32_t alpha,
+        uint16_t delta, int persistence)
+    {
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i alpha_v = _mm_set1_epi32(alpha);
+      const __m128i max_diff = _mm_set1_epi16(static_cast<int16_t>(delta - 1));
+      // a persistence of zero never fills, which no 8-bit history can reach
+      const __m128i min_count = _mm_set1_epi16(static_cast<int16_t>((persistence > 0 ? persistence : 9) - 1));
+      const __m128i history_mask = _mm_set1_epi16(0xFF);
+
+      uint32_t x = 0;
+      for (; x + 8 <= width; x += 8)
+      {
+        __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(depth + x));
+        __m128i avg = _mm_loadu_si128(reinterpret_cast<const __m128i *>(average + x));
+        __m128i bits = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(history + x)));
+        __m128i valid = _mm_xor_si128(_mm_cmpeq_epi16(value, zero), _mm_set1_epi16(-1));
+
+        __m128i blended = blendDepthSSE41(value, avg, alpha_v, max_diff);
+        __m128i held = _mm_and_si128(avg, _mm_cmpgt_epi16(countBitsSSE41(bits), min_count));
+        __m128i next_bits = _mm_and_si128(_mm_or_si128(_mm_slli_epi16(bits, 1), _mm_srli_epi16(valid, 15)),
+            history_mask);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(average + x), _mm_blendv_epi8(avg, blended, valid));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(depth + x), _mm_blendv_epi8(held, blended, valid));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(history + x), _mm_packus_epi16(next_bits, next_bits));
+      }
+      temporalFilterScalar(depth, average, history, x, width, alpha, delta, persistence);
+    }
+
+    /*
+     * Blend sixteen depth values towards their references, see blendDepthValue.
+     */
+    __attribute__((target("avx2")))
+    inline __m256i blendDepthAVX2(__m256i value, __m256i reference, __m256i alpha, __m256i max_diff)
+    {
+      const __m256i zero = _mm256_setzero_si256();
+      const __m256i rounding = _mm256_set1_epi32(FILTER_ALPHA_ROUNDING);
+
+      __m256i diff = _mm256_or_si256(_mm256_subs_epu16(value, reference), _mm256_subs_epu16(reference, value));
+      __m256i blend = _mm256_cmpeq_epi16(_mm256_min_epu16(diff, max_diff), diff);
+      blend = _mm256_andnot_si256(_mm256_cmpeq_epi16(value, zero), blend);
+      blend = _mm256_andnot_si256(_mm256_cmpeq_epi16(reference, zero), blend);
+
+      __m256i value_lo = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(value));
+      __m256i value_hi = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(value, 1));
+      __m256i ref_lo = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(reference));
+      __m256i ref_hi = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(reference, 1));
+      __m256i out_lo = _mm256_add_epi32(ref_lo, _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(
+          _mm256_sub_epi32(value_lo, ref_lo), alpha), rounding), FILTER_ALPHA_SHIFT));
+      __m256i out_hi = _mm256_add_epi32(ref_hi, _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(
+          _mm256_sub_epi32(value_hi, ref_hi), alpha), rounding), FILTER_ALPHA_SHIFT));
+      // packus works per 128-bit lane, restore the pixel order afterwards
+      __m256i out = _mm256_permute4x64_epi64(_mm256_packus_epi32(out_lo, out_hi), 0xD8);
+      return _mm256_blendv_epi8(value, out, blend);
+    }
+
+    __attribute__((target("avx2")))
+    void blendRowAVX2(uint16_t *row, const uint16_t *reference, uint32_t width, int32_t alpha, uint16_t delta)
+    {
+      const __m256i alpha_v = _mm256_set1_epi32(alpha);
+      const __m256i max_diff = _mm256_set1_epi16(static_cast<int16_t>(delta - 1));
+
+      uint32_t x = 0;
+      for (; x + 16 <= width; x += 16)
+      {
+        __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + x));
+        __m256i ref = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(reference + x));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(row + x), blendDepthAVX2(value, ref, alpha_v, max_diff));
+      }
+      blendRowSSE41(row + x, reference + x, width - x, alpha, delta);
+    }
+
+    __attribute__((target("avx2")))
+    void fillRowAVX2(const uint16_t *above, const uint16_t *center, const uint16_t *below, uint32_t width,
+        HoleFillingMode mode, uint16_t *out)
+    {
+      const __m256i zero = _mm256_setzero_si256();
+      const __m256i one = _mm256_set1_epi16(1);
+
+      uint32_t x = 0;
+      for (; x + 16 <= width; x += 16)
+      {
+        __m256i left = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(center + x));
+        __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(center + x + 1));
+        __m256i right = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(center + x + 2));
+        __m256i up = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(above + x + 1));
+        __m256i down = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(below + x + 1));
+        __m256i fill;
+        if (mode == HOLE_FILLING_NEAREST)
+        {
+          fill = _mm256_min_epu16(_mm256_sub_epi16(left, one), _mm256_sub_epi16(right, one));
+          fill = _mm256_min_epu16(fill, _mm256_min_epu16(_mm256_sub_epi16(up, one), _mm256_sub_epi16(down, one)));
+          fill = _mm256_add_epi16(fill, one);
+        }
+        else
+        {
+          fill = _mm256_max_epu16(_mm256_max_epu16(left, right), _mm256_max_epu16(up, down));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x),
+            _mm256_blendv_epi8(value, fill, _mm256_cmpeq_epi16(value, zero)));
+      }
+      fillRowSSE41(above + x, center + x, below + x, width - x, mode, out + x);
+    }
+
+    __attribute__((target("avx2")))
+    void temporalFilterAVX2(uint16_t *depth, uint16_t *average, uint8_t *history, uint32_t width, int32_t alpha,
+        uint16_t delta, int persistence)
+    {
+      const __m256i zero = _mm256_setzero_si256();
+      const __m256i alpha_v = _mm256_set1_epi32(alpha);
+      const __m256i max_diff = _mm256_set1_epi16(static_cast<int16_t>(delta - 1));
+      const __m256i min_count = _mm256_set1_epi16(static_cast<int16_t>((persistence > 0 ? persistence : 9) - 1));
+      const __m256i history_mask = _mm256_set1_epi16(0xFF);
+      const __m256i nibble_counts = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+          0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+      const __m256i nibble_mask = _mm256_set1_epi16(0x0F);
+
+      uint32_t x = 0;
+      for (; x + 16 <= width; x += 16)
+      {
+        __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(depth + x));
+        __m256i avg = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(average + x));
+        __m256i bits = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(history + x)));
+        __m256i valid = _mm256_xor_si256(_mm256_cmpeq_epi16(value, zero), _mm256_set1_epi16(-1));
+
+        __m256i count = _mm256_add_epi16(_mm256_shuffle_epi8(nibble_counts, _mm256_and_si256(bits, nibble_mask)),
+            _mm256_shuffle_epi8(nibble_counts, _mm256_and_si256(_mm256_srli_epi16(bits, 4), nibble_mask)));
+        __m256i blended = blendDepthAVX2(value, avg, alpha_v, max_diff);
+        __m256i held = _mm256_and_si256(avg, _mm256_cmpgt_epi16(count, min_count));
+        __m256i next_bits = _mm256_and_si256(_mm256_or_si256(_mm256_slli_epi16(bits, 1),
+            _mm256_srli_epi16(valid, 15)), history_mask);
+        next_bits = _mm256_permute4x64_epi64(_mm256_packus_epi16(next_bits, next_bits), 0xD8);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(average + x), _mm256_blendv_epi8(avg, blended, valid));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(depth + x), _mm256_blendv_epi8(held, blended, valid));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(history + x), _mm256_castsi256_si128(next_bits));
+      }
+      temporalFilterSSE41(depth + x, average + x, history + x, width - x, alpha, delta, persistence);
+    }
+#endif
+
+    void blendRow(InstructionSet isa, uint16_t *row, const uint16_t *reference, uint32_t width, int32_t alpha,
+        uint16_t delta)
+    {
+      switch (isa)
+      {
+#ifdef REALSENSE_CAMERA_X86_KERNELS
+        case INSTRUCTION_SET_AVX2:
+          blendRowAVX2(row, reference, width, alpha, delta);
+          break;
+        case INSTRUCTION_SET_SSE41:
+          blendRowSSE41(row, reference, width, alpha, delta);
+          break;
+#endif
+        default:
+          blendRowScalar(row, reference, 0, width, alpha, delta);
+          break;
+      }
+    }
+
+    /*
+     * Run the recursive filter down and then up the columns of an image. Each row is blended
+     * with the already filtered row before it, so whole rows are processed as vectors.
+     */
+    void filterColumns(InstructionSet isa, uint16_t *depth, uint32_t width, uint32_t height, size_t step,
+        int32_t alpha, uint16_t delta)
+    {
+      for (uint32_t y = 1; y < height; ++y)
+      {
+        blendRow(isa, depthRow(depth, step, y), depthRow(depth, step, y - 1), width, alpha, delta);
+      }
+      for (uint32_t y = height - 1; y > 0; --y)
+      {
+        blendRow(isa, depthRow(depth, step, y - 1), depthRow(depth, step, y), width, alpha, delta);
+      }
+    }
+
+    void transposeDepth(InstructionSet isa, const uint16_t *src, uint32_t width, uint32_t height, size_t src_step,
+        uint16_t *dst, size_t dst_step)
+    {
+#ifdef REALSENSE_CAMERA_X86_KERNELS
+      if (isa != INSTRUCTION_SET_SCALAR)
+      {
+        transposeDepthSSE41(src, width, height, src_step, dst, dst_step);
+        return;
+      }
+#endif
+      transposeDepthScalar(src, src_step, 0, width, 0, height, dst, dst_step);
+    }
+  }  // namespace
+
+  /*
+   * Edge-preserving smoothing along the rows and the columns.
+   */
+  void spatialFilterDepth(uint16_t *depth, uint32_t width, uint32_t height, size_t step, float alpha, uint16_t delta,
+      int iterations, std::vector<uint16_t> &scratch)
+  {
+    if (width == 0 || height == 0)
+    {
+      return;
+    }
+    InstructionSet isa = getInstructionSet();
+    int32_t fixed_alpha = toFixedAlpha(alpha);
+    // a delta of one only blends equal values, which leaves them unchanged, as zero would
+    delta = std::max<uint16_t>(delta, 1);
+
+    // The rows are filtered as the columns of the transposed image.
+    scratch.resize(static_cast<size_t>(width) * height);
+    size_t transposed_step = height * sizeof(uint16_t);
+    for (int i = 0; i < iterations; ++i)
+    {
+      transposeDepth(isa, depth, width, height, step, scratch.data(), transposed_step);
+      filterColumns(isa, scratch.data(), height, width, transposed_step, fixed_alpha, delta);
+      transposeDepth(isa, scratch.data(), height, width, transposed_step, depth, step);
+      filterColumns(isa, depth, width, height, step, fixed_alpha, delta);
+    }
+  }
+
+  /*
+   * Fill the holes from their 4-neighbours.
+   */
+  void fillDepthHoles(uint16_t *depth, uint32_t width, uint32_t height, size_t step, HoleFillingMode mode,
+      std::vector<uint16_t> &scratch)
+  {
+    // Three padded rows: the unfilled previous row, the unfilled current row and a row of zeros
+    // standing in for the rows outside the image.
+    size_t padded = width + 2;
+    scratch.assign(3 * padded, 0);
+    uint16_t *above = scratch.data();
+    uint16_t *center = above + padded;
+    const uint16_t *outside = center + padded;
+    InstructionSet isa = getInstructionSet();
+
+    for (uint32_t y = 0; y < height; ++y)
+    {
+      uint16_t *row = depthRow(depth, step, y);
+      std::copy(row, row + width, center + 1);
+      const uint16_t *up = (y > 0) ? above : outside;
+      // the next row is not filled yet, offset it to line up with the padded rows
+      const uint16_t *down = (y + 1 < height) ? depthRow(depth, step, y + 1) - 1 : outside;
+
+      switch (isa)
+      {
+#ifdef REALSENSE_CAMERA_X86_KERNELS
+        case INSTRUCTION_SET_AVX2:
+          fillRowAVX2(up, center, down, width, mode, row);
+          break;
+        case INSTRUCTION_SET_SSE41:
+          fillRowSSE41(up, center, down, width, mode, row);
+          break;
+#endif
+        default:
+          fillRowScalar(up, center, down, 0, width, mode, row);
+          break;
+      }
+      std::swap(above, center);
+    }
+  }
+
+  /*
+   * Forget the running average and the validity history.
+   */
+  void TemporalDepthFilter::reset()
+  {
+    std::fill(average_.begin(), average_.end(), 0);
+    std::fill(history_.begin(), history_.end(), 0);
+  }
+
+  /*
+   * Blend the frame into the running average and fill its holes from it.
+   */
+  void TemporalDepthFilter::apply(uint16_t *depth, uint32_t width, uint32_t height, size_t step, float alpha,
+      uint16_t delta, int persistence)
+  {
+    if (width != width_ || height != height_)
+    {
+      width_ = width;
+      height_ = height;
+      average_.assign(static_cast<size_t>(width) * height, 0);
+      history_.assign(static_cast<size_t>(width) * height, 0);
+    }
+    InstructionSet isa = getInstructionSet();
+    int32_t fixed_alpha = toFixedAlpha(alpha);
+    delta = std::max<uint16_t>(delta, 1);
+
+    for (uint32_t y = 0; y < height; ++y)
+    {
+      uint16_t *row = depthRow(depth, step, y);
+      uint16_t *average = average_.data() + static_cast<size_t>(y) * width;
+      uint8_t *history = history_.data() + static_cast<size_t>(y) * width;
+      switch (isa)
+      {
+#ifdef REALSENSE_CAMERA_X86_KERNELS
+        case INSTRUCTION_SET_AVX2:
+          temporalFilterAVX2(row, average, history, width, fixed_alpha, delta, persistence);
+          break;
+        case INSTRUCTION_SET_SSE41:
+          temporalFilterSSE41(row, average, history, width, fixed_alpha, delta, persistence);
+          break;
+#endif
+        default:
+          temporalFilterScalar(row, average, history, 0, width, fixed_alpha, delta, persistence);
+          break;
+      }
+    }
+  }
+}  // namespace realsense_camera
@@ -0,0 +1,579 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+#include <realsense_camera/simd.h>
+#include <realsense_camera/depth_kernels.h>
+
+namespace realsense_camera
+{
+  namespace
+  {
+    /*
+     * Rescale one depth value.
+     */
+    inline uint16_t scaleDepthValue(uint16_t raw, const DepthScaleFactor &factor)
+    {
+      uint32_t rounding = (1u << factor.shift) >> 1;
+      uint32_t scaled = (raw * factor.multiplier + rounding) >> factor.shift;
+      return static_cast<uint16_t>(std::min<uint32_t>(scaled, 65535));
+    }
+
+    void scaleDepthScalar(uint16_t *depth, size_t count, const DepthScaleFactor &factor)
+    {
+      for (size_t i = 0; i < count; ++i)
+      {
+        depth[i] = scaleDepthValue(depth[i], factor);
+      }
+    }
+
+    /*
+     * Add the values to the statistics, rescaling them first when a factor is given.
+     */
+    void computeDepthStatisticsScalar(uint16_t *depth, size_t count, const DepthScaleFactor *factor,
+        bool histogram, DepthFrameStatistics &stats)
+    {
+      for (size_t i = 0; i < count; ++i)
+      {
+        uint16_t value = depth[i];
+        if (factor != NULL)
+        {
+          value = scaleDepthValue(value, *factor);
+          depth[i] = value;
+        }
+        if (value > 0)
+        {
+          stats.min = std::min(stats.min, value);
+          stats.max = std::max(stats.max, value);
+          stats.sum += value;
+          ++stats.valid;
+          if (histogram)
+          {
+            ++stats.histogram[std::min(value >> DEPTH_HISTOGRAM_BIN_SHIFT, DEPTH_HISTOGRAM_BINS - 1)];
+          }
+        }
+      }
+      stats.count += count;
+    }
+
+    /*
+     * Reduce one 2x2 block. Matches the vector kernels, which treat 65535 as the invalid marker
+     * for the minimum.
+     */
+    inline uint16_t decimateBlock(uint16_t a, uint16_t b, uint16_t c, uint16_t d, DepthDecimationMode mode)
+    {
+      if (mode == DEPTH_DECIMATION_MIN_VALID)
+      {
+        uint16_t min = std::min(std::min(a ? a : 65535, b ? b : 65535), std::min(c ? c : 65535, d ? d : 65535));
+        return (min == 65535) ? 0 : min;
+      }
+
+      // Zeros sort first, the lower median of the n valid values is at 4 - n + (n - 1) / 2
+      uint16_t v[4] = {a, b, c, d};
+      std::sort(v, v + 4);
+      int invalid = (a == 0) + (b == 0) + (c == 0) + (d == 0);
+      const int index[5] = {1, 2, 2, 3, 0};
+      return v[index[invalid]];
+    }
+
+    void decimateRowsScalar(const uint16_t *row0, const uint16_t *row1, size_t begin, size_t out_width,
+        DepthDecimationMode mode, uint16_t *out)
+    {
+      for (size_t x = begin; x < out_width; ++x)
+      {
+        out[x] = decimateBlock(row0[2 * x], row0[2 * x + 1], row1[2 * x], row1[2 * x + 1], mode);
+      }
+    }
+
+#ifdef REALSENSE_CAMERA_X86_KERNELS
+    /*
+     * Rescale 8 depth values held in one register.
+     */
+    __attribute__((target("sse4.1")))
+    inline __m128i scaleDepthSSE41(__m128i raw, __m128i multiplier, __m128i rounding, __m128i shift)
+    {
+      __m128i lo = _mm_cvtepu16_epi32(raw);
+      __m128i hi = _mm_cvtepu16_epi32(_mm_srli_si128(raw, 8));
+      lo = _mm_srl_epi32(_mm_add_epi32(_mm_mullo_epi32(lo, multiplier), rounding), shift);
+      hi = _mm_srl_epi32(_mm_add_epi32(_mm_mullo_epi32(hi, multiplier), rounding), shift);
+      return _mm_packus_epi32(lo, hi);
+    }
+
+    __attribute__((target("sse4.1")))
+    void scaleDepthSSE41(uint16_t *depth, size_t count, const DepthScaleFactor &factor)
+    {
+      const __m128i multiplier = _mm_set1_epi32(factor.multiplier);
+      const __m128i rounding = _mm_set1_epi32((1u << factor.shift) >> 1);
+      const __m128i shift = _mm_cvtsi32_si128(factor.shift);
+
+      size_t i = 0;
+      for (; i + 8 <= count; i += 8)
+      {
+        __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i *>(depth + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(depth + i), scaleDepthSSE41(raw, multiplier, rounding, shift));
+      }
+      scaleDepthScalar(depth + i, count - i, factor);
+    }
+
+    __attribute__((target("sse4.1")))
+    void computeDepthStatisticsSSE41(uint16_t *depth, size_t count, const DepthScaleFactor *factor,
+        bool histogram, DepthFrameStatistics &stats)
+    {
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i multiplier = _mm_set1_epi32(factor ? factor->multiplier : 0);
+      const __m128i rounding = _mm_set1_epi32(factor ? (1u << factor->shift) >> 1 : 0);
+      const __m128i shift = _mm_cvtsi32_si128(factor ? factor->shift : 0);
+
+      __m128i min = _mm_set1_epi16(-1);
+      __m128i max = zero;
+      __m128i sum = zero;
+      size_t invalid = 0;
+      uint16_t values[8];
+
+      size_t i = 0;
+      size_t block = 0;
+      for (; i + 8 <= count; i += 8)
+      {
+        __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(depth + i));
+        if (factor != NULL)
+        {
+          value = scaleDepthSSE41(value, multiplier, rounding, shift);
+          _mm_storeu_si128(reinterpret_cast<__m128i *>(depth + i), value);
+        }
+
+        // Invalid pixels become 65535 for the minimum and add 0 to max and sum
+        __m128i invalid_mask = _mm_cmpeq_epi16(value, zero);
+        min = _mm_min_epu16(min, _mm_or_si128(value, invalid_mask));
+        max = _mm_max_epu16(max, value);
+        sum = _mm_add_epi32(sum, _mm_add_epi32(_mm_cvtepu16_epi32(value),
+              _mm_cvtepu16_epi32(_mm_srli_si128(value, 8))));
+        invalid += __builtin_popcount(_mm_movemask_epi8(invalid_mask)) / 2;
+
+        if (histogram)
+        {
+          // Invalid pixels land in bin 0 and are removed after the loop
+          _mm_storeu_si128(reinterpret_cast<__m128i *>(values), _mm_srli_epi16(value, DEPTH_HISTOGRAM_BIN_SHIFT));
+          for (int j = 0; j < 8; ++j)
+          {
+            ++stats.histogram[std::min<int>(values[j], DEPTH_HISTOGRAM_BINS - 1)];
+          }
+        }
+
+        // Each 32-bit lane gains at most 2 * 65535 per iteration, flush before it can overflow
+        if (++block == 16384)
+        {
+          uint32_t lanes[4];
+          _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), sum);
+          stats.sum += static_cast<uint64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+          sum = zero;
+          block = 0;
+        }
+      }
+
+      uint16_t min_values[8];
+      uint16_t max_values[8];
+      uint32_t lanes[4];
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(min_values), min);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(max_values), max);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), sum);
+      for (int j = 0; j < 8; ++j)
+      {
+        stats.min = std::min(stats.min, min_values[j]);
+        stats.max = std::max(stats.max, max_values[j]);
+      }
+      stats.sum += static_cast<uint64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+      stats.valid += i - invalid;
+      stats.count += i;
+      if (histogram)
+      {
+        stats.histogram[0] -= invalid;
+      }
+
+      computeDepthStatisticsScalar(depth + i, count - i, factor, histogram, stats);
+    }
+
+    /*
+     * Reduce 2x2 blocks given as their four corner values, one block per 16-bit lane.
+     */
+    __attribute__((target("sse4.1")))
+    inline __m128i decimateBlocksSSE41(__m128i a, __m128i b, __m128i c, __m128i d, DepthDecimationMode mode)
+    {
+      const __m128i zero = _mm_setzero_si128();
+      __m128i a_invalid = _mm_cmpeq_epi16(a, zero);
+      __m128i b_invalid = _mm_cmpeq_epi16(b, zero);
+      __m128i c_invalid = _mm_cmpeq_epi16(c, zero);
+      __m128i d_invalid = _mm_cmpeq_epi16(d, zero);
+
+      if (mode == DEPTH_DECIMATION_MIN_VALID)
+      {
+        __m128i min = _mm_min_epu16(_mm_min_epu16(_mm_or_si128(a, a_invalid), _mm_or_si128(b, b_invalid)),
+            _mm_min_epu16(_mm_or_si128(c, c_invalid), _mm_or_si128(d, d_invalid)));
+        return _mm_andnot_si128(_mm_cmpeq_epi16(min, _mm_set1_epi16(-1)), min);
+      }
+
+      // Sorting network, then pick the lower median of the valid values
+      __m128i t;
+      t = _mm_min_epu16(a, b); b = _mm_max_epu16(a, b); a = t;
+      t = _mm_min_epu16(c, d); d = _mm_max_epu16(c, d); c = t;
+      t = _mm_min_epu16(a, c); c = _mm_max_epu16(a, c); a = t;
+      t = _mm_min_epu16(b, d); d = _mm_max_epu16(b, d); b = t;
+      t = _mm_min_epu16(b, c); c = _mm_max_epu16(b, c); b = t;
+
+      __m128i invalid = _mm_sub_epi16(_mm_sub_epi16(zero, _mm_add_epi16(a_invalid, b_invalid)),
+          _mm_add_epi16(c_invalid, d_invalid));
+      __m128i result = b;
+      result = _mm_blendv_epi8(result, c, _mm_or_si128(_mm_cmpeq_epi16(invalid, _mm_set1_epi16(1)),
+            _mm_cmpeq_epi16(invalid, _mm_set1_epi16(2))));
+      result = _mm_blendv_epi8(result, d, _mm_cmpeq_epi16(invalid, _mm_set1_epi16(3)));
+      return _mm_andnot_si128(_mm_cmpeq_epi16(invalid, _mm_set1_epi16(4)), result);
+    }
+
+    __attribute__((target("sse4.1")))
+    void decimateRowsSSE41(const uint16_t *row0, const uint16_t *row1, size_t out_width, DepthDecimationMode mode,
+        uint16_t *out)
+    {
+      const __m128i low = _mm_set1_epi32(0xFFFF);
+
+      size_t x = 0;
+      for (; x + 8 <= out_width; x += 8)
+      {
+        __m128i r00 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + 2 * x));
+        __m128i r01 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + 2 * x + 8));
+        __m128i r10 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + 2 * x));
+        __m128i r11 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + 2 * x + 8));
+
+        // Split even and odd columns
+        __m128i a = _mm_packus_epi32(_mm_and_si128(r00, low), _mm_and_si128(r01, low));
+        __m128i b = _mm_packus_epi32(_mm_srli_epi32(r00, 16), _mm_srli_epi32(r01, 16));
+        __m128i c = _mm_packus_epi32(_mm_and_si128(r10, low), _mm_and_si128(r11, low));
+        __m128i d = _mm_packus_epi32(_mm_srli_epi32(r10, 16), _mm_srli_epi32(r11, 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), decimateBlocksSSE41(a, b, c, d, mode));
+      }
+      decimateRowsScalar(row0, row1, x, out_width, mode, out);
+    }
+
+    /*
+     * Rescale 16 depth values held in one register.
+     */
+    __attribute__((target("avx2")))
+    inline __m256i scaleDepthAVX2(__m256i raw, __m256i multiplier, __m256i rounding, __m128i shift)
+    {
+      __m256i lo = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(raw));
+      __m256i hi = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(raw, 1));
+      lo = _mm256_srl_epi32(_mm256_add_epi32(_mm256_mullo_epi32(lo, multiplier), rounding), shift);
+      hi = _mm256_srl_epi32(_mm256_add_epi32(_mm256_mullo_epi32(hi, multiplier), rounding), shift);
+      // packus works per 128-bit lane, restore the pixel order afterwards
+      return _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8);
+    }
+
+    __attribute__((target("avx2")))
+    void scaleDepthAVX2(uint16_t *depth, size_t count, const DepthScaleFactor &factor)
+    {
+      const __m256i multiplier = _mm256_set1_epi32(factor.multiplier);
+      const __m256i rounding = _mm256_set1_epi32((1u << factor.shift) >> 1);
+      const __m128i shift = _mm_cvtsi32_si128(factor.shift);
+
+      size_t i = 0;
+      for (; i + 16 <= count; i += 16)
+      {
+        __m256i raw = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(depth + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(depth + i),
+            scaleDepthAVX2(raw, multiplier, rounding, shift));
+      }
+      scaleDepthSSE41(depth + i, count - i, factor);
+    }
+
+    __attribute__((target("avx2")))
+    void computeDepthStatisticsAVX2(uint16_t *depth, size_t count, const DepthScaleFactor *factor,
+        bool histogram, DepthFrameStatistics &stats)
+    {
+      const __m256i zero = _mm256_setzero_si256();
+      const __m256i multiplier = _mm256_set1_epi32(factor ? factor->multiplier : 0);
+      const __m256i rounding = _mm256_set1_epi32(factor ? (1u << factor->shift) >> 1 : 0);
+      const __m128i shift = _mm_cvtsi32_si128(factor ? factor->shift : 0);
+
+      __m256i min = _mm256_set1_epi16(-1);
+      __m256i max = zero;
+      __m256i sum = zero;
+      size_t invalid = 0;
+      uint16_t values[16];
+
+      size_t i = 0;
+      size_t block = 0;
+      for (; i + 16 <= count; i += 16)
+      {
+        __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(depth + i));
+        if (factor != NULL)
+        {
+          value = scaleDepthAVX2(value, multiplier, rounding, shift);
+          _mm256_storeu_si256(reinterpret_cast<__m256i *>(depth + i), value);
+        }
+
+        // Invalid pixels become 65535 for the minimum and add 0 to max and sum
+        __m256i invalid_mask = _mm256_cmpeq_epi16(value, zero);
+        min = _mm256_min_epu16(min, _mm256_or_si256(value, invalid_mask));
+        max = _mm256_max_epu16(max, value);
+        sum = _mm256_add_epi32(sum, _mm256_add_epi32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(value)),
+              _mm256_cvtepu16_epi32(_mm256_extracti128_si256(value, 1))));
+        invalid += __builtin_popcount(_mm256_movemask_epi8(invalid_mask)) / 2;
+
+        if (histogram)
+        {
+          // Invalid pixels land in bin 0 and are removed after the loop
+          _mm256_storeu_si256(reinterpret_cast<__m256i *>(values),
+              _mm256_srli_epi16(value, DEPTH_HISTOGRAM_BIN_SHIFT));
+          for (int j = 0; j < 16; ++j)
+          {
+            ++stats.histogram[std::min<int>(values[j], DEPTH_HISTOGRAM_BINS - 1)];
+          }
+        }
+
+        // Each 32-bit lane gains at most 2 * 65535 per iteration, flush before it can overflow
+        if (++block == 16384)
+        {
+          uint32_t lanes[8];
+          _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), sum);
+          for (int j = 0; j < 8; ++j)
+          {
+            stats.sum += lanes[j];
+          }
+          sum = zero;
+          block = 0;
+        }
+      }
+
+      uint16_t min_values[16];
+      uint16_t max_values[16];
+      uint32_t lanes[8];
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(min_values), min);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(max_values), max);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), sum);
+      for (int j = 0; j < 16; ++j)
+      {
+        stats.min = std::min(stats.min, min_values[j]);
+        stats.max = std::max(stats.max, max_values[j]);
+      }
+      for (int j = 0; j < 8; ++j)
+      {
+        stats.sum += lanes[j];
+      }
+      stats.valid += i - invalid;
+      stats.count += i;
+      if (histogram)
+      {
+        stats.histogram[0] -= invalid;
+      }
+
+      computeDepthStatisticsSSE41(depth + i, count - i, factor, histogram, stats);
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i decimateBlocksAVX2(__m256i a, __m256i b, __m256i c, __m256i d, DepthDecimationMode mode)
+    {
+      const __m256i zero = _mm256_setzero_si256();
+      __m256i a_invalid = _mm256_cmpeq_epi16(a, zero);
+      __m256i b_invalid = _mm256_cmpeq_epi16(b, zero);
+      __m256i c_invalid = _mm256_cmpeq_epi16(c, zero);
+      __m256i d_invalid = _mm256_cmpeq_epi16(d, zero);
+
+      if (mode == DEPTH_DECIMATION_MIN_VALID)
+      {
+        __m256i min = _mm256_min_epu16(
+            _mm256_min_epu16(_mm256_or_si256(a, a_invalid), _mm256_or_si256(b, b_invalid)),
+            _mm256_min_epu16(_mm256_or_si256(c, c_invalid), _mm256_or_si256(d, d_invalid)));
+        return _mm256_andnot_si256(_mm256_cmpeq_epi16(min, _mm256_set1_epi16(-1)), min);
+      }
+
+      __m256i t;
+      t = _mm256_min_epu16(a, b); b = _mm256_max_epu16(a, b); a = t;
+      t = _mm256_min_epu16(c, d); d = _mm256_max_epu16(c, d); c = t;
+      t = _mm256_min_epu16(a, c); c = _mm256_max_epu16(a, c); a = t;
+      t = _mm256_min_epu16(b, d); d = _mm256_max_epu16(b, d); b = t;
+      t = _mm256_min_epu16(b, c); c = _mm256_max_epu16(b, c); b = t;
+
+      __m256i invalid = _mm256_sub_epi16(_mm256_sub_epi16(zero, _mm256_add_epi16(a_invalid, b_invalid)),
+          _mm256_add_epi16(c_invalid, d_invalid));
+      __m256i result = b;
+      result = _mm256_blendv_epi8(result, c, _mm256_or_si256(_mm256_cmpeq_epi16(invalid, _mm256_set1_epi16(1)),
+            _mm256_cmpeq_epi16(invalid, _mm256_set1_epi16(2))));
+      result = _mm256_blendv_epi8(result, d, _mm256_cmpeq_epi16(invalid, _mm256_set1_epi16(3)));
+      return _mm256_andnot_si256(_mm256_cmpeq_epi16(invalid, _mm256_set1_epi16(4)), result);
+    }
+
+    __attribute__((target("avx2")))
+    void decimateRowsAVX2(const uint16_t *row0, const uint16_t *row1, size_t out_width, DepthDecimationMode mode,
+        uint16_t *out)
+    {
+      const __m256i low = _mm256_set1_epi32(0xFFFF);
+
+      size_t x = 0;
+      for (; x + 16 <= out_width; x += 16)
+      {
+        __m256i r00 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row0 + 2 * x));
+        __m256i r01 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row0 + 2 * x + 16));
+        __m256i r10 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row1 + 2 * x));
+        __m256i r11 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row1 + 2 * x + 16));
+
+        __m256i a = _mm256_packus_epi32(_mm256_and_si256(r00, low), _mm256_and_si256(r01, low));
+        __m256i b = _mm256_packus_epi32(_mm256_srli_epi32(r00, 16), _mm256_srli_epi32(r01, 16));
+        __m256i c = _mm256_packus_epi32(_mm256_and_si256(r10, low), _mm256_and_si256(r11, low));
+        __m256i d = _mm256_packus_epi32(_mm256_srli_epi32(r10, 16), _mm256_srli_epi32(r11, 16));
+        // packus works per 128-bit lane, restore the pixel order of the result
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x),
+            _mm256_permute4x64_epi64(decimateBlocksAVX2(a, b, c, d, mode), 0xD8));
+      }
+      decimateRowsSSE41(row0 + 2 * x, row1 + 2 * x, out_width - x, mode, out + x);
+    }
+#endif
+
+    /*
+     * Reduce 2x2 blocks of a depth image.
+     */
+    void decimateDepth2x2(const uint16_t *depth, uint32_t width, uint32_t height, size_t step,
+        DepthDecimationMode mode, uint16_t *out, size_t out_step)
+    {
+      InstructionSet instruction_set = getInstructionSet();
+      size_t out_width = width / 2;
+      for (uint32_t y = 0; y + 1 < height; y += 2)
+      {
+        const uint16_t *row0 = reinterpret_cast<const uint16_t *>(reinterpret_cast<const uint8_t *>(depth) + y * step);
+        const uint16_t *row1 = reinterpret_cast<const uint16_t *>(reinterpret_cast<const uint8_t *>(row0) + step);
+        uint16_t *out_row = reinterpret_cast<uint16_t *>(reinterpret_cast<uint8_t *>(out) + (y / 2) * out_step);
+        switch (instruction_set)
+        {
+#ifdef REALSENSE_CAMERA_X86_KERNELS
+          case INSTRUCTION_SET_AVX2:
+            decimateRowsAVX2(row0, row1, out_width, mode, out_row);
+            break;
+          case INSTRUCTION_SET_SSE41:
+            decimateRowsSSE41(row0, row1, out_width, mode, out_row);
+            break;
+#endif
+          default:
+            decimateRowsScalar(row0, row1, 0, out_width, mode, out_row);
+            break;
+        }
+      }
+    }
+  }  // namespace
+
+  /*
+   * Convert a floating point scale to a fixed-point factor.
+   */
+  DepthScaleFactor makeDepthScaleFactor(double scale)
+  {
+    // Use the largest shift that keeps the multiplier within 16 bits, so that
+    // raw * multiplier + rounding never overflows 32 bits and stays below 2^31.
+    DepthScaleFactor factor;
+    scale = std::max(0.0, std::min(scale, 32767.0));
+    factor.shift = 16;
+    while (factor.shift > 1 && std::llround(scale * (1u << factor.shift)) > 65535)
+    {
+      --factor.shift;
+    }
+    int64_t multiplier = std::llround(scale * (1u << factor.shift));
+    factor.multiplier = static_cast<uint32_t>(std::min<int64_t>(multiplier, 65535));
+    return factor;
+  }
+
+  /*
+   * Rescale a depth buffer in place.
+   */
+  void scaleDepth(uint16_t *depth, size_t count, const DepthScaleFactor &factor)
+  {
+    switch (getInstructionSet())
+    {
+#ifdef REALSENSE_CAMERA_X86_KERNELS
+      case INSTRUCTION_SET_AVX2:
+        scaleDepthAVX2(depth, count, factor);
+        break;
+      case INSTRUCTION_SET_SSE41:
+        scaleDepthSSE41(depth, count, factor);
+        break;
+#endif
+      default:
+        scaleDepthScalar(depth, count, factor);
+        break;
+    }
+  }
+
+  /*
+   * Compute the frame statistics, optionally fused with the rescale.
+   */
+  void computeDepthStatistics(uint16_t *depth, size_t count, const DepthScaleFactor *factor, bool histogram,
+      DepthFrameStatistics &stats)
+  {
+    stats.min = 65535;
+    stats.max = 0;
+    stats.sum = 0;
+    stats.valid = 0;
+    stats.count = 0;
+    memset(stats.histogram, 0, sizeof(stats.histogram));
+
+    switch (getInstructionSet())
+    {
+#ifdef REALSENSE_CAMERA_X86_KERNELS
+      case INSTRUCTION_SET_AVX2:
+        computeDepthStatisticsAVX2(depth, count, factor, histogram, stats);
+        break;
+      case INSTRUCTION_SET_SSE41:
+        computeDepthStatisticsSSE41(depth, count, factor, histogram, stats);
+        break;
+#endif
+      default:
+        computeDepthStatisticsScalar(depth, count, factor, histogram, stats);
+        break;
+    }
+  }
+
+  /*
+   * Reduce factor x factor blocks of a depth image.
+   */
+  void decimateDepth(const uint16_t *depth, uint32_t width, uint32_t height, size_t step, int factor,
+      DepthDecimationMode mode, uint16_t *out, size_t out_step, std::vector<uint16_t> &scratch)
+  {
+    if (factor == 4)
+    {
+      uint32_t half_width = width / 2;
+      uint32_t half_height = height / 2;
+      scratch.resize(static_cast<size_t>(half_width) * half_height);
+      decimateDepth2x2(depth, width, height, step, mode, scratch.data(), half_width * sizeof(uint16_t));
+      decimateDepth2x2(scratch.data(), half_width, half_height, half_width * sizeof(uint16_t), mode, out, out_step);
+    }
+    else
+    {
+      decimateDepth2x2(depth, width, height, step, mode, out, out_step);
+    }
+  }
+}  // namespace realsense_camera
@@ -0,0 +1,257 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <algorithm>
+#include <vector>
+
+#include <realsense_camera/device_registry.h>
+
+namespace realsense_camera
+{
+  /*
+   * Share one registry between all nodelets of the process.
+   */
+  std::shared_ptr<DeviceRegistry> DeviceRegistry::acquire()
+  {
+    static std::mutex instance_mutex;
+    static std::weak_ptr<DeviceRegistry> instance;
+
+    std::lock_guard<std::mutex> lock(instance_mutex);
+    std::shared_ptr<DeviceRegistry> registry = instance.lock();
+    if (!registry)
+    {
+      registry.reset(new DeviceRegistry());
+      instance = registry;
+    }
+    return registry;
+  }
+
+  DeviceRegistry::DeviceRegistry() :
+    context_(NULL),
+    generation_(0)
+  {
+  }
+
+  DeviceRegistry::~DeviceRegistry()
+  {
+    if (context_ != NULL)
+    {
+      rs_error *error = NULL;
+      rs_delete_context(context_, &error);
+      if (error)
+      {
+        rs_free_error(error);
+      }
+    }
+  }
+
+  /*
+   * Read the identity and firmware of a device. Safe to call for different devices concurrently.
+   */
+  void DeviceRegistry::probeDevice(rs_device *device, Device &info, rs_error **error)
+  {
+    const char *value = rs_get_device_serial(device, error);
+    if (*error == NULL)
+    {
+      info.serial_no = value;
+      value = rs_get_device_usb_port_id(device, error);
+    }
+    if (*error == NULL)
+    {
+      info.usb_port_id = value;
+      value = rs_get_device_name(device, error);
+    }
+    if (*error == NULL)
+    {
+      info.name = value;
+      value = rs_get_device_firmware_version(device, error);
+    }
+    if (*error == NULL)
+    {
+      info.camera_fw = value;
+      if (rs_supports(device, RS_CAPABILITIES_ADAPTER_BOARD, error) && *error == NULL)
+      {
+        value = rs_get_device_info(device, RS_CAMERA_INFO_ADAPTER_BOARD_FIRMWARE_VERSION, error);
+        if (*error == NULL)
+        {
+          info.adapter_fw = value;
+        }
+      }
+    }
+    if (*error == NULL)
+    {
+      if (rs_supports(device, RS_CAPABILITIES_MOTION_EVENTS, error) && *error == NULL)
+      {
+        value = rs_get_device_info(device, RS_CAMERA_INFO_MOTION_MODULE_FIRMWARE_VERSION, error);
+        if (*error == NULL)
+        {
+          info.motion_module_fw = value;
+        }
+      }
+    }
+  }
+
+  /*
+   * Enumerate once per generation; callers that wait on the mutex get the list of the first.
+   */
+  bool DeviceRegistry::scan(WorkerPool &pool, uint64_t &generation, rs_error **error)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (generation_ > 0 && generation_ != generation)
+    {
+      generation = generation_;
+      return false;
+    }
+    generation_++;
+    generation = generation_;
+
+    // Unassigned devices of the previous enumeration are replaced by those listed now.
+    std::vector<Device> assigned;
+    for (const Device &device : devices_)
+    {
+      if (!device.owner.empty())
+      {
+        assigned.push_back(device);
+      }
+    }
+    devices_ = assigned;
+
+    if (context_ == NULL)
+    {
+      context_ = rs_create_context(RS_API_VERSION, error);
+      if (*error)
+      {
+        context_ = NULL;
+        return true;
+      }
+    }
+    int count = rs_get_device_count(context_, error);
+    if (*error)
+    {
+      return true;
+    }
+
+    // Devices in use keep their entry; they may be streaming, so only the others are probed.
+    std::vector<Device> found(count);
+    std::vector<rs_error *> errors(count, NULL);
+    pool.parallelFor(count, 1, [&](size_t begin, size_t end)  // NOLINT(build/c++11)
+    {
+      for (size_t i = begin; i < end; i++)
+      {
+        rs_device *device = rs_get_device(context_, static_cast<int>(i), &errors[i]);
+        if (errors[i] != NULL)
+        {
+          continue;
+        }
+        std::vector<Device>::const_iterator in_use = std::find_if(assigned.begin(), assigned.end(),
+            [&](const Device &entry) { return entry.device == device; });  // NOLINT(build/c++11)
+        if (in_use != assigned.end())
+        {
+          found[i] = *in_use;
+          continue;
+        }
+        found[i].device = device;
+        probeDevice(device, found[i], &errors[i]);
+      }
+    });
+
+    // Keep the devices that answered and return the first error.
+    std::vector<Device> enumerated;
+    for (int i = 0; i < count; i++)
+    {
+      if (errors[i] != NULL)
+      {
+        if (*error == NULL)
+        {
+          *error = errors[i];
+        }
+        else
+        {
+          rs_free_error(errors[i]);
+        }
+        continue;
+      }
+      std::vector<Device>::iterator in_use = std::find_if(assigned.begin(), assigned.end(),
+          [&](const Device &device) { return device.device == found[i].device; });  // NOLINT(build/c++11)
+      if (in_use != assigned.end())
+      {
+        assigned.erase(in_use);
+      }
+      enumerated.push_back(found[i]);
+    }
+    // Devices in use that are no longer listed stay assigned until their nodelet releases them.
+    enumerated.insert(enumerated.end(), assigned.begin(), assigned.end());
+    devices_.swap(enumerated);
+    return true;
+  }
+
+  std::vector<DeviceRegistry::Device> DeviceRegistry::getDevices()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return devices_;
+  }
+
+  /*
+   * Hand out a device to a single nodelet.
+   */
+  rs_device *DeviceRegistry::assign(const std::string &owner, const std::string &camera_type,
+      const std::string &serial_no, const std::string &usb_port_id, std::string &assigned_to)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    assigned_to.clear();
+    for (Device &device : devices_)
+    {
+      if (device.name.find(camera_type) != std::string::npos &&
+          (serial_no.empty() || serial_no == device.serial_no) &&
+          (usb_port_id.empty() || usb_port_id == device.usb_port_id))
+      {
+        if (device.owner.empty())
+        {
+          device.owner = owner;
+          return device.device;
+        }
+        assigned_to = device.owner;
+      }
+    }
+    return NULL;
+  }
+
+  void DeviceRegistry::release(rs_device *device)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Device &entry : devices_)
+    {
+      if (entry.device == device)
+      {
+        entry.owner.clear();
+      }
+    }
+  }
+}  // namespace realsense_camera
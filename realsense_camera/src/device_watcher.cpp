@@ -0,0 +1,162 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstring>
+#include <thread>  // NOLINT(build/c++11)
+
+#include <realsense_camera/device_watcher.h>
+
+namespace realsense_camera
+{
+namespace
+{
+  const char DEVICE_DIR[] = "/dev";
+  const char VIDEO_PREFIX[] = "video";
+}
+
+  DeviceWatcher::DeviceWatcher() :
+    fd_(-1),
+    watch_(-1)
+  {
+  }
+
+  DeviceWatcher::~DeviceWatcher()
+  {
+    close();
+  }
+
+  /*
+   * Add an inotify watch for nodes created in /dev.
+   */
+  bool DeviceWatcher::open()
+  {
+    close();
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0)
+    {
+      return false;
+    }
+    watch_ = inotify_add_watch(fd_, DEVICE_DIR, IN_CREATE | IN_ATTRIB);
+    if (watch_ < 0)
+    {
+      close();
+      return false;
+    }
+    return true;
+  }
+
+  /*
+   * Remove the watch.
+   */
+  void DeviceWatcher::close()
+  {
+    if (fd_ >= 0)
+    {
+      ::close(fd_);  // also removes the watch
+    }
+    fd_ = -1;
+    watch_ = -1;
+  }
+
+  /*
+   * Drain the pending events; true when one of them is for a video node.
+   * IN_ATTRIB covers udev changing the permissions of a node after it was created.
+   */
+  bool DeviceWatcher::readEvents()
+  {
+    bool video = false;
+    alignas(struct inotify_event) char buffer[4096];
+    ssize_t length;
+    while ((length = read(fd_, buffer, sizeof(buffer))) > 0)
+    {
+      for (char *ptr = buffer; ptr < buffer + length;)
+      {
+        const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(ptr);
+        if (event->len > 0 && strncmp(event->name, VIDEO_PREFIX, sizeof(VIDEO_PREFIX) - 1) == 0)
+        {
+          video = true;
+        }
+        ptr += sizeof(struct inotify_event) + event->len;
+      }
+    }
+    return video;
+  }
+
+  /*
+   * Wait for a video node, then for the device nodes to settle.
+   */
+  bool DeviceWatcher::wait(double timeout, double settle)
+  {
+    typedef std::chrono::steady_clock clock;
+    clock::time_point deadline = clock::now() + std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(std::max(timeout, 0.0)));
+    if (fd_ < 0)
+    {
+      std::this_thread::sleep_until(deadline);
+      return false;
+    }
+
+    bool appeared = false;
+    while (true)
+    {
+      clock::time_point now = clock::now();
+      if (appeared == false && now >= deadline)
+      {
+        return false;
+      }
+      int timeout_ms = appeared ? static_cast<int>(settle * 1000.0) :
+          static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count()) + 1;
+
+      struct pollfd pfd = {fd_, POLLIN, 0};
+      int ready = poll(&pfd, 1, timeout_ms);
+      if (ready < 0 && errno != EINTR)
+      {
+        close();
+        std::this_thread::sleep_until(deadline);
+        return false;
+      }
+      if (ready == 0 && appeared == true)
+      {
+        return true;  // quiet for the settle time
+      }
+      if (ready > 0 && readEvents() == true)
+      {
+        appeared = true;
+      }
+    }
+  }
+}  // namespace realsense_camera
@@ -60,41 +60,6 @@ namespace realsense_camera
     BaseNodelet::onInit();
   }
 
-  /*
-   * Determine fastest stream -- overrides base class
-   */
-  void F200Nodelet::setStreams()
-  {
-    // enable camera streams
-    BaseNodelet::setStreams();
-
-    // Find the fastest updating, enabled stream
-    fastest_stream_ = RS_STREAM_DEPTH;  // default to depth
-
-    if (fps_[RS_STREAM_COLOR] > fps_[RS_STREAM_DEPTH])
-    {
-      if (enable_[RS_STREAM_COLOR])
-      {
-        fastest_stream_ = RS_STREAM_COLOR;
-      }
-    }
-  }
-
-  /*
-   * Determine the timestamp for the publish topic. -- overrides base class
-   */
-  ros::Time F200Nodelet::getTimestamp(rs_stream stream_index, double frame_ts)
-  {
-    static ros::Time last_common_stamp = ros::Time::now();
-
-    if (stream_index == fastest_stream_)
-    {
-      last_common_stamp = ros::Time::now();
-    }
-
-    return last_common_stamp;
-  }
-
   /*
    * Set Dynamic Reconfigure Server and return the dynamic params.
    */
@@ -131,30 +96,47 @@ namespace realsense_camera
   {
     ROS_INFO_STREAM(nodelet_name_ << " - Setting dynamic camera options");
 
-    // set the depth enable
+    // set the stream profiles, then the depth enable, which restarts the camera once for all of them
+    setStreamProfile(RS_STREAM_DEPTH, config.depth_width, config.depth_height, config.depth_fps);
+    setStreamProfile(RS_STREAM_COLOR, config.rgb_width, config.rgb_height, config.rgb_fps);
     BaseNodelet::setDepthEnable(config.enable_depth);
 
+    // set the depth filters
+    DepthFilterSettings filters;
+    filters.enable_spatial = config.enable_spatial_filter;
+    filters.spatial_alpha = config.spatial_filter_alpha;
+    filters.spatial_delta = config.spatial_filter_delta;
+    filters.spatial_iterations = config.spatial_filter_iterations;
+    filters.enable_temporal = config.enable_temporal_filter;
+    filters.temporal_alpha = config.temporal_filter_alpha;
+    filters.temporal_delta = config.temporal_filter_delta;
+    filters.temporal_persistence = config.temporal_filter_persistence;
+    filters.enable_hole_filling = config.enable_hole_filling;
+    filters.hole_filling_mode = static_cast<HoleFillingMode>(config.hole_filling_mode);
+    BaseNodelet::setDepthFilters(filters);
+
     // Set common options
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_BACKLIGHT_COMPENSATION, config.color_backlight_compensation, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_BRIGHTNESS, config.color_brightness, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_CONTRAST, config.color_contrast, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_GAIN, config.color_gain, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_GAMMA, config.color_gamma, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_HUE, config.color_hue, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_SATURATION, config.color_saturation, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_SHARPNESS, config.color_sharpness, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_ENABLE_AUTO_WHITE_BALANCE,
-        config.color_enable_auto_white_balance, 0);
+    queueCameraOption(RS_OPTION_COLOR_BACKLIGHT_COMPENSATION, config.color_backlight_compensation);
+    queueCameraOption(RS_OPTION_COLOR_BRIGHTNESS, config.color_brightness);
+    queueCameraOption(RS_OPTION_COLOR_CONTRAST, config.color_contrast);
+    queueCameraOption(RS_OPTION_COLOR_GAIN, config.color_gain);
+    queueCameraOption(RS_OPTION_COLOR_GAMMA, config.color_gamma);
+    queueCameraOption(RS_OPTION_COLOR_HUE, config.color_hue);
+    queueCameraOption(RS_OPTION_COLOR_SATURATION, config.color_saturation);
+    queueCameraOption(RS_OPTION_COLOR_SHARPNESS, config.color_sharpness);
+    queueCameraOption(RS_OPTION_COLOR_ENABLE_AUTO_WHITE_BALANCE, config.color_enable_auto_white_balance);
     if (config.color_enable_auto_white_balance == 0)
     {
-      rs_set_device_option(rs_device_, RS_OPTION_COLOR_WHITE_BALANCE, config.color_white_balance, 0);
+      queueCameraOption(RS_OPTION_COLOR_WHITE_BALANCE, config.color_white_balance);
     }
 
     // Set F200 specific options
-    rs_set_device_option(rs_device_, RS_OPTION_F200_LASER_POWER, config.f200_laser_power, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_F200_ACCURACY, config.f200_accuracy, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_F200_MOTION_RANGE, config.f200_motion_range, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_F200_FILTER_OPTION, config.f200_filter_option, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_F200_CONFIDENCE_THRESHOLD, config.f200_confidence_threshold, 0);
+    queueCameraOption(RS_OPTION_F200_LASER_POWER, config.f200_laser_power);
+    queueCameraOption(RS_OPTION_F200_ACCURACY, config.f200_accuracy);
+    queueCameraOption(RS_OPTION_F200_MOTION_RANGE, config.f200_motion_range);
+    queueCameraOption(RS_OPTION_F200_FILTER_OPTION, config.f200_filter_option);
+    queueCameraOption(RS_OPTION_F200_CONFIDENCE_THRESHOLD, config.f200_confidence_threshold);
+
+    applyCameraOptions();
   }
 }  // namespace realsense_camera
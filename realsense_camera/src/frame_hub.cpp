@@ -0,0 +1,172 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <realsense_camera/frame_hub.h>
+
+namespace realsense_camera
+{
+  /*
+   * Share one hub between all nodelets of the process.
+   */
+  std::shared_ptr<FrameHub> FrameHub::acquire()
+  {
+    static std::mutex instance_mutex;
+    static std::weak_ptr<FrameHub> instance;
+
+    std::lock_guard<std::mutex> lock(instance_mutex);
+    std::shared_ptr<FrameHub> hub = instance.lock();
+    if (!hub)
+    {
+      hub = std::make_shared<FrameHub>();
+      instance = hub;
+    }
+    return hub;
+  }
+
+  /*
+   * Tell a source which of its streams and whether its framesets are wanted; the caller holds
+   * the mutex.
+   */
+  void FrameHub::notifyDemand(const std::string &source)
+  {
+    for (const Source &entry : sources_)
+    {
+      if (entry.name != source)
+      {
+        continue;
+      }
+      std::vector<bool> wanted(entry.stream_count, false);
+      for (const Sink &sink : sinks_)
+      {
+        if (sink.source == source && sink.stream >= 0 && sink.stream < entry.stream_count)
+        {
+          wanted[sink.stream] = true;
+        }
+      }
+      bool framesets_wanted = std::any_of(listeners_.begin(), listeners_.end(),
+          [&](const Listener &listener) { return listener.aggregator == source; });  // NOLINT(build/c++11)
+      entry.demand_changed(wanted, framesets_wanted);
+    }
+  }
+
+  void FrameHub::addSource(const std::string &source, int stream_count, const DemandCallback &demand_changed)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sources_.push_back({source, stream_count, demand_changed});
+    notifyDemand(source);
+  }
+
+  void FrameHub::removeSource(const std::string &source)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sources_.erase(std::remove_if(sources_.begin(), sources_.end(),
+        [&](const Source &entry) { return entry.name == source; }), sources_.end());  // NOLINT(build/c++11)
+  }
+
+  /*
+   * Pass the frame on to every sink of the source stream.
+   */
+  void FrameHub::publish(const std::string &source, int stream, const sensor_msgs::ImageConstPtr &image,
+      const sensor_msgs::CameraInfoConstPtr &camera_info)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Sink &sink : sinks_)
+    {
+      if (sink.stream == stream && sink.source == source)
+      {
+        sink.callback(image, camera_info);
+      }
+    }
+  }
+
+  int FrameHub::addSink(const std::string &source, int stream, const FrameCallback &callback)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int id = next_id_++;
+    sinks_.push_back({id, source, stream, callback});
+    notifyDemand(source);
+    return id;
+  }
+
+  void FrameHub::removeSink(int id)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < sinks_.size(); i++)
+    {
+      if (sinks_[i].id == id)
+      {
+        std::string source = sinks_[i].source;
+        sinks_.erase(sinks_.begin() + i);
+        notifyDemand(source);
+        return;
+      }
+    }
+  }
+
+  int FrameHub::addFramesetListener(const std::string &aggregator, const FramesetCallback &callback)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int id = next_id_++;
+    listeners_.push_back({id, aggregator, callback});
+    notifyDemand(aggregator);
+    return id;
+  }
+
+  void FrameHub::removeFramesetListener(int id)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < listeners_.size(); i++)
+    {
+      if (listeners_[i].id == id)
+      {
+        std::string aggregator = listeners_[i].aggregator;
+        listeners_.erase(listeners_.begin() + i);
+        notifyDemand(aggregator);
+        return;
+      }
+    }
+  }
+
+  void FrameHub::publishFrameset(const std::string &aggregator, const AlignedFrameset &frameset)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Listener &listener : listeners_)
+    {
+      if (listener.aggregator == aggregator)
+      {
+        listener.callback(frameset);
+      }
+    }
+  }
+}  // namespace realsense_camera
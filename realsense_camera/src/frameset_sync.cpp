@@ -0,0 +1,159 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <algorithm>
+#include <vector>
+
+#include <realsense_camera/frameset_sync.h>
+
+namespace realsense_camera
+{
+  /*
+   * Set the streams to match and drop the pending sets. Frames match when their stamps
+   * are within the tolerance.
+   */
+  void FramesetSynchronizer::configure(const std::vector<int> &streams, double tolerance_sec, size_t max_pending)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    streams_ = streams;
+    slot_.clear();
+    for (size_t i = 0; i < streams_.size(); i++)
+    {
+      if (static_cast<size_t>(streams_[i]) >= slot_.size())
+      {
+        slot_.resize(streams_[i] + 1, -1);
+      }
+      slot_[streams_[i]] = static_cast<int>(i);
+    }
+    tolerance_ = ros::Duration(tolerance_sec);
+    max_pending_ = std::max(max_pending, static_cast<size_t>(1));
+    pending_.clear();
+  }
+
+  /*
+   * Add the frame of a stream and its camera info. Returns true when it completed a set, which
+   * is then returned in the order of the configured streams, stamped with its first frame.
+   */
+  bool FramesetSynchronizer::add(int stream, const sensor_msgs::ImageConstPtr &image,
+      const sensor_msgs::CameraInfoConstPtr &camera_info, AlignedFrameset &frameset)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stream < 0 || static_cast<size_t>(stream) >= slot_.size() || slot_[stream] < 0)
+    {
+      return false;
+    }
+    int slot = slot_[stream];
+
+    size_t best = pending_.size();
+    ros::Duration best_distance = tolerance_;
+    for (size_t i = 0; i < pending_.size(); i++)
+    {
+      if (pending_[i].images[slot])
+      {
+        continue;
+      }
+      ros::Duration distance = (pending_[i].stamp > image->header.stamp) ? pending_[i].stamp - image->header.stamp :
+          image->header.stamp - pending_[i].stamp;
+      if (distance <= best_distance)
+      {
+        best = i;
+        best_distance = distance;
+      }
+    }
+
+    if (best == pending_.size())
+    {
+      PendingSet pending;
+      pending.images.resize(streams_.size());
+      pending.camera_infos.resize(streams_.size());
+      pending.count = 0;
+      pending.stamp = image->header.stamp;
+      pending.first_arrival = std::chrono::steady_clock::now();
+      pending_.push_back(std::move(pending));
+      if (pending_.size() > max_pending_)
+      {
+        dropPending(1);
+      }
+      best = pending_.size() - 1;
+    }
+
+    PendingSet &pending = pending_[best];
+    pending.images[slot] = image;
+    pending.camera_infos[slot] = camera_info;
+    if (++pending.count < streams_.size())
+    {
+      return false;
+    }
+
+    double wait_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+        pending.first_arrival).count();
+    stats_.matched++;
+    stats_.total_wait_ms += wait_ms;
+    stats_.max_wait_ms = std::max(stats_.max_wait_ms, wait_ms);
+    frameset.stamp = pending.stamp;
+    frameset.images.swap(pending.images);
+    frameset.camera_infos.swap(pending.camera_infos);
+    ros::Time oldest = frameset.images[0]->header.stamp;
+    ros::Time newest = oldest;
+    for (const sensor_msgs::ImageConstPtr &frame : frameset.images)
+    {
+      oldest = std::min(oldest, frame->header.stamp);
+      newest = std::max(newest, frame->header.stamp);
+    }
+    frameset.skew_ms = (newest - oldest).toSec() * 1000.0;
+    dropPending(best);
+    pending_.pop_front();
+    return true;
+  }
+
+  /*
+   * Drop the oldest pending sets, counting their frames as unmatched.
+   */
+  void FramesetSynchronizer::dropPending(size_t count)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      stats_.unmatched_frames += pending_.front().count;
+      pending_.pop_front();
+    }
+  }
+
+  /*
+   * Return the statistics since the last call and restart them.
+   */
+  FramesetSynchronizer::Statistics FramesetSynchronizer::takeStatistics()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Statistics stats = stats_;
+    stats.streams = streams_.size();
+    stats_ = {0, 0, 0, 0.0, 0.0};
+    return stats;
+  }
+}  // namespace realsense_camera
@@ -0,0 +1,121 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <string>
+
+#include <realsense_camera/image_pool.h>
+#include <realsense_camera/image_utils.h>
+
+namespace realsense_camera
+{
+  /*
+   * Set the buffer geometry and the memory cap, dropping buffers of the previous geometry.
+   */
+  void ImagePool::configure(uint32_t width, uint32_t height, uint32_t step, const std::string &encoding,
+      size_t memory_cap)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    width_ = width;
+    height_ = height;
+    step_ = step;
+    encoding_ = encoding;
+
+    size_t buffer_size = static_cast<size_t>(height) * step;
+    max_buffers_ = (buffer_size > 0) ? memory_cap / buffer_size : 0;
+
+    // Buffers still held by subscribers are freed when they are released.
+    buffers_.clear();
+    buffers_.reserve(max_buffers_);
+    next_ = 0;
+  }
+
+  /*
+   * Get a buffer that no subscriber holds anymore, allocating only when all are in use.
+   */
+  sensor_msgs::ImagePtr ImagePool::acquire()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // Round-robin scan so recently published buffers are checked last
+    for (size_t i = 0; i < buffers_.size(); ++i)
+    {
+      size_t index = (next_ + i) % buffers_.size();
+      if (buffers_[index].use_count() == 1)
+      {
+        next_ = (index + 1) % buffers_.size();
+        ++hits_;
+        return buffers_[index];
+      }
+    }
+
+    ++misses_;
+    sensor_msgs::ImagePtr image = allocate();
+    if (buffers_.size() < max_buffers_)
+    {
+      buffers_.push_back(image);
+    }
+    // else the pool is at its memory cap and the buffer is freed after publishing
+    return image;
+  }
+
+  /*
+   * Get the pool counters.
+   */
+  ImagePool::Statistics ImagePool::getStatistics()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    Statistics stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.outstanding = 0;
+    stats.pooled = buffers_.size();
+    stats.pooled_bytes = buffers_.size() * static_cast<size_t>(height_) * step_;
+    for (sensor_msgs::ImagePtr &buffer : buffers_)
+    {
+      if (buffer.use_count() > 1)
+      {
+        ++stats.outstanding;
+      }
+    }
+    return stats;
+  }
+
+  /*
+   * Allocate a buffer of the configured geometry.
+   */
+  sensor_msgs::ImagePtr ImagePool::allocate()
+  {
+    sensor_msgs::ImagePtr image = boost::make_shared<sensor_msgs::Image>();
+    prepareImageMessage(*image, width_, height_, step_, encoding_);
+    return image;
+  }
+}  // namespace realsense_camera
@@ -0,0 +1,92 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <cstring>
+#include <string>
+#include <algorithm>
+
+#include <boost/make_shared.hpp>
+
+#include <realsense_camera/image_utils.h>
+
+namespace realsense_camera
+{
+  /*
+   * Set the image message geometry and size its data buffer.
+   */
+  void prepareImageMessage(sensor_msgs::Image &image, int width, int height, int step, const std::string &encoding)
+  {
+    image.width = width;
+    image.height = height;
+    image.step = step;
+    image.encoding = encoding;
+    image.is_bigendian = false;
+
+    size_t size = static_cast<size_t>(height) * step;
+    if (image.data.size() != size)
+    {
+      image.data.resize(size);
+    }
+  }
+
+  /*
+   * Copy a librealsense frame buffer into a prepared image message.
+   */
+  size_t copyFrameToImage(const void *frame_data, int frame_step, sensor_msgs::Image &image)
+  {
+    const uint8_t *src = static_cast<const uint8_t *>(frame_data);
+    uint8_t *dst = image.data.data();
+
+    if (frame_step == static_cast<int>(image.step))
+    {
+      // Contiguous frame, copy in one pass
+      memcpy(dst, src, image.data.size());
+      return image.data.size();
+    }
+
+    // Padded rows, copy only the visible part of each row
+    size_t row_size = std::min(static_cast<size_t>(frame_step), static_cast<size_t>(image.step));
+    for (uint32_t row = 0; row < image.height; ++row)
+    {
+      memcpy(dst + row * image.step, src + row * frame_step, row_size);
+    }
+    return row_size * image.height;
+  }
+
+  /*
+   * Copy a camera info for one frame.
+   */
+  sensor_msgs::CameraInfoPtr stampCameraInfo(const sensor_msgs::CameraInfo &info, const ros::Time &stamp)
+  {
+    sensor_msgs::CameraInfoPtr frame_info = boost::make_shared<sensor_msgs::CameraInfo>(info);
+    frame_info->header.stamp = stamp;
+    return frame_info;
+  }
+}  // namespace realsense_camera
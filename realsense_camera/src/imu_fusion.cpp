@@ -0,0 +1,229 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <algorithm>
+#include <vector>
+
+#include <realsense_camera/imu_fusion.h>
+
+namespace realsense_camera
+{
+  namespace
+  {
+    const size_t ACCEL_HISTORY = 16;
+    const size_t MAX_PENDING_GYRO = 64;
+
+    /*
+     * Slope of the accel at sample k from its neighbours, per ms; one-sided at the ends of
+     * the history and across gaps.
+     */
+    void accelSlope(const std::deque<MotionSample> &accel, size_t k, double max_gap_ms, double slope[3])
+    {
+      size_t before = (k > 0 && accel[k].timestamp - accel[k - 1].timestamp <= max_gap_ms) ? k - 1 : k;
+      size_t after = (k + 1 < accel.size() && accel[k + 1].timestamp - accel[k].timestamp <= max_gap_ms) ? k + 1 : k;
+      double dt = accel[after].timestamp - accel[before].timestamp;
+      for (int axis = 0; axis < 3; axis++)
+      {
+        slope[axis] = (dt > 0.0) ? (accel[after].axes[axis] - accel[before].axes[axis]) / dt : 0.0;
+      }
+    }
+  }  // namespace
+
+  void calibrateMotionSamples(const float matrix[3][4], MotionSample *samples, size_t count)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      float *axes = samples[i].axes;
+      float x = axes[0];
+      float y = axes[1];
+      float z = axes[2];
+      for (int row = 0; row < 3; row++)
+      {
+        axes[row] = matrix[row][0] * x + matrix[row][1] * y + matrix[row][2] * z - matrix[row][3];
+      }
+    }
+  }
+
+  /*
+   * Set the interpolation and the widest accel gap to interpolate across, and restart.
+   */
+  void MotionFusion::configure(MotionInterpolation interpolation, double max_gap_ms)
+  {
+    interpolation_ = interpolation;
+    max_gap_ms_ = max_gap_ms;
+    reset();
+  }
+
+  void MotionFusion::reset()
+  {
+    accel_.clear();
+    pending_gyro_.clear();
+  }
+
+  /*
+   * Add accel samples in time order and return the gyro samples they complete.
+   */
+  void MotionFusion::addAccel(const MotionSample *samples, size_t count, std::vector<FusedMotionSample> &fused)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      if (!accel_.empty() && samples[i].timestamp <= accel_.back().timestamp)
+      {
+        if (samples[i].timestamp == accel_.back().timestamp)
+        {
+          continue;
+        }
+        // The device timestamps restarted.
+        accel_.clear();
+      }
+      accel_.push_back(samples[i]);
+      if (accel_.size() > ACCEL_HISTORY)
+      {
+        accel_.pop_front();
+      }
+      process(fused);
+    }
+  }
+
+  /*
+   * Add gyro samples in time order and return those that can already be paired.
+   */
+  void MotionFusion::addGyro(const MotionSample *samples, size_t count, std::vector<FusedMotionSample> &fused)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      if (!pending_gyro_.empty() && samples[i].timestamp <= pending_gyro_.back().timestamp)
+      {
+        dropped_ += pending_gyro_.size();
+        pending_gyro_.clear();
+      }
+      pending_gyro_.push_back(samples[i]);
+      if (pending_gyro_.size() > MAX_PENDING_GYRO)
+      {
+        pending_gyro_.pop_front();
+        dropped_++;
+      }
+    }
+    process(fused);
+  }
+
+  uint64_t MotionFusion::getDropped() const
+  {
+    return dropped_;
+  }
+
+  /*
+   * Pair the waiting gyro samples, oldest first, until one needs a later accel sample.
+   */
+  void MotionFusion::process(std::vector<FusedMotionSample> &fused)
+  {
+    while (!pending_gyro_.empty())
+    {
+      FusedMotionSample out;
+      Result result = interpolate(pending_gyro_.front(), out);
+      if (result == WAIT)
+      {
+        return;
+      }
+      if (result == FUSED)
+      {
+        fused.push_back(out);
+      }
+      else
+      {
+        dropped_++;
+      }
+      pending_gyro_.pop_front();
+    }
+  }
+
+  MotionFusion::Result MotionFusion::interpolate(const MotionSample &gyro, FusedMotionSample &out) const
+  {
+    double t = gyro.timestamp;
+    if (accel_.empty() || t < accel_.front().timestamp)
+    {
+      return DROP;
+    }
+    if (t > accel_.back().timestamp)
+    {
+      return WAIT;
+    }
+
+    // accel_[i] <= t < accel_[i + 1], or t is the last accel sample
+    size_t i = std::upper_bound(accel_.begin(), accel_.end(), t,
+        [](double value, const MotionSample &sample) { return value < sample.timestamp; }) -  // NOLINT(build/c++11)
+        accel_.begin() - 1;
+    out.timestamp = t;
+    std::copy(gyro.axes, gyro.axes + 3, out.angular_velocity);
+    if (i + 1 == accel_.size())
+    {
+      std::copy(accel_[i].axes, accel_[i].axes + 3, out.linear_acceleration);
+      return FUSED;
+    }
+
+    double gap = accel_[i + 1].timestamp - accel_[i].timestamp;
+    if (gap > max_gap_ms_)
+    {
+      return DROP;
+    }
+    double u = (t - accel_[i].timestamp) / gap;
+
+    if (interpolation_ == MOTION_INTERPOLATION_CUBIC)
+    {
+      if (i + 2 == accel_.size())
+      {
+        // The slope at the next sample needs the sample after it.
+        return WAIT;
+      }
+      double slope_start[3];
+      double slope_end[3];
+      accelSlope(accel_, i, max_gap_ms_, slope_start);
+      accelSlope(accel_, i + 1, max_gap_ms_, slope_end);
+      double u2 = u * u;
+      double u3 = u2 * u;
+      double h00 = 2.0 * u3 - 3.0 * u2 + 1.0;
+      double h10 = u3 - 2.0 * u2 + u;
+      double h01 = -2.0 * u3 + 3.0 * u2;
+      double h11 = u3 - u2;
+      for (int axis = 0; axis < 3; axis++)
+      {
+        out.linear_acceleration[axis] = h00 * accel_[i].axes[axis] + h10 * gap * slope_start[axis] +
+            h01 * accel_[i + 1].axes[axis] + h11 * gap * slope_end[axis];
+      }
+      return FUSED;
+    }
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+      out.linear_acceleration[axis] = accel_[i].axes[axis] + u * (accel_[i + 1].axes[axis] - accel_[i].axes[axis]);
+    }
+    return FUSED;
+  }
+}  // namespace realsense_camera
@@ -0,0 +1,165 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <algorithm>
+#include <vector>
+
+#include <realsense_camera/multi_camera_sync.h>
+
+namespace realsense_camera
+{
+  /*
+   * Set the number of channels and the frames kept per channel, and drop the kept frames.
+   */
+  void MultiCameraSynchronizer::configure(size_t channels, size_t history, double max_skew_sec)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    channels_.clear();
+    channels_.resize(channels);
+    history_ = std::max(history, static_cast<size_t>(1));
+    max_skew_ = ros::Duration(max_skew_sec);
+    last_stamp_ = ros::Time();
+  }
+
+  /*
+   * Keep the frame of a channel. Only the pointers are stored; frames that arrive out of
+   * order are dropped.
+   */
+  void MultiCameraSynchronizer::add(size_t channel, const sensor_msgs::ImageConstPtr &image,
+      const sensor_msgs::CameraInfoConstPtr &camera_info)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (channel >= channels_.size())
+    {
+      return;
+    }
+    std::deque<Frame> &frames = channels_[channel];
+    if (!frames.empty() && image->header.stamp <= frames.back().image->header.stamp)
+    {
+      return;
+    }
+    frames.push_back({image, camera_info});
+    if (frames.size() > history_)
+    {
+      frames.pop_front();
+    }
+  }
+
+  /*
+   * Pick the frame of every channel nearest to the newest time all channels have reached.
+   * Returns false when a channel has no frames, when the frames are further apart than the
+   * allowed skew, or when no channel advanced since the last set.
+   */
+  bool MultiCameraSynchronizer::collect(AlignedFrameset &frameset)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (channels_.empty())
+    {
+      return false;
+    }
+
+    ros::Time target;
+    for (size_t i = 0; i < channels_.size(); i++)
+    {
+      if (channels_[i].empty())
+      {
+        stats_.incomplete++;
+        return false;
+      }
+      const ros::Time &newest = channels_[i].back().image->header.stamp;
+      if (i == 0 || newest < target)
+      {
+        target = newest;
+      }
+    }
+    if (target <= last_stamp_)
+    {
+      stats_.stale++;
+      return false;
+    }
+
+    frameset.images.resize(channels_.size());
+    frameset.camera_infos.resize(channels_.size());
+    ros::Time oldest, newest;
+    for (size_t i = 0; i < channels_.size(); i++)
+    {
+      const Frame *best = NULL;
+      ros::Duration best_distance;
+      for (const Frame &frame : channels_[i])
+      {
+        const ros::Time &stamp = frame.image->header.stamp;
+        ros::Duration distance = (stamp > target) ? stamp - target : target - stamp;
+        if (best == NULL || distance < best_distance)
+        {
+          best = &frame;
+          best_distance = distance;
+        }
+      }
+      frameset.images[i] = best->image;
+      frameset.camera_infos[i] = best->camera_info;
+      const ros::Time &stamp = best->image->header.stamp;
+      if (i == 0 || stamp < oldest)
+      {
+        oldest = stamp;
+      }
+      if (i == 0 || stamp > newest)
+      {
+        newest = stamp;
+      }
+    }
+
+    ros::Duration skew = newest - oldest;
+    if (skew > max_skew_)
+    {
+      stats_.skewed++;
+      return false;
+    }
+
+    double skew_ms = skew.toSec() * 1000.0;
+    frameset.stamp = target;
+    frameset.skew_ms = skew_ms;
+    last_stamp_ = target;
+    stats_.collected++;
+    stats_.total_skew_ms += skew_ms;
+    stats_.max_skew_ms = std::max(stats_.max_skew_ms, skew_ms);
+    return true;
+  }
+
+  /*
+   * Return the statistics since the last call and restart them.
+   */
+  MultiCameraSynchronizer::Statistics MultiCameraSynchronizer::takeStatistics()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Statistics stats = stats_;
+    stats_ = {0, 0, 0, 0, 0.0, 0.0};
+    return stats;
+  }
+}  // namespace realsense_camera
@@ -0,0 +1,209 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <cmath>
+
+#include <realsense_camera/orientation_filter.h>
+
+namespace realsense_camera
+{
+  namespace
+  {
+    const double RESET_INTERVAL_MS = 100.0;
+  }  // namespace
+
+  /*
+   * Select the filter. The gain is the Madgwick beta or the Mahony proportional gain; the
+   * integral gain is only used by Mahony.
+   */
+  void OrientationFilter::configure(OrientationFilterType type, double gain, double integral_gain)
+  {
+    type_ = type;
+    gain_ = gain;
+    integral_gain_ = integral_gain;
+    reset();
+  }
+
+  void OrientationFilter::reset()
+  {
+    initialized_ = false;
+  }
+
+  bool OrientationFilter::isInitialized() const
+  {
+    return initialized_;
+  }
+
+  void OrientationFilter::getOrientation(double &x, double &y, double &z, double &w) const
+  {
+    w = q_[0];
+    x = q_[1];
+    y = q_[2];
+    z = q_[3];
+  }
+
+  /*
+   * Advance the orientation to a sample, with the angular velocity in rad/s and the
+   * acceleration in any unit.
+   */
+  void OrientationFilter::update(const float angular_velocity[3], const float linear_acceleration[3],
+      double timestamp_ms)
+  {
+    double ax = linear_acceleration[0];
+    double ay = linear_acceleration[1];
+    double az = linear_acceleration[2];
+    double dt_ms = timestamp_ms - last_timestamp_ms_;
+    if (!initialized_ || dt_ms <= 0.0 || dt_ms > RESET_INTERVAL_MS)
+    {
+      if (ax != 0.0 || ay != 0.0 || az != 0.0)
+      {
+        initialize(ax, ay, az);
+        last_timestamp_ms_ = timestamp_ms;
+      }
+      return;
+    }
+    last_timestamp_ms_ = timestamp_ms;
+    double dt = dt_ms * 0.001;
+
+    double gx = angular_velocity[0];
+    double gy = angular_velocity[1];
+    double gz = angular_velocity[2];
+    double norm = std::sqrt(ax * ax + ay * ay + az * az);
+    if (norm == 0.0)
+    {
+      integrate(gx, gy, gz, dt);
+      return;
+    }
+    ax /= norm;
+    ay /= norm;
+    az /= norm;
+
+    double q0 = q_[0];
+    double q1 = q_[1];
+    double q2 = q_[2];
+    double q3 = q_[3];
+    if (type_ == ORIENTATION_FILTER_MAHONY)
+    {
+      // error between the measured and the estimated direction of gravity
+      double vx = 2.0 * (q1 * q3 - q0 * q2);
+      double vy = 2.0 * (q0 * q1 + q2 * q3);
+      double vz = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+      double ex = ay * vz - az * vy;
+      double ey = az * vx - ax * vz;
+      double ez = ax * vy - ay * vx;
+      if (integral_gain_ > 0.0)
+      {
+        integral_[0] += integral_gain_ * ex * dt;
+        integral_[1] += integral_gain_ * ey * dt;
+        integral_[2] += integral_gain_ * ez * dt;
+        gx += integral_[0];
+        gy += integral_[1];
+        gz += integral_[2];
+      }
+      integrate(gx + gain_ * ex, gy + gain_ * ey, gz + gain_ * ez, dt);
+      return;
+    }
+
+    // Madgwick: gradient of the gravity error, subtracted from the gyro rate of change.
+    double s0 = 4.0 * q0 * q2 * q2 + 2.0 * q2 * ax + 4.0 * q0 * q1 * q1 - 2.0 * q1 * ay;
+    double s1 = 4.0 * q1 * q3 * q3 - 2.0 * q3 * ax + 4.0 * q0 * q0 * q1 - 2.0 * q0 * ay - 4.0 * q1 +
+        8.0 * q1 * q1 * q1 + 8.0 * q1 * q2 * q2 + 4.0 * q1 * az;
+    double s2 = 4.0 * q0 * q0 * q2 + 2.0 * q0 * ax + 4.0 * q2 * q3 * q3 - 2.0 * q3 * ay - 4.0 * q2 +
+        8.0 * q2 * q1 * q1 + 8.0 * q2 * q2 * q2 + 4.0 * q2 * az;
+    double s3 = 4.0 * q1 * q1 * q3 - 2.0 * q1 * ax + 4.0 * q2 * q2 * q3 - 2.0 * q2 * ay;
+    double s_norm = std::sqrt(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3);
+    double q_dot[4] =
+    {
+      0.5 * (-q1 * gx - q2 * gy - q3 * gz),
+      0.5 * (q0 * gx + q2 * gz - q3 * gy),
+      0.5 * (q0 * gy - q1 * gz + q3 * gx),
+      0.5 * (q0 * gz + q1 * gy - q2 * gx)
+    };
+    if (s_norm > 0.0)
+    {
+      q_dot[0] -= gain_ * s0 / s_norm;
+      q_dot[1] -= gain_ * s1 / s_norm;
+      q_dot[2] -= gain_ * s2 / s_norm;
+      q_dot[3] -= gain_ * s3 / s_norm;
+    }
+    double q_norm = 0.0;
+    for (int i = 0; i < 4; i++)
+    {
+      q_[i] += q_dot[i] * dt;
+      q_norm += q_[i] * q_[i];
+    }
+    q_norm = std::sqrt(q_norm);
+    for (int i = 0; i < 4; i++)
+    {
+      q_[i] /= q_norm;
+    }
+  }
+
+  /*
+   * Roll and pitch from the direction of gravity, with zero yaw.
+   */
+  void OrientationFilter::initialize(double ax, double ay, double az)
+  {
+    double roll = std::atan2(ay, az);
+    double pitch = std::atan2(-ax, std::sqrt(ay * ay + az * az));
+    double cr = std::cos(roll * 0.5);
+    double sr = std::sin(roll * 0.5);
+    double cp = std::cos(pitch * 0.5);
+    double sp = std::sin(pitch * 0.5);
+    q_[0] = cr * cp;
+    q_[1] = sr * cp;
+    q_[2] = cr * sp;
+    q_[3] = -sr * sp;
+    integral_[0] = 0.0;
+    integral_[1] = 0.0;
+    integral_[2] = 0.0;
+    initialized_ = true;
+  }
+
+  /*
+   * Rotate the orientation by the angular velocity over dt.
+   */
+  void OrientationFilter::integrate(double gx, double gy, double gz, double dt)
+  {
+    double q0 = q_[0];
+    double q1 = q_[1];
+    double q2 = q_[2];
+    double q3 = q_[3];
+    q_[0] += 0.5 * dt * (-q1 * gx - q2 * gy - q3 * gz);
+    q_[1] += 0.5 * dt * (q0 * gx + q2 * gz - q3 * gy);
+    q_[2] += 0.5 * dt * (q0 * gy - q1 * gz + q3 * gx);
+    q_[3] += 0.5 * dt * (q0 * gz + q1 * gy - q2 * gx);
+    double q_norm = std::sqrt(q_[0] * q_[0] + q_[1] * q_[1] + q_[2] * q_[2] + q_[3] * q_[3]);
+    for (int i = 0; i < 4; i++)
+    {
+      q_[i] /= q_norm;
+    }
+  }
+}  // namespace realsense_camera
@@ -0,0 +1,272 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <cstring>
+#include <limits>
+
+#include <realsense_camera/simd.h>
+#include <realsense_camera/pointcloud.h>
+
+namespace realsense_camera
+{
+  namespace
+  {
+    /*
+     * Deproject count pixels of one row, returning the number of points written.
+     */
+    size_t deprojectRowScalar(const uint16_t *depth, const float *ray_x, const float *ray_y, size_t count,
+        float depth_unit, bool organized, float *points)
+    {
+      const float nan = std::numeric_limits<float>::quiet_NaN();
+      float *out = points;
+      for (size_t i = 0; i < count; ++i)
+      {
+        float z = depth[i] * depth_unit;
+        if (depth[i] == 0)
+        {
+          if (organized)
+          {
+            out[0] = out[1] = out[2] = nan;
+            out[3] = 0.0f;
+            out += 4;
+          }
+          continue;
+        }
+        out[0] = ray_x[i] * z;
+        out[1] = ray_y[i] * z;
+        out[2] = z;
+        out[3] = 0.0f;
+        out += 4;
+      }
+      return (out - points) / 4;
+    }
+
+#ifdef REALSENSE_CAMERA_X86_KERNELS
+    __attribute__((target("sse4.1")))
+    size_t deprojectRowSSE41(const uint16_t *depth, const float *ray_x, const float *ray_y, size_t count,
+        float depth_unit, bool organized, float *points)
+    {
+      const __m128 unit = _mm_set1_ps(depth_unit);
+      const __m128 zero = _mm_setzero_ps();
+      float *out = points;
+
+      size_t i = 0;
+      for (; i + 4 <= count; i += 4)
+      {
+        __m128i raw = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(depth + i)));
+        __m128 z = _mm_mul_ps(_mm_cvtepi32_ps(raw), unit);
+        __m128 x = _mm_mul_ps(_mm_loadu_ps(ray_x + i), z);
+        __m128 y = _mm_mul_ps(_mm_loadu_ps(ray_y + i), z);
+        __m128 w = zero;
+        __m128 invalid = _mm_cmpeq_ps(z, zero);
+
+        if (organized)
+        {
+          // All bits set is a NaN
+          x = _mm_or_ps(x, invalid);
+          y = _mm_or_ps(y, invalid);
+          z = _mm_or_ps(z, invalid);
+          _MM_TRANSPOSE4_PS(x, y, z, w);
+          _mm_storeu_ps(out, x);
+          _mm_storeu_ps(out + 4, y);
+          _mm_storeu_ps(out + 8, z);
+          _mm_storeu_ps(out + 12, w);
+          out += 16;
+        }
+        else
+        {
+          int valid = ~_mm_movemask_ps(invalid) & 0xF;
+          if (valid == 0)
+          {
+            continue;
+          }
+          _MM_TRANSPOSE4_PS(x, y, z, w);
+          const __m128 point[4] = {x, y, z, w};
+          for (int j = 0; j < 4; ++j)
+          {
+            if (valid & (1 << j))
+            {
+              _mm_storeu_ps(out, point[j]);
+              out += 4;
+            }
+          }
+        }
+      }
+      out += 4 * deprojectRowScalar(depth + i, ray_x + i, ray_y + i, count - i, depth_unit, organized, out);
+      return (out - points) / 4;
+    }
+
+    __attribute__((target("avx2")))
+    size_t deprojectRowAVX2(const uint16_t *depth, const float *ray_x, const float *ray_y, size_t count,
+        float depth_unit, bool organized, float *points)
+    {
+      const __m256 unit = _mm256_set1_ps(depth_unit);
+      const __m256 zero = _mm256_setzero_ps();
+      float *out = points;
+
+      size_t i = 0;
+      for (; i + 8 <= count; i += 8)
+      {
+        __m256i raw = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(depth + i)));
+        __m256 z = _mm256_mul_ps(_mm256_cvtepi32_ps(raw), unit);
+        __m256 x = _mm256_mul_ps(_mm256_loadu_ps(ray_x + i), z);
+        __m256 y = _mm256_mul_ps(_mm256_loadu_ps(ray_y + i), z);
+        __m256 invalid = _mm256_cmp_ps(z, zero, _CMP_EQ_OQ);
+        int valid = ~_mm256_movemask_ps(invalid) & 0xFF;
+
+        if (organized)
+        {
+          x = _mm256_or_ps(x, invalid);
+          y = _mm256_or_ps(y, invalid);
+          z = _mm256_or_ps(z, invalid);
+        }
+        else if (valid == 0)
+        {
+          continue;
+        }
+
+        // Transpose to points; each 128-bit lane holds points j and j + 4
+        __m256 xy_lo = _mm256_unpacklo_ps(x, y);
+        __m256 xy_hi = _mm256_unpackhi_ps(x, y);
+        __m256 zw_lo = _mm256_unpacklo_ps(z, zero);
+        __m256 zw_hi = _mm256_unpackhi_ps(z, zero);
+        __m256 p04 = _mm256_shuffle_ps(xy_lo, zw_lo, 0x44);
+        __m256 p15 = _mm256_shuffle_ps(xy_lo, zw_lo, 0xEE);
+        __m256 p26 = _mm256_shuffle_ps(xy_hi, zw_hi, 0x44);
+        __m256 p37 = _mm256_shuffle_ps(xy_hi, zw_hi, 0xEE);
+
+        if (organized)
+        {
+          _mm256_storeu_ps(out, _mm256_permute2f128_ps(p04, p15, 0x20));
+          _mm256_storeu_ps(out + 8, _mm256_permute2f128_ps(p26, p37, 0x20));
+          _mm256_storeu_ps(out + 16, _mm256_permute2f128_ps(p04, p15, 0x31));
+          _mm256_storeu_ps(out + 24, _mm256_permute2f128_ps(p26, p37, 0x31));
+          out += 32;
+        }
+        else
+        {
+          const __m128 point[8] =
+          {
+            _mm256_castps256_ps128(p04), _mm256_castps256_ps128(p15),
+            _mm256_castps256_ps128(p26), _mm256_castps256_ps128(p37),
+            _mm256_extractf128_ps(p04, 1), _mm256_extractf128_ps(p15, 1),
+            _mm256_extractf128_ps(p26, 1), _mm256_extractf128_ps(p37, 1)
+          };
+          for (int j = 0; j < 8; ++j)
+          {
+            if (valid & (1 << j))
+            {
+              _mm_storeu_ps(out, point[j]);
+              out += 4;
+            }
+          }
+        }
+      }
+      out += 4 * deprojectRowSSE41(depth + i, ray_x + i, ray_y + i, count - i, depth_unit, organized, out);
+      return (out - points) / 4;
+    }
+#endif
+  }  // namespace
+
+  /*
+   * Viewing ray of a pixel.
+   */
+  void deprojectPixelRay(const rs_intrinsics &intrinsics, float u, float v, float &x, float &y)
+  {
+    x = (u - intrinsics.ppx) / intrinsics.fx;
+    y = (v - intrinsics.ppy) / intrinsics.fy;
+    if (intrinsics.model == RS_DISTORTION_INVERSE_BROWN_CONRADY)
+    {
+      const float *c = intrinsics.coeffs;
+      float r2 = x * x + y * y;
+      float f = 1 + c[0] * r2 + c[1] * r2 * r2 + c[4] * r2 * r2 * r2;
+      float ux = x * f + 2 * c[2] * x * y + c[3] * (r2 + 2 * x * x);
+      float uy = y * f + 2 * c[3] * x * y + c[2] * (r2 + 2 * y * y);
+      x = ux;
+      y = uy;
+    }
+  }
+
+  /*
+   * Build the ray table from the stream intrinsics.
+   */
+  void makeDepthRayTable(const rs_intrinsics &intrinsics, DepthRayTable &table)
+  {
+    table.width = intrinsics.width;
+    table.height = intrinsics.height;
+    table.x.resize(static_cast<size_t>(table.width) * table.height);
+    table.y.resize(table.x.size());
+
+    for (uint32_t v = 0; v < table.height; ++v)
+    {
+      for (uint32_t u = 0; u < table.width; ++u)
+      {
+        size_t i = static_cast<size_t>(v) * table.width + u;
+        deprojectPixelRay(intrinsics, u, v, table.x[i], table.y[i]);
+      }
+    }
+  }
+
+  /*
+   * Deproject a band of depth rows to points.
+   */
+  size_t deprojectDepth(const uint16_t *depth, size_t depth_step, const DepthRayTable &table, size_t row_begin,
+      size_t row_end, float depth_unit, bool organized, uint8_t *points)
+  {
+    InstructionSet instruction_set = getInstructionSet();
+    float *out = reinterpret_cast<float *>(points);
+    size_t written = 0;
+
+    for (size_t row = row_begin; row < row_end; ++row)
+    {
+      const uint16_t *depth_row = reinterpret_cast<const uint16_t *>(
+          reinterpret_cast<const uint8_t *>(depth) + row * depth_step);
+      const float *ray_x = &table.x[row * table.width];
+      const float *ray_y = &table.y[row * table.width];
+      float *row_out = out + 4 * written;
+
+      switch (instruction_set)
+      {
+#ifdef REALSENSE_CAMERA_X86_KERNELS
+        case INSTRUCTION_SET_AVX2:
+          written += deprojectRowAVX2(depth_row, ray_x, ray_y, table.width, depth_unit, organized, row_out);
+          break;
+        case INSTRUCTION_SET_SSE41:
+          written += deprojectRowSSE41(depth_row, ray_x, ray_y, table.width, depth_unit, organized, row_out);
+          break;
+#endif
+        default:
+          written += deprojectRowScalar(depth_row, ray_x, ray_y, table.width, depth_unit, organized, row_out);
+          break;
+      }
+    }
+    return written;
+  }
+}  // namespace realsense_camera
@@ -0,0 +1,156 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+/*
+ * Benchmark of the image publish path.
+ *
+ * Compares the legacy cv::Mat + cv_bridge path against writing the frame directly
+ * into the outgoing sensor_msgs::Image, and reports the bytes written per frame.
+ */
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <boost/make_shared.hpp>
+#include <opencv2/core/core.hpp>
+#include <cv_bridge/cv_bridge.h>
+#include <sensor_msgs/image_encodings.h>
+
+#include <realsense_camera/image_utils.h>
+#include <realsense_camera/image_pool.h>
+
+struct StreamProfile
+{
+  const char *name;
+  int width;
+  int height;
+  int cv_type;
+  int unit_step_size;
+  std::string encoding;
+};
+
+size_t legacy_bytes_written = 0;
+
+/*
+ * Legacy path: allocate and clear a cv::Mat, point it at the frame and let cv_bridge copy it.
+ * Both the clear and the copy write a full frame.
+ */
+sensor_msgs::ImagePtr legacyPublishPath(const StreamProfile &profile, std::vector<uint8_t> &frame)
+{
+  cv::Mat image_mat = cv::Mat(profile.height, profile.width, profile.cv_type, cv::Scalar(0, 0, 0));
+  size_t cleared = image_mat.total() * image_mat.elemSize();
+  image_mat.data = frame.data();
+  sensor_msgs::ImagePtr msg = cv_bridge::CvImage(std_msgs::Header(), profile.encoding, image_mat).toImageMsg();
+  legacy_bytes_written = cleared + msg->data.size();
+  return msg;
+}
+
+size_t direct_bytes_written = 0;
+
+/*
+ * Direct path: write the frame once into the outgoing message.
+ */
+sensor_msgs::ImagePtr directPublishPath(const StreamProfile &profile, std::vector<uint8_t> &frame)
+{
+  int step = profile.width * profile.unit_step_size;
+  sensor_msgs::ImagePtr msg = boost::make_shared<sensor_msgs::Image>();
+  realsense_camera::prepareImageMessage(*msg, profile.width, profile.height, step, profile.encoding);
+  direct_bytes_written = realsense_camera::copyFrameToImage(frame.data(), step, *msg);
+  return msg;
+}
+
+realsense_camera::ImagePool image_pool;
+size_t pooled_bytes_written = 0;
+
+/*
+ * Pooled path: write the frame once into a recycled message.
+ */
+sensor_msgs::ImagePtr pooledPublishPath(const StreamProfile &profile, std::vector<uint8_t> &frame)
+{
+  sensor_msgs::ImagePtr msg = image_pool.acquire();
+  pooled_bytes_written = realsense_camera::copyFrameToImage(frame.data(), msg->step, *msg);
+  return msg;
+}
+
+template<typename PublishPath>
+double timePath(PublishPath path, const StreamProfile &profile, std::vector<uint8_t> &frame, int iterations)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i)
+  {
+    sensor_msgs::ImagePtr msg = path(profile, frame);
+    if (msg->data.empty())
+    {
+      return -1;
+    }
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::micro>(elapsed).count() / iterations;
+}
+
+int main(int argc, char **argv)
+{
+  int iterations = (argc > 1) ? atoi(argv[1]) : 500;
+
+  const StreamProfile profiles[] =
+  {
+    {"depth 480x360", 480, 360, CV_16UC1, 2, sensor_msgs::image_encodings::TYPE_16UC1},
+    {"depth 640x480", 640, 480, CV_16UC1, 2, sensor_msgs::image_encodings::TYPE_16UC1},
+    {"color 640x480", 640, 480, CV_8UC3, 3, sensor_msgs::image_encodings::RGB8},
+    {"color 1920x1080", 1920, 1080, CV_8UC3, 3, sensor_msgs::image_encodings::RGB8},
+    {"ir 640x480", 640, 480, CV_8UC1, 1, sensor_msgs::image_encodings::TYPE_8UC1}
+  };
+
+  printf("%-18s %12s %14s %14s %14s %10s %10s %10s\n", "stream", "frame bytes", "legacy written",
+      "direct written", "pooled written", "legacy us", "direct us", "pooled us");
+  for (const StreamProfile &profile : profiles)
+  {
+    size_t frame_size = static_cast<size_t>(profile.width) * profile.height * profile.unit_step_size;
+    std::vector<uint8_t> frame(frame_size, 0x5a);
+
+    double legacy_us = timePath(legacyPublishPath, profile, frame, iterations);
+    double direct_us = timePath(directPublishPath, profile, frame, iterations);
+
+    image_pool.configure(profile.width, profile.height, profile.width * profile.unit_step_size, profile.encoding,
+        4 * frame_size);
+    double pooled_us = timePath(pooledPublishPath, profile, frame, iterations);
+    realsense_camera::ImagePool::Statistics pool_stats = image_pool.getStatistics();
+
+    printf("%-18s %12zu %14zu %14zu %14zu %10.1f %10.1f %10.1f  (pool hits %lu, misses %lu)\n",
+        profile.name, frame_size, legacy_bytes_written, direct_bytes_written, pooled_bytes_written, legacy_us,
+        direct_us, pooled_us,
+        static_cast<unsigned long>(pool_stats.hits),  // NOLINT(runtime/int)
+        static_cast<unsigned long>(pool_stats.misses));  // NOLINT(runtime/int)
+  }
+  return 0;
+}
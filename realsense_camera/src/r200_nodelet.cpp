@@ -91,7 +91,7 @@ namespace realsense_camera
     BaseNodelet::advertiseTopics();
     ros::NodeHandle ir2_nh(nh_, IR2_NAMESPACE);
     image_transport::ImageTransport ir2_image_transport(ir2_nh);
-    camera_publisher_[RS_STREAM_INFRARED2] = ir2_image_transport.advertiseCamera(IMAGE_RECT, 1);
+    camera_publisher_[RS_STREAM_INFRARED2] = advertiseCameraTopic(ir2_image_transport, IMAGE_RECT);
   }
 
   /*
@@ -128,33 +128,48 @@ namespace realsense_camera
    */
   void R200Nodelet::configCallback(realsense_camera::r200_paramsConfig &config, uint32_t level)
   {
-    // set the depth enable
+    // set the stream profiles, then the depth enable, which restarts the camera once for all of them
+    setStreamProfile(RS_STREAM_DEPTH, config.depth_width, config.depth_height, config.depth_fps);
+    setStreamProfile(RS_STREAM_COLOR, config.rgb_width, config.rgb_height, config.rgb_fps);
     BaseNodelet::setDepthEnable(config.enable_depth);
 
+    // set the depth filters
+    DepthFilterSettings filters;
+    filters.enable_spatial = config.enable_spatial_filter;
+    filters.spatial_alpha = config.spatial_filter_alpha;
+    filters.spatial_delta = config.spatial_filter_delta;
+    filters.spatial_iterations = config.spatial_filter_iterations;
+    filters.enable_temporal = config.enable_temporal_filter;
+    filters.temporal_alpha = config.temporal_filter_alpha;
+    filters.temporal_delta = config.temporal_filter_delta;
+    filters.temporal_persistence = config.temporal_filter_persistence;
+    filters.enable_hole_filling = config.enable_hole_filling;
+    filters.hole_filling_mode = static_cast<HoleFillingMode>(config.hole_filling_mode);
+    BaseNodelet::setDepthFilters(filters);
+
     // Set common options
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_BACKLIGHT_COMPENSATION, config.color_backlight_compensation, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_BRIGHTNESS, config.color_brightness, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_CONTRAST, config.color_contrast, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_GAIN, config.color_gain, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_GAMMA, config.color_gamma, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_HUE, config.color_hue, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_SATURATION, config.color_saturation, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_SHARPNESS, config.color_sharpness, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_ENABLE_AUTO_WHITE_BALANCE,
-        config.color_enable_auto_white_balance, 0);
+    queueCameraOption(RS_OPTION_COLOR_BACKLIGHT_COMPENSATION, config.color_backlight_compensation);
+    queueCameraOption(RS_OPTION_COLOR_BRIGHTNESS, config.color_brightness);
+    queueCameraOption(RS_OPTION_COLOR_CONTRAST, config.color_contrast);
+    queueCameraOption(RS_OPTION_COLOR_GAIN, config.color_gain);
+    queueCameraOption(RS_OPTION_COLOR_GAMMA, config.color_gamma);
+    queueCameraOption(RS_OPTION_COLOR_HUE, config.color_hue);
+    queueCameraOption(RS_OPTION_COLOR_SATURATION, config.color_saturation);
+    queueCameraOption(RS_OPTION_COLOR_SHARPNESS, config.color_sharpness);
+    queueCameraOption(RS_OPTION_COLOR_ENABLE_AUTO_WHITE_BALANCE, config.color_enable_auto_white_balance);
     if (config.color_enable_auto_white_balance == 0)
     {
-      rs_set_device_option(rs_device_, RS_OPTION_COLOR_WHITE_BALANCE, config.color_white_balance, 0);
+      queueCameraOption(RS_OPTION_COLOR_WHITE_BALANCE, config.color_white_balance);
     }
 
     // Set R200 specific options
-    rs_set_device_option(rs_device_, RS_OPTION_R200_LR_AUTO_EXPOSURE_ENABLED, config.r200_lr_auto_exposure_enabled, 0);
+    queueCameraOption(RS_OPTION_R200_LR_AUTO_EXPOSURE_ENABLED, config.r200_lr_auto_exposure_enabled);
     if (config.r200_lr_auto_exposure_enabled == 0)
     {
-      rs_set_device_option(rs_device_, RS_OPTION_R200_LR_EXPOSURE, config.r200_lr_exposure, 0);
+      queueCameraOption(RS_OPTION_R200_LR_EXPOSURE, config.r200_lr_exposure);
     }
-    rs_set_device_option(rs_device_, RS_OPTION_R200_LR_GAIN, config.r200_lr_gain, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_R200_EMITTER_ENABLED, config.r200_emitter_enabled, 0);
+    queueCameraOption(RS_OPTION_R200_LR_GAIN, config.r200_lr_gain);
+    queueCameraOption(RS_OPTION_R200_EMITTER_ENABLED, config.r200_emitter_enabled);
     if (config.r200_lr_auto_exposure_enabled == 1)
     {
       if (config.r200_auto_exposure_top_edge >= height_[RS_STREAM_DEPTH])
@@ -178,10 +193,52 @@ namespace realsense_camera
       edge_values_[1] = config.r200_auto_exposure_top_edge;
       edge_values_[2] = config.r200_auto_exposure_right_edge;
       edge_values_[3] = config.r200_auto_exposure_bottom_edge;
-      rs_set_device_options(rs_device_, edge_options_, 4, edge_values_, 0);
+      queueCameraOptions(edge_options_, edge_values_, 4);
+    }
+
+    applyCameraOptions();
+    applyDepthControlPreset(config.r200_dc_preset);
+  }
+
+  /*
+   * Set a stream profile; the infrared2 stream follows the depth profile like infrared.
+   */
+  void R200Nodelet::setStreamProfile(rs_stream stream_index, int &width, int &height, int &fps)
+  {
+    BaseNodelet::setStreamProfile(stream_index, width, height, fps);
+
+    if (stream_index == RS_STREAM_DEPTH)
+    {
+      std::unique_lock<std::mutex> lock(stream_mutex_);
+      width_[RS_STREAM_INFRARED2] = width_[RS_STREAM_DEPTH];
+      height_[RS_STREAM_INFRARED2] = height_[RS_STREAM_DEPTH];
+      fps_[RS_STREAM_INFRARED2] = fps_[RS_STREAM_DEPTH];
+      profile_changed_[RS_STREAM_INFRARED2] = profile_changed_[RS_STREAM_DEPTH];
+    }
+  }
+
+  /*
+   * Apply the depth control preset if it changed. The preset rewrites the depth control
+   * options, so their last applied values are forgotten.
+   */
+  void R200Nodelet::applyDepthControlPreset(int preset)
+  {
+    if (preset == applied_dc_preset_)
+    {
+      return;
     }
 
-    rs_apply_depth_control_preset(rs_device_, config.r200_dc_preset);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    rs_apply_depth_control_preset(rs_device_, preset);
+    double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    ROS_INFO_STREAM(nodelet_name_ << " - Applied depth control preset " << preset << " in " << elapsed_ms << " ms");
+
+    applied_dc_preset_ = preset;
+    for (int opt = RS_OPTION_R200_DEPTH_CONTROL_ESTIMATE_MEDIAN_DECREMENT;
+        opt <= RS_OPTION_R200_DEPTH_CONTROL_LR_THRESHOLD; ++opt)
+    {
+      forgetCameraOption(static_cast<rs_option>(opt));
+    }
   }
 
   /*
@@ -194,7 +251,7 @@ namespace realsense_camera
 
     ir2_frame_handler_ = [&](rs::frame  frame)  // NOLINT(build/c++11)
     {
-      publishStreamTopic(RS_STREAM_INFRARED2, frame);
+      queueFrame(RS_STREAM_INFRARED2, frame);
     };
 
     rs_set_frame_callback_cpp(rs_device_, RS_STREAM_INFRARED2, new rs::frame_callback(ir2_frame_handler_), &rs_error_);
@@ -218,68 +275,12 @@ namespace realsense_camera
   }
 
   /*
-   * Publish Static transforms.
+   * Build the transform table from the extrinsics and frame ids.
    */
-  void R200Nodelet::publishStaticTransforms()
+  void R200Nodelet::buildTransformTable()
   {
-    BaseNodelet::publishStaticTransforms();
-
-    tf::Quaternion q_i2io;
-    geometry_msgs::TransformStamped b2i_msg;
-    geometry_msgs::TransformStamped i2io_msg;
-
-    // Transform base frame to infrared2 frame
-    b2i_msg.header.stamp = transform_ts_;
-    b2i_msg.header.frame_id = base_frame_id_;
-    b2i_msg.child_frame_id = frame_id_[RS_STREAM_INFRARED2];
-    b2i_msg.transform.translation.x =  color2ir2_extrinsic_.translation[2];
-    b2i_msg.transform.translation.y = -color2ir2_extrinsic_.translation[0];
-    b2i_msg.transform.translation.z = -color2ir2_extrinsic_.translation[1];
-    b2i_msg.transform.rotation.x = 0;
-    b2i_msg.transform.rotation.y = 0;
-    b2i_msg.transform.rotation.z = 0;
-    b2i_msg.transform.rotation.w = 1;
-    static_tf_broadcaster_.sendTransform(b2i_msg);
-
-    // Transform infrared2 frame to infrared2 optical frame
-    q_i2io.setRPY(-M_PI/2, 0.0, -M_PI/2);
-    i2io_msg.header.stamp = transform_ts_;
-    i2io_msg.header.frame_id = frame_id_[RS_STREAM_INFRARED2];
-    i2io_msg.child_frame_id = optical_frame_id_[RS_STREAM_INFRARED2];
-    i2io_msg.transform.translation.x = 0;
-    i2io_msg.transform.translation.y = 0;
-    i2io_msg.transform.translation.z = 0;
-    i2io_msg.transform.rotation.x = q_i2io.getX();
-    i2io_msg.transform.rotation.y = q_i2io.getY();
-    i2io_msg.transform.rotation.z = q_i2io.getZ();
-    i2io_msg.transform.rotation.w = q_i2io.getW();
-    static_tf_broadcaster_.sendTransform(i2io_msg);
-  }
+    BaseNodelet::buildTransformTable();
 
-  /*
-   * Publish Dynamic transforms.
-   */
-  void R200Nodelet::publishDynamicTransforms()
-  {
-    tf::Transform tr;
-    tf::Quaternion q;
-
-    BaseNodelet::publishDynamicTransforms();
-
-    // Transform base frame to infrared2 frame
-    tr.setOrigin(tf::Vector3(
-           color2ir2_extrinsic_.translation[2],
-          -color2ir2_extrinsic_.translation[0],
-          -color2ir2_extrinsic_.translation[1]));
-    tr.setRotation(tf::Quaternion(0, 0, 0, 1));
-    dynamic_tf_broadcaster_.sendTransform(tf::StampedTransform(tr, transform_ts_,
-          base_frame_id_, frame_id_[RS_STREAM_INFRARED2]));
-
-    // Transform infrared2 frame to infrared2 optical frame
-    tr.setOrigin(tf::Vector3(0, 0, 0));
-    q.setRPY(-M_PI/2, 0.0, -M_PI/2);
-    tr.setRotation(q);
-    dynamic_tf_broadcaster_.sendTransform(tf::StampedTransform(tr, transform_ts_,
-          frame_id_[RS_STREAM_INFRARED2], optical_frame_id_[RS_STREAM_INFRARED2]));
+    addSensorTransforms(frame_id_[RS_STREAM_INFRARED2], optical_frame_id_[RS_STREAM_INFRARED2], color2ir2_extrinsic_);
   }
 }  // namespace realsense_camera
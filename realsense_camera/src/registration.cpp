@@ -0,0 +1,252 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include <realsense_camera/pointcloud.h>
+#include <realsense_camera/registration.h>
+
+namespace realsense_camera
+{
+  namespace
+  {
+    const float MILLIMETER_TO_METER = 0.001f;
+    const size_t MIN_BAND_ROWS = 8;
+
+    /*
+     * Keep the nearest depth when several depth pixels land on the same color pixel.
+     * Bands run concurrently, so the update is atomic.
+     */
+    inline void storeNearest(uint16_t *pixel, uint16_t depth)
+    {
+      uint16_t current = __atomic_load_n(pixel, __ATOMIC_RELAXED);
+      while ((current == 0 || depth < current) &&
+          !__atomic_compare_exchange_n(pixel, &current, depth, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+      {
+      }
+    }
+  }  // namespace
+
+  void DepthRegistration::RotatedRays::resize(size_t count)
+  {
+    x.resize(count);
+    y.resize(count);
+    z.resize(count);
+  }
+
+  DepthRegistration::DepthRegistration() :
+    configured_(false)
+  {
+  }
+
+  /*
+   * Set the calibration and rebuild the projection tables if it changed.
+   */
+  void DepthRegistration::configure(const rs_intrinsics &depth_intrinsics, const rs_intrinsics &color_intrinsics,
+      const rs_extrinsics &depth_to_color)
+  {
+    if (configured_ &&
+        memcmp(&depth_intrinsics_, &depth_intrinsics, sizeof(rs_intrinsics)) == 0 &&
+        memcmp(&color_intrinsics_, &color_intrinsics, sizeof(rs_intrinsics)) == 0 &&
+        memcmp(&depth_to_color_, &depth_to_color, sizeof(rs_extrinsics)) == 0)
+    {
+      return;
+    }
+
+    depth_intrinsics_ = depth_intrinsics;
+    color_intrinsics_ = color_intrinsics;
+    depth_to_color_ = depth_to_color;
+
+    // The rotation is column-major, as in rs_transform_point_to_point
+    const float *r = depth_to_color.rotation;
+    size_t width = depth_intrinsics.width;
+    size_t height = depth_intrinsics.height;
+    centers_.resize(width * height);
+    corners_.resize((width + 1) * (height + 1));
+
+    for (size_t v = 0; v <= height; ++v)
+    {
+      for (size_t u = 0; u <= width; ++u)
+      {
+        float x, y;
+        if (u < width && v < height)
+        {
+          size_t i = v * width + u;
+          deprojectPixelRay(depth_intrinsics, u, v, x, y);
+          centers_.x[i] = r[0] * x + r[3] * y + r[6];
+          centers_.y[i] = r[1] * x + r[4] * y + r[7];
+          centers_.z[i] = r[2] * x + r[5] * y + r[8];
+        }
+
+        size_t i = v * (width + 1) + u;
+        deprojectPixelRay(depth_intrinsics, u - 0.5f, v - 0.5f, x, y);
+        corners_.x[i] = r[0] * x + r[3] * y + r[6];
+        corners_.y[i] = r[1] * x + r[4] * y + r[7];
+        corners_.z[i] = r[2] * x + r[5] * y + r[8];
+      }
+    }
+    configured_ = true;
+  }
+
+  bool DepthRegistration::isConfigured() const
+  {
+    return configured_;
+  }
+
+  /*
+   * Project a point in the color camera frame to color pixel coordinates, as rs_project_point_to_pixel does.
+   */
+  inline void DepthRegistration::projectToColor(float x, float y, float z, float &u, float &v) const
+  {
+    x /= z;
+    y /= z;
+    if (color_intrinsics_.model == RS_DISTORTION_MODIFIED_BROWN_CONRADY)
+    {
+      const float *c = color_intrinsics_.coeffs;
+      float r2 = x * x + y * y;
+      float f = 1 + c[0] * r2 + c[1] * r2 * r2 + c[4] * r2 * r2 * r2;
+      x *= f;
+      y *= f;
+      float dx = x + 2 * c[2] * x * y + c[3] * (r2 + 2 * x * x);
+      float dy = y + 2 * c[3] * x * y + c[2] * (r2 + 2 * y * y);
+      x = dx;
+      y = dy;
+    }
+    u = x * color_intrinsics_.fx + color_intrinsics_.ppx;
+    v = y * color_intrinsics_.fy + color_intrinsics_.ppy;
+  }
+
+  /*
+   * Map depth to the color camera.
+   */
+  void DepthRegistration::registerDepthToColor(const uint16_t *depth, size_t depth_step, uint16_t *out,
+      size_t out_step, WorkerPool &pool) const
+  {
+    const int width = depth_intrinsics_.width;
+    const int color_width = color_intrinsics_.width;
+    const int color_height = color_intrinsics_.height;
+    const float *t = depth_to_color_.translation;
+
+    for (int row = 0; row < color_height; ++row)
+    {
+      memset(reinterpret_cast<uint8_t *>(out) + row * out_step, 0, color_width * sizeof(uint16_t));
+    }
+
+    pool.parallelFor(depth_intrinsics_.height, MIN_BAND_ROWS, [&](size_t begin, size_t end)  // NOLINT(build/c++11)
+    {
+      for (size_t v = begin; v < end; ++v)
+      {
+        const uint16_t *depth_row = reinterpret_cast<const uint16_t *>(
+            reinterpret_cast<const uint8_t *>(depth) + v * depth_step);
+        for (int u = 0; u < width; ++u)
+        {
+          uint16_t depth_mm = depth_row[u];
+          if (depth_mm == 0)
+          {
+            continue;
+          }
+          float z = depth_mm * MILLIMETER_TO_METER;
+
+          // Project the top-left and bottom-right corners of the depth pixel
+          size_t tl = v * (width + 1) + u;
+          size_t br = tl + width + 2;
+          float u0, v0, u1, v1;
+          projectToColor(corners_.x[tl] * z + t[0], corners_.y[tl] * z + t[1], corners_.z[tl] * z + t[2], u0, v0);
+          projectToColor(corners_.x[br] * z + t[0], corners_.y[br] * z + t[1], corners_.z[br] * z + t[2], u1, v1);
+
+          // Fill the color pixels whose centers fall inside the footprint, at least one pixel
+          int x0 = static_cast<int>(std::ceil(u0));
+          int y0 = static_cast<int>(std::ceil(v0));
+          int x1 = std::max(x0, static_cast<int>(std::ceil(u1)) - 1);
+          int y1 = std::max(y0, static_cast<int>(std::ceil(v1)) - 1);
+          x0 = std::max(x0, 0);
+          y0 = std::max(y0, 0);
+          x1 = std::min(x1, color_width - 1);
+          y1 = std::min(y1, color_height - 1);
+
+          for (int y = y0; y <= y1; ++y)
+          {
+            uint16_t *out_row = reinterpret_cast<uint16_t *>(reinterpret_cast<uint8_t *>(out) + y * out_step);
+            for (int x = x0; x <= x1; ++x)
+            {
+              storeNearest(out_row + x, depth_mm);
+            }
+          }
+        }
+      }
+    });
+  }
+
+  /*
+   * Sample color at every depth pixel.
+   */
+  void DepthRegistration::registerColorToDepth(const uint16_t *depth, size_t depth_step, const uint8_t *color,
+      size_t color_step, size_t bytes_per_pixel, uint8_t *out, size_t out_step, WorkerPool &pool) const
+  {
+    const int width = depth_intrinsics_.width;
+    const int color_width = color_intrinsics_.width;
+    const int color_height = color_intrinsics_.height;
+    const float *t = depth_to_color_.translation;
+
+    pool.parallelFor(depth_intrinsics_.height, MIN_BAND_ROWS, [&](size_t begin, size_t end)  // NOLINT(build/c++11)
+    {
+      for (size_t v = begin; v < end; ++v)
+      {
+        const uint16_t *depth_row = reinterpret_cast<const uint16_t *>(
+            reinterpret_cast<const uint8_t *>(depth) + v * depth_step);
+        uint8_t *out_row = out + v * out_step;
+        memset(out_row, 0, width * bytes_per_pixel);
+
+        for (int u = 0; u < width; ++u)
+        {
+          uint16_t depth_mm = depth_row[u];
+          if (depth_mm == 0)
+          {
+            continue;
+          }
+          float z = depth_mm * MILLIMETER_TO_METER;
+          size_t i = v * width + u;
+          float cu, cv;
+          projectToColor(centers_.x[i] * z + t[0], centers_.y[i] * z + t[1], centers_.z[i] * z + t[2], cu, cv);
+
+          int x = static_cast<int>(cu + 0.5f);
+          int y = static_cast<int>(cv + 0.5f);
+          if (cu < -0.5f || cv < -0.5f || x >= color_width || y >= color_height)
+          {
+            continue;
+          }
+          memcpy(out_row + u * bytes_per_pixel, color + y * color_step + x * bytes_per_pixel, bytes_per_pixel);
+        }
+      }
+    });
+  }
+}  // namespace realsense_camera
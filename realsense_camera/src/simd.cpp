@@ -0,0 +1,81 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <realsense_camera/simd.h>
+
+namespace realsense_camera
+{
+  namespace
+  {
+    /*
+     * Query the CPU for the widest supported instruction set.
+     */
+    InstructionSet detectInstructionSet()
+    {
+#ifdef REALSENSE_CAMERA_X86_KERNELS
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2"))
+      {
+        return INSTRUCTION_SET_AVX2;
+      }
+      if (__builtin_cpu_supports("sse4.1"))
+      {
+        return INSTRUCTION_SET_SSE41;
+      }
+#endif
+      return INSTRUCTION_SET_SCALAR;
+    }
+  }  // namespace
+
+  /*
+   * Widest instruction set supported by the CPU.
+   */
+  InstructionSet getInstructionSet()
+  {
+    static const InstructionSet instruction_set = detectInstructionSet();
+    return instruction_set;
+  }
+
+  /*
+   * Name of the detected instruction set.
+   */
+  const char * getInstructionSetName()
+  {
+    switch (getInstructionSet())
+    {
+      case INSTRUCTION_SET_AVX2:
+        return "avx2";
+      case INSTRUCTION_SET_SSE41:
+        return "sse4.1";
+      default:
+        return "scalar";
+    }
+  }
+}  // namespace realsense_camera
@@ -59,41 +59,6 @@ namespace realsense_camera
     BaseNodelet::onInit();
   }
 
-  /*
-   * Determine fastest stream -- overrides base class
-   */
-  void SR300Nodelet::setStreams()
-  {
-    // enable camera streams
-    BaseNodelet::setStreams();
-
-    // Find the fastest updating, enabled stream
-    fastest_stream_ = RS_STREAM_DEPTH;  // default to depth
-
-    if (fps_[RS_STREAM_COLOR] > fps_[RS_STREAM_DEPTH])
-    {
-      if (enable_[RS_STREAM_COLOR])
-      {
-        fastest_stream_ = RS_STREAM_COLOR;
-      }
-    }
-  }
-
-  /*
-   * Determine the timestamp for the publish topic. -- overrides base class
-   */
-  ros::Time SR300Nodelet::getTimestamp(rs_stream stream_index, double frame_ts)
-  {
-    static ros::Time last_common_stamp = ros::Time::now();
-
-    if (stream_index == fastest_stream_)
-    {
-      last_common_stamp = ros::Time::now();
-    }
-
-    return last_common_stamp;
-  }
-
   /*
    * Set Dynamic Reconfigure Server and return the dynamic params.
    */
@@ -130,67 +95,78 @@ namespace realsense_camera
   {
     ROS_INFO_STREAM(nodelet_name_ << " - Setting dynamic camera options");
 
-    // set the depth enable
+    // set the stream profiles, then the depth enable, which restarts the camera once for all of them
+    setStreamProfile(RS_STREAM_DEPTH, config.depth_width, config.depth_height, config.depth_fps);
+    setStreamProfile(RS_STREAM_COLOR, config.rgb_width, config.rgb_height, config.rgb_fps);
     BaseNodelet::setDepthEnable(config.enable_depth);
 
+    // set the depth filters
+    DepthFilterSettings filters;
+    filters.enable_spatial = config.enable_spatial_filter;
+    filters.spatial_alpha = config.spatial_filter_alpha;
+    filters.spatial_delta = config.spatial_filter_delta;
+    filters.spatial_iterations = config.spatial_filter_iterations;
+    filters.enable_temporal = config.enable_temporal_filter;
+    filters.temporal_alpha = config.temporal_filter_alpha;
+    filters.temporal_delta = config.temporal_filter_delta;
+    filters.temporal_persistence = config.temporal_filter_persistence;
+    filters.enable_hole_filling = config.enable_hole_filling;
+    filters.hole_filling_mode = static_cast<HoleFillingMode>(config.hole_filling_mode);
+    BaseNodelet::setDepthFilters(filters);
+
     // Set common options
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_BACKLIGHT_COMPENSATION, config.color_backlight_compensation, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_BRIGHTNESS, config.color_brightness, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_CONTRAST, config.color_contrast, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_GAIN, config.color_gain, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_GAMMA, config.color_gamma, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_HUE, config.color_hue, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_SATURATION, config.color_saturation, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_SHARPNESS, config.color_sharpness, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_ENABLE_AUTO_WHITE_BALANCE,
-        config.color_enable_auto_white_balance, 0);
+    queueCameraOption(RS_OPTION_COLOR_BACKLIGHT_COMPENSATION, config.color_backlight_compensation);
+    queueCameraOption(RS_OPTION_COLOR_BRIGHTNESS, config.color_brightness);
+    queueCameraOption(RS_OPTION_COLOR_CONTRAST, config.color_contrast);
+    queueCameraOption(RS_OPTION_COLOR_GAIN, config.color_gain);
+    queueCameraOption(RS_OPTION_COLOR_GAMMA, config.color_gamma);
+    queueCameraOption(RS_OPTION_COLOR_HUE, config.color_hue);
+    queueCameraOption(RS_OPTION_COLOR_SATURATION, config.color_saturation);
+    queueCameraOption(RS_OPTION_COLOR_SHARPNESS, config.color_sharpness);
+    queueCameraOption(RS_OPTION_COLOR_ENABLE_AUTO_WHITE_BALANCE, config.color_enable_auto_white_balance);
     if (config.color_enable_auto_white_balance == 0)
     {
-      rs_set_device_option(rs_device_, RS_OPTION_COLOR_WHITE_BALANCE, config.color_white_balance, 0);
+      queueCameraOption(RS_OPTION_COLOR_WHITE_BALANCE, config.color_white_balance);
     }
 
     // Set SR300 options that are common with F200
-    rs_set_device_option(rs_device_, RS_OPTION_F200_LASER_POWER, config.f200_laser_power, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_F200_ACCURACY, config.f200_accuracy, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_F200_MOTION_RANGE, config.f200_motion_range, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_F200_FILTER_OPTION, config.f200_filter_option, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_F200_CONFIDENCE_THRESHOLD, config.f200_confidence_threshold, 0);
+    queueCameraOption(RS_OPTION_F200_LASER_POWER, config.f200_laser_power);
+    queueCameraOption(RS_OPTION_F200_ACCURACY, config.f200_accuracy);
+    queueCameraOption(RS_OPTION_F200_MOTION_RANGE, config.f200_motion_range);
+    queueCameraOption(RS_OPTION_F200_FILTER_OPTION, config.f200_filter_option);
+    queueCameraOption(RS_OPTION_F200_CONFIDENCE_THRESHOLD, config.f200_confidence_threshold);
 
     // Set SR300 specific options
-    rs_set_device_option(rs_device_, RS_OPTION_SR300_AUTO_RANGE_ENABLE_MOTION_VERSUS_RANGE,
-        config.sr300_auto_range_enable_motion_versus_range, 0);
+    queueCameraOption(RS_OPTION_SR300_AUTO_RANGE_ENABLE_MOTION_VERSUS_RANGE,
+        config.sr300_auto_range_enable_motion_versus_range);
     if (config.sr300_auto_range_enable_motion_versus_range == 1)
     {
-      rs_set_device_option(rs_device_, RS_OPTION_SR300_AUTO_RANGE_MIN_MOTION_VERSUS_RANGE,
-          config.sr300_auto_range_min_motion_versus_range, 0);
-      rs_set_device_option(rs_device_, RS_OPTION_SR300_AUTO_RANGE_MAX_MOTION_VERSUS_RANGE,
-          config.sr300_auto_range_max_motion_versus_range, 0);
-      rs_set_device_option(rs_device_, RS_OPTION_SR300_AUTO_RANGE_START_MOTION_VERSUS_RANGE,
-          config.sr300_auto_range_start_motion_versus_range, 0);
+      queueCameraOption(RS_OPTION_SR300_AUTO_RANGE_MIN_MOTION_VERSUS_RANGE,
+          config.sr300_auto_range_min_motion_versus_range);
+      queueCameraOption(RS_OPTION_SR300_AUTO_RANGE_MAX_MOTION_VERSUS_RANGE,
+          config.sr300_auto_range_max_motion_versus_range);
+      queueCameraOption(RS_OPTION_SR300_AUTO_RANGE_START_MOTION_VERSUS_RANGE,
+          config.sr300_auto_range_start_motion_versus_range);
     }
-    rs_set_device_option(rs_device_, RS_OPTION_SR300_AUTO_RANGE_ENABLE_LASER,
-        config.sr300_auto_range_enable_laser, 0);
+    queueCameraOption(RS_OPTION_SR300_AUTO_RANGE_ENABLE_LASER, config.sr300_auto_range_enable_laser);
     if (config.sr300_auto_range_enable_laser == 1)
     {
-      rs_set_device_option(rs_device_, RS_OPTION_SR300_AUTO_RANGE_MIN_LASER,
-          config.sr300_auto_range_min_laser, 0);
-      rs_set_device_option(rs_device_, RS_OPTION_SR300_AUTO_RANGE_MAX_LASER,
-          config.sr300_auto_range_max_laser, 0);
-      rs_set_device_option(rs_device_, RS_OPTION_SR300_AUTO_RANGE_START_LASER,
-          config.sr300_auto_range_start_laser, 0);
+      queueCameraOption(RS_OPTION_SR300_AUTO_RANGE_MIN_LASER, config.sr300_auto_range_min_laser);
+      queueCameraOption(RS_OPTION_SR300_AUTO_RANGE_MAX_LASER, config.sr300_auto_range_max_laser);
+      queueCameraOption(RS_OPTION_SR300_AUTO_RANGE_START_LASER, config.sr300_auto_range_start_laser);
     }
-    rs_set_device_option(rs_device_, RS_OPTION_SR300_AUTO_RANGE_UPPER_THRESHOLD,
-        config.sr300_auto_range_upper_threshold, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_SR300_AUTO_RANGE_LOWER_THRESHOLD,
-        config.sr300_auto_range_lower_threshold, 0);
+    queueCameraOption(RS_OPTION_SR300_AUTO_RANGE_UPPER_THRESHOLD, config.sr300_auto_range_upper_threshold);
+    queueCameraOption(RS_OPTION_SR300_AUTO_RANGE_LOWER_THRESHOLD, config.sr300_auto_range_lower_threshold);
 /*
-    rs_set_device_option(rs_device_, RS_OPTION_SR300_WAKEUP_DEV_PHASE1_PERIOD, config.sr300_wakeup_dev_phase1_period, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_SR300_WAKEUP_DEV_PHASE1_FPS, config.sr300_wakeup_dev_phase1_fps, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_SR300_WAKEUP_DEV_PHASE2_PERIOD, config.sr300_wakeup_dev_phase2_period, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_SR300_WAKEUP_DEV_PHASE2_FPS, config.sr300_wakeup_dev_phase2_fps, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_SR300_WAKEUP_DEV_RESET, config.sr300_wakeup_dev_reset, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_SR300_WAKE_ON_USB_REASON, config.sr300_wake_on_usb_reason, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_SR300_WAKE_ON_USB_CONFIDENCE, config.sr300_wake_on_usb_confidence, 0);
+    queueCameraOption(RS_OPTION_SR300_WAKEUP_DEV_PHASE1_PERIOD, config.sr300_wakeup_dev_phase1_period);
+    queueCameraOption(RS_OPTION_SR300_WAKEUP_DEV_PHASE1_FPS, config.sr300_wakeup_dev_phase1_fps);
+    queueCameraOption(RS_OPTION_SR300_WAKEUP_DEV_PHASE2_PERIOD, config.sr300_wakeup_dev_phase2_period);
+    queueCameraOption(RS_OPTION_SR300_WAKEUP_DEV_PHASE2_FPS, config.sr300_wakeup_dev_phase2_fps);
+    queueCameraOption(RS_OPTION_SR300_WAKEUP_DEV_RESET, config.sr300_wakeup_dev_reset);
+    queueCameraOption(RS_OPTION_SR300_WAKE_ON_USB_REASON, config.sr300_wake_on_usb_reason);
+    queueCameraOption(RS_OPTION_SR300_WAKE_ON_USB_CONFIDENCE, config.sr300_wake_on_usb_confidence);
 */
+
+    applyCameraOptions();
   }
 }  // namespace realsense_camera
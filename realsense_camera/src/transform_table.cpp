@@ -0,0 +1,223 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <realsense_camera/transform_table.h>
+
+namespace realsense_camera
+{
+  namespace
+  {
+    // Rows are the body axes (x forward, y left, z up) in optical axes (x right, y down, z forward)
+    const double OPTICAL_TO_BODY[3][3] = {{0, 0, 1}, {-1, 0, 0}, {0, -1, 0}};
+    const double ORTHONORMAL_TOLERANCE = 1e-3;
+
+    /*
+     * Convert a rotation matrix to a unit quaternion, choosing the largest diagonal term
+     * for numerical stability.
+     */
+    void matrixToQuaternion(const double m[3][3], double &x, double &y, double &z, double &w)
+    {
+      double trace = m[0][0] + m[1][1] + m[2][2];
+      if (trace > 0.0)
+      {
+        double s = 2.0 * std::sqrt(trace + 1.0);
+        w = 0.25 * s;
+        x = (m[2][1] - m[1][2]) / s;
+        y = (m[0][2] - m[2][0]) / s;
+        z = (m[1][0] - m[0][1]) / s;
+      }
+      else if (m[0][0] > m[1][1] && m[0][0] > m[2][2])
+      {
+        double s = 2.0 * std::sqrt(1.0 + m[0][0] - m[1][1] - m[2][2]);
+        w = (m[2][1] - m[1][2]) / s;
+        x = 0.25 * s;
+        y = (m[0][1] + m[1][0]) / s;
+        z = (m[0][2] + m[2][0]) / s;
+      }
+      else if (m[1][1] > m[2][2])
+      {
+        double s = 2.0 * std::sqrt(1.0 + m[1][1] - m[0][0] - m[2][2]);
+        w = (m[0][2] - m[2][0]) / s;
+        x = (m[0][1] + m[1][0]) / s;
+        y = 0.25 * s;
+        z = (m[1][2] + m[2][1]) / s;
+      }
+      else
+      {
+        double s = 2.0 * std::sqrt(1.0 + m[2][2] - m[0][0] - m[1][1]);
+        w = (m[1][0] - m[0][1]) / s;
+        x = (m[0][2] + m[2][0]) / s;
+        y = (m[1][2] + m[2][1]) / s;
+        z = 0.25 * s;
+      }
+
+      // Keep w non-negative so the same rotation always publishes the same quaternion
+      double norm = std::sqrt(x * x + y * y + z * z + w * w);
+      if (w < 0.0)
+      {
+        norm = -norm;
+      }
+      x /= norm;
+      y /= norm;
+      z /= norm;
+      w /= norm;
+    }
+
+    bool isOrthonormal(const double m[3][3])
+    {
+      for (int i = 0; i < 3; ++i)
+      {
+        for (int j = 0; j < 3; ++j)
+        {
+          double dot = m[i][0] * m[j][0] + m[i][1] * m[j][1] + m[i][2] * m[j][2];
+          if (std::fabs(dot - (i == j ? 1.0 : 0.0)) > ORTHONORMAL_TOLERANCE)
+          {
+            return false;
+          }
+        }
+      }
+
+      double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+                 - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+                 + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+      return det > 0.0;
+    }
+  }  // namespace
+
+  rs_extrinsics invertExtrinsic(const rs_extrinsics &extrinsic)
+  {
+    // The rotation is column-major, so the transpose swaps the row and column indices
+    rs_extrinsics inverse;
+    for (int r = 0; r < 3; ++r)
+    {
+      for (int c = 0; c < 3; ++c)
+      {
+        inverse.rotation[c * 3 + r] = extrinsic.rotation[r * 3 + c];
+      }
+    }
+    for (int r = 0; r < 3; ++r)
+    {
+      inverse.translation[r] = -(inverse.rotation[r] * extrinsic.translation[0] +
+          inverse.rotation[3 + r] * extrinsic.translation[1] + inverse.rotation[6 + r] * extrinsic.translation[2]);
+    }
+    return inverse;
+  }
+
+  void TransformTable::clear()
+  {
+    transforms_.clear();
+  }
+
+  bool TransformTable::addExtrinsic(const std::string &parent_frame_id, const std::string &child_frame_id,
+      const rs_extrinsics &extrinsic)
+  {
+    // The rotation is column-major, as in rs_transform_point_to_point
+    double optical[3][3];
+    for (int r = 0; r < 3; ++r)
+    {
+      for (int c = 0; c < 3; ++c)
+      {
+        optical[r][c] = extrinsic.rotation[c * 3 + r];
+      }
+    }
+
+    bool valid = isOrthonormal(optical);
+    double rotation[3][3];
+    double translation[3];
+    for (int r = 0; r < 3; ++r)
+    {
+      // Body rotation is OPTICAL_TO_BODY * optical * OPTICAL_TO_BODY^T
+      for (int c = 0; c < 3; ++c)
+      {
+        double sum = 0.0;
+        for (int i = 0; i < 3; ++i)
+        {
+          for (int j = 0; j < 3; ++j)
+          {
+            sum += OPTICAL_TO_BODY[r][i] * optical[i][j] * OPTICAL_TO_BODY[c][j];
+          }
+        }
+        rotation[r][c] = valid ? sum : (r == c ? 1.0 : 0.0);
+      }
+
+      translation[r] = OPTICAL_TO_BODY[r][0] * extrinsic.translation[0] +
+        OPTICAL_TO_BODY[r][1] * extrinsic.translation[1] + OPTICAL_TO_BODY[r][2] * extrinsic.translation[2];
+    }
+
+    add(parent_frame_id, child_frame_id, translation, rotation);
+    return valid;
+  }
+
+  void TransformTable::addOptical(const std::string &frame_id, const std::string &optical_frame_id)
+  {
+    // The columns of OPTICAL_TO_BODY are the optical axes in the body frame
+    const double translation[3] = {0.0, 0.0, 0.0};
+    add(frame_id, optical_frame_id, translation, OPTICAL_TO_BODY);
+  }
+
+  void TransformTable::addIdentity(const std::string &parent_frame_id, const std::string &child_frame_id)
+  {
+    const double translation[3] = {0.0, 0.0, 0.0};
+    const double rotation[3][3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+    add(parent_frame_id, child_frame_id, translation, rotation);
+  }
+
+  const std::vector<geometry_msgs::TransformStamped> &TransformTable::stamp(const ros::Time &stamp)
+  {
+    for (size_t i = 0; i < transforms_.size(); ++i)
+    {
+      transforms_[i].header.stamp = stamp;
+    }
+    return transforms_;
+  }
+
+  size_t TransformTable::size() const
+  {
+    return transforms_.size();
+  }
+
+  void TransformTable::add(const std::string &parent_frame_id, const std::string &child_frame_id,
+      const double translation[3], const double rotation[3][3])
+  {
+    geometry_msgs::TransformStamped msg;
+    msg.header.frame_id = parent_frame_id;
+    msg.child_frame_id = child_frame_id;
+    msg.transform.translation.x = translation[0];
+    msg.transform.translation.y = translation[1];
+    msg.transform.translation.z = translation[2];
+    matrixToQuaternion(rotation, msg.transform.rotation.x, msg.transform.rotation.y,
+        msg.transform.rotation.z, msg.transform.rotation.w);
+    transforms_.push_back(msg);
+  }
+}  // namespace realsense_camera
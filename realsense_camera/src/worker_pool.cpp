@@ -0,0 +1,193 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <algorithm>
+
+#include <realsense_camera/worker_pool.h>
+
+namespace realsense_camera
+{
+  struct WorkerPool::Job
+  {
+    const std::function<void(size_t, size_t)> *fn;
+    size_t remaining;  // guarded by the pool mutex
+  };
+
+  WorkerPool::WorkerPool() :
+    running_(false)
+  {
+  }
+
+  WorkerPool::~WorkerPool()
+  {
+    stop();
+  }
+
+  /*
+   * Share one started pool between all nodelets of the process.
+   */
+  std::shared_ptr<WorkerPool> WorkerPool::acquire(unsigned thread_count)
+  {
+    static std::mutex instance_mutex;
+    static std::weak_ptr<WorkerPool> instance;
+
+    std::lock_guard<std::mutex> lock(instance_mutex);
+    std::shared_ptr<WorkerPool> pool = instance.lock();
+    if (!pool)
+    {
+      pool = std::make_shared<WorkerPool>();
+      pool->start(thread_count);
+      instance = pool;
+    }
+    return pool;
+  }
+
+  /*
+   * Start the pool threads.
+   */
+  void WorkerPool::start(unsigned thread_count)
+  {
+    stop();
+    if (thread_count == 0)
+    {
+      thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    running_ = true;
+    // The caller of parallelFor() works as well, so one thread less is needed.
+    for (unsigned i = 1; i < thread_count; ++i)
+    {
+      threads_.push_back(std::thread(&WorkerPool::run, this));
+    }
+  }
+
+  /*
+   * Stop and join the pool threads.
+   */
+  void WorkerPool::stop()
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      running_ = false;
+    }
+    task_cv_.notify_all();
+    for (std::thread &thread : threads_)
+    {
+      thread.join();
+    }
+    threads_.clear();
+  }
+
+  unsigned WorkerPool::getConcurrency() const
+  {
+    return static_cast<unsigned>(threads_.size()) + 1;
+  }
+
+  /*
+   * Run a loop over [0, count) in parallel chunks and wait for all of them.
+   */
+  void WorkerPool::parallelFor(size_t count, size_t min_chunk, const std::function<void(size_t, size_t)> &fn)
+  {
+    if (count == 0)
+    {
+      return;
+    }
+
+    // A few chunks per thread balances uneven rows without much queueing overhead.
+    min_chunk = std::max<size_t>(min_chunk, 1);
+    size_t chunks = std::min<size_t>(getConcurrency() * 4, (count + min_chunk - 1) / min_chunk);
+    if (chunks <= 1)
+    {
+      fn(0, count);
+      return;
+    }
+
+    size_t chunk_size = (count + chunks - 1) / chunks;
+    Job job;
+    job.fn = &fn;
+    job.remaining = (count + chunk_size - 1) / chunk_size;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (size_t begin = 0; begin < count; begin += chunk_size)
+    {
+      Task task = {&job, begin, std::min(begin + chunk_size, count)};
+      tasks_.push_back(task);
+    }
+    task_cv_.notify_all();
+
+    // Help with queued chunks, of this or any other loop, until ours are finished.
+    while (job.remaining > 0)
+    {
+      if (runTask(lock) == false)
+      {
+        done_cv_.wait(lock);
+      }
+    }
+  }
+
+  /*
+   * Thread body.
+   */
+  void WorkerPool::run()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_ || tasks_.empty() == false)
+    {
+      if (runTask(lock) == false)
+      {
+        task_cv_.wait(lock);
+      }
+    }
+  }
+
+  /*
+   * Execute one queued chunk with the lock released. Returns false when the queue is empty.
+   */
+  bool WorkerPool::runTask(std::unique_lock<std::mutex> &lock)
+  {
+    if (tasks_.empty())
+    {
+      return false;
+    }
+    Task task = tasks_.front();
+    tasks_.pop_front();
+
+    lock.unlock();
+    (*task.job->fn)(task.begin, task.end);
+    lock.lock();
+
+    if (--task.job->remaining == 0)
+    {
+      done_cv_.notify_all();
+    }
+    return true;
+  }
+}  // namespace realsense_camera
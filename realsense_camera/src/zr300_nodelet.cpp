@@ -45,6 +45,8 @@ namespace realsense_camera
   {
     if (enable_imu_ == true)
     {
+      imu_running_ = false;
+      imu_ring_.wake();
       stopIMU();
       // clean up imu thread
       imu_thread_->join();
@@ -65,6 +67,8 @@ namespace realsense_camera
 
     if (enable_imu_ == true)
     {
+      loadIMUCalibration();
+      imu_running_ = true;
       imu_thread_ =
           boost::shared_ptr<boost::thread>(new boost::thread(boost::bind(&ZR300Nodelet::publishIMU, this)));
     }
@@ -85,6 +89,68 @@ namespace realsense_camera
     pnh_.param("fisheye_optical_frame_id", optical_frame_id_[RS_STREAM_FISHEYE], DEFAULT_FISHEYE_OPTICAL_FRAME_ID);
     pnh_.param("imu_frame_id", imu_frame_id_, DEFAULT_IMU_FRAME_ID);
     pnh_.param("imu_optical_frame_id", imu_optical_frame_id_, DEFAULT_IMU_OPTICAL_FRAME_ID);
+    pnh_.param("imu_queue_size", imu_queue_size_, IMU_QUEUE_SIZE);
+    pnh_.param("imu_batch_period", imu_batch_period_, IMU_BATCH_PERIOD);
+    std::string imu_interpolation;
+    pnh_.param("imu_interpolation", imu_interpolation, IMU_INTERPOLATION_LINEAR);
+
+    if (imu_queue_size_ < 1)
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - Invalid imu_queue_size " << imu_queue_size_ << "; using "
+          << IMU_QUEUE_SIZE);
+      imu_queue_size_ = IMU_QUEUE_SIZE;
+    }
+    if (imu_batch_period_ <= 0.0)
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - Invalid imu_batch_period " << imu_batch_period_ << "; using "
+          << IMU_BATCH_PERIOD);
+      imu_batch_period_ = IMU_BATCH_PERIOD;
+    }
+    if (imu_interpolation == IMU_INTERPOLATION_CUBIC)
+    {
+      imu_fusion_.configure(MOTION_INTERPOLATION_CUBIC, IMU_FUSION_MAX_GAP_MS);
+    }
+    else
+    {
+      if (imu_interpolation != IMU_INTERPOLATION_LINEAR)
+      {
+        ROS_WARN_STREAM(nodelet_name_ << " - Unknown imu_interpolation '" << imu_interpolation << "'; using "
+            << IMU_INTERPOLATION_LINEAR);
+      }
+      imu_fusion_.configure(MOTION_INTERPOLATION_LINEAR, IMU_FUSION_MAX_GAP_MS);
+    }
+    std::string orientation_filter;
+    pnh_.param("orientation_filter", orientation_filter, ORIENTATION_FILTER_NONE);
+    OrientationFilterType orientation_type = ORIENTATION_FILTER_MADGWICK;
+    enable_orientation_ = true;
+    if (orientation_filter == ORIENTATION_FILTER_MAHONY_NAME)
+    {
+      orientation_type = ORIENTATION_FILTER_MAHONY;
+    }
+    else if (orientation_filter != ORIENTATION_FILTER_MADGWICK_NAME)
+    {
+      if (orientation_filter != ORIENTATION_FILTER_NONE)
+      {
+        ROS_WARN_STREAM(nodelet_name_ << " - Unknown orientation_filter '" << orientation_filter << "'; using "
+            << ORIENTATION_FILTER_NONE);
+      }
+      enable_orientation_ = false;
+    }
+    double orientation_gain;
+    double orientation_integral_gain;
+    pnh_.param("orientation_gain", orientation_gain,
+        (orientation_type == ORIENTATION_FILTER_MAHONY) ? MAHONY_GAIN : MADGWICK_GAIN);
+    pnh_.param("orientation_integral_gain", orientation_integral_gain, MAHONY_INTEGRAL_GAIN);
+    pnh_.param("enable_imu_tf", enable_imu_tf_, ENABLE_IMU_TF);
+    pnh_.param("imu_world_frame_id", imu_world_frame_id_, DEFAULT_IMU_WORLD_FRAME_ID);
+    imu_orientation_.configure(orientation_type, orientation_gain, orientation_integral_gain);
+    if (enable_imu_tf_ && !enable_orientation_)
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - enable_imu_tf needs an orientation_filter; not broadcasting");
+      enable_imu_tf_ = false;
+    }
+    // sized before the motion callbacks are set up with the streams
+    imu_ring_.reset(imu_queue_size_);
   }
 
   /*
@@ -94,10 +160,12 @@ namespace realsense_camera
   {
     ros::NodeHandle fisheye_nh(nh_, FISHEYE_NAMESPACE);
     image_transport::ImageTransport fisheye_image_transport(fisheye_nh);
-    camera_publisher_[RS_STREAM_FISHEYE] = fisheye_image_transport.advertiseCamera(IMAGE_RAW, 1);
+    camera_publisher_[RS_STREAM_FISHEYE] = advertiseCameraTopic(fisheye_image_transport, IMAGE_RAW);
 
     ros::NodeHandle imu_nh(nh_, IMU_NAMESPACE);
     imu_publisher_ = imu_nh.advertise<sensor_msgs::Imu>(DATA_RAW, 1000);
+    imu_batch_publisher_ = imu_nh.advertise<realsense_camera::IMUArray>(DATA_RAW_BATCH, 100);
+    imu_fused_publisher_ = imu_nh.advertise<sensor_msgs::Imu>(DATA_FUSED, 1000);
   }
 
   /*
@@ -197,97 +265,331 @@ namespace realsense_camera
    */
   void ZR300Nodelet::configCallback(realsense_camera::zr300_paramsConfig &config, uint32_t level)
   {
-    // set the depth enable
+    // set the stream profiles, then the depth enable, which restarts the camera once for all of them
+    setStreamProfile(RS_STREAM_DEPTH, config.depth_width, config.depth_height, config.depth_fps);
+    setStreamProfile(RS_STREAM_COLOR, config.rgb_width, config.rgb_height, config.rgb_fps);
+    setStreamProfile(RS_STREAM_FISHEYE, config.fisheye_width, config.fisheye_height, config.fisheye_fps);
     R200Nodelet::setDepthEnable(config.enable_depth);
 
+    // set the depth filters
+    DepthFilterSettings filters;
+    filters.enable_spatial = config.enable_spatial_filter;
+    filters.spatial_alpha = config.spatial_filter_alpha;
+    filters.spatial_delta = config.spatial_filter_delta;
+    filters.spatial_iterations = config.spatial_filter_iterations;
+    filters.enable_temporal = config.enable_temporal_filter;
+    filters.temporal_alpha = config.temporal_filter_alpha;
+    filters.temporal_delta = config.temporal_filter_delta;
+    filters.temporal_persistence = config.temporal_filter_persistence;
+    filters.enable_hole_filling = config.enable_hole_filling;
+    filters.hole_filling_mode = static_cast<HoleFillingMode>(config.hole_filling_mode);
+    R200Nodelet::setDepthFilters(filters);
+
     // Set common options
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_BACKLIGHT_COMPENSATION, config.color_backlight_compensation, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_BRIGHTNESS, config.color_brightness, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_CONTRAST, config.color_contrast, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_EXPOSURE, config.color_exposure, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_GAIN, config.color_gain, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_GAMMA, config.color_gamma, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_HUE, config.color_hue, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_SATURATION, config.color_saturation, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_SHARPNESS, config.color_sharpness, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_ENABLE_AUTO_WHITE_BALANCE,
-        config.color_enable_auto_white_balance, 0);
+    queueCameraOption(RS_OPTION_COLOR_BACKLIGHT_COMPENSATION, config.color_backlight_compensation);
+    queueCameraOption(RS_OPTION_COLOR_BRIGHTNESS, config.color_brightness);
+    queueCameraOption(RS_OPTION_COLOR_CONTRAST, config.color_contrast);
+    queueCameraOption(RS_OPTION_COLOR_EXPOSURE, config.color_exposure);
+    queueCameraOption(RS_OPTION_COLOR_GAIN, config.color_gain);
+    queueCameraOption(RS_OPTION_COLOR_GAMMA, config.color_gamma);
+    queueCameraOption(RS_OPTION_COLOR_HUE, config.color_hue);
+    queueCameraOption(RS_OPTION_COLOR_SATURATION, config.color_saturation);
+    queueCameraOption(RS_OPTION_COLOR_SHARPNESS, config.color_sharpness);
+    queueCameraOption(RS_OPTION_COLOR_ENABLE_AUTO_WHITE_BALANCE, config.color_enable_auto_white_balance);
     if (config.color_enable_auto_white_balance == 0)
     {
-      rs_set_device_option(rs_device_, RS_OPTION_COLOR_WHITE_BALANCE, config.color_white_balance, 0);
+      queueCameraOption(RS_OPTION_COLOR_WHITE_BALANCE, config.color_white_balance);
     }
-    rs_set_device_option(rs_device_, RS_OPTION_COLOR_ENABLE_AUTO_EXPOSURE, config.color_enable_auto_exposure, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_R200_LR_AUTO_EXPOSURE_ENABLED, config.r200_lr_auto_exposure_enabled, 0);
+    queueCameraOption(RS_OPTION_COLOR_ENABLE_AUTO_EXPOSURE, config.color_enable_auto_exposure);
+    queueCameraOption(RS_OPTION_R200_LR_AUTO_EXPOSURE_ENABLED, config.r200_lr_auto_exposure_enabled);
     if (config.r200_lr_auto_exposure_enabled == 0)
     {
-      rs_set_device_option(rs_device_, RS_OPTION_R200_LR_EXPOSURE, config.r200_lr_exposure, 0);
-    }
-    rs_set_device_option(rs_device_, RS_OPTION_R200_LR_GAIN, config.r200_lr_gain, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_R200_EMITTER_ENABLED, config.r200_emitter_enabled, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_R200_DEPTH_CLAMP_MIN, config.r200_depth_clamp_min, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_R200_DEPTH_CLAMP_MAX, config.r200_depth_clamp_max, 0);
-
-    rs_apply_depth_control_preset(rs_device_, config.r200_dc_preset);
-
-    rs_set_device_option(rs_device_, RS_OPTION_FISHEYE_EXPOSURE,
-        config.fisheye_exposure, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_FISHEYE_GAIN, config.fisheye_gain, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_FISHEYE_ENABLE_AUTO_EXPOSURE, config.fisheye_enable_auto_exposure, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_FISHEYE_AUTO_EXPOSURE_MODE, config.fisheye_auto_exposure_mode, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_FISHEYE_AUTO_EXPOSURE_ANTIFLICKER_RATE,
-        config.fisheye_auto_exposure_antiflicker_rate, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_FISHEYE_AUTO_EXPOSURE_PIXEL_SAMPLE_RATE,
-        config.fisheye_auto_exposure_pixel_sample_rate, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_FISHEYE_AUTO_EXPOSURE_SKIP_FRAMES,
-        config.fisheye_auto_exposure_skip_frames, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_FRAMES_QUEUE_SIZE, config.frames_queue_size, 0);
-    rs_set_device_option(rs_device_, RS_OPTION_HARDWARE_LOGGER_ENABLED, config.hardware_logger_enabled, 0);
+      queueCameraOption(RS_OPTION_R200_LR_EXPOSURE, config.r200_lr_exposure);
+    }
+    queueCameraOption(RS_OPTION_R200_LR_GAIN, config.r200_lr_gain);
+    queueCameraOption(RS_OPTION_R200_EMITTER_ENABLED, config.r200_emitter_enabled);
+    queueCameraOption(RS_OPTION_R200_DEPTH_CLAMP_MIN, config.r200_depth_clamp_min);
+    queueCameraOption(RS_OPTION_R200_DEPTH_CLAMP_MAX, config.r200_depth_clamp_max);
+
+    queueCameraOption(RS_OPTION_FISHEYE_EXPOSURE, config.fisheye_exposure);
+    queueCameraOption(RS_OPTION_FISHEYE_GAIN, config.fisheye_gain);
+    queueCameraOption(RS_OPTION_FISHEYE_ENABLE_AUTO_EXPOSURE, config.fisheye_enable_auto_exposure);
+    queueCameraOption(RS_OPTION_FISHEYE_AUTO_EXPOSURE_MODE, config.fisheye_auto_exposure_mode);
+    queueCameraOption(RS_OPTION_FISHEYE_AUTO_EXPOSURE_ANTIFLICKER_RATE, config.fisheye_auto_exposure_antiflicker_rate);
+    queueCameraOption(RS_OPTION_FISHEYE_AUTO_EXPOSURE_PIXEL_SAMPLE_RATE,
+        config.fisheye_auto_exposure_pixel_sample_rate);
+    queueCameraOption(RS_OPTION_FISHEYE_AUTO_EXPOSURE_SKIP_FRAMES, config.fisheye_auto_exposure_skip_frames);
+    queueCameraOption(RS_OPTION_FRAMES_QUEUE_SIZE, config.frames_queue_size);
+    queueCameraOption(RS_OPTION_HARDWARE_LOGGER_ENABLED, config.hardware_logger_enabled);
+
+    applyCameraOptions();
+    applyDepthControlPreset(config.r200_dc_preset);
   }
 
   /*
-   * Publish IMU.
+   * Publish every queued IMU sample, sleeping until the motion callback queues more. Each
+   * sample goes out on its own and in the batch of its period, and the gyro samples are
+   * fused with the accel, to the topics subscribed.
    */
   void ZR300Nodelet::publishIMU()
   {
-    prev_imu_ts_ = -1;
-    while (ros::ok())
+    const ros::Duration batch_period(imu_batch_period_);
+    const std::chrono::duration<double> timeout(std::min(imu_batch_period_, FRAME_WORKER_TIMEOUT_MS * 0.001));
+    realsense_camera::IMUArrayPtr batch;
+    bool fusing = false;
+    IMUSample sample;
+    while (ros::ok() && imu_running_)
     {
-      if (imu_publisher_.getNumSubscribers() > 0)
+      imu_samples_.clear();
+      while (imu_samples_.size() < imu_ring_.capacity() && imu_ring_.pop(sample))
       {
-        std::unique_lock<std::mutex> lock(imu_mutex_);
+        imu_samples_.push_back(sample);
+      }
+      if (imu_samples_.empty())
+      {
+        // Flush a batch whose period has passed even when no later sample closes it.
+        if (batch && ros::Time::now() - batch->header.stamp >= batch_period)
+        {
+          imu_batch_publisher_.publish(batch);
+          imu_batches_++;
+          batch.reset();
+        }
+        imu_ring_.wait(timeout);
+        continue;
+      }
 
-        if (prev_imu_ts_ != imu_ts_)
+      bool publish_sample = (imu_publisher_.getNumSubscribers() > 0);
+      bool publish_batch = (imu_batch_publisher_.getNumSubscribers() > 0);
+      bool publish_fused = (imu_fused_publisher_.getNumSubscribers() > 0);
+      // the orientation TF needs the fused samples even without subscribers
+      bool fuse = publish_fused || (enable_orientation_ && enable_imu_tf_);
+      if (publish_batch == false)
+      {
+        batch.reset();
+      }
+      if (fuse != fusing)
+      {
+        // do not interpolate or integrate across the samples skipped without subscribers
+        imu_fusion_.reset();
+        imu_orientation_.reset();
+        fusing = fuse;
+      }
+      if (publish_sample == false && publish_batch == false && fuse == false)
+      {
+        continue;
+      }
+
+      for (IMUSample &queued : imu_samples_)
+      {
+        queued.stamp = toHostTime(motion_clock_model_, queued.timestamp);
+        if (publish_batch)
+        {
+          if (batch && queued.stamp - batch->header.stamp >= batch_period)
+          {
+            imu_batch_publisher_.publish(batch);
+            imu_batches_++;
+            batch.reset();
+          }
+          addIMUBatchSample(batch, queued, queued.stamp);
+        }
+        if (publish_sample)
         {
-          sensor_msgs::Imu imu_msg = sensor_msgs::Imu();
-          imu_msg.header.stamp = ros::Time(camera_start_ts_) + ros::Duration(imu_ts_ * 0.001);
-          imu_msg.header.frame_id = imu_optical_frame_id_;
+          publishIMUSample(queued);
+        }
+      }
+      if (fuse)
+      {
+        publishFusedIMU(imu_samples_, publish_fused);
+      }
+      imu_published_ += imu_samples_.size();
+    }
+    stopIMU();
+  }
+
+  /*
+   * Publish a raw sample on its own. A sample carries either the gyro or the accel axes; the
+   * other field is marked unknown.
+   */
+  void ZR300Nodelet::publishIMUSample(const IMUSample &sample)
+  {
+    sensor_msgs::Imu imu_msg = sensor_msgs::Imu();
+    imu_msg.header.stamp = sample.stamp;
+    imu_msg.header.frame_id = imu_optical_frame_id_;
+
+    imu_msg.orientation.x = 0.0;
+    imu_msg.orientation.y = 0.0;
+    imu_msg.orientation.z = 0.0;
+    imu_msg.orientation.w = 0.0;
+    imu_msg.orientation_covariance = {-1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+
+    if (sample.source == RS_EVENT_IMU_GYRO)
+    {
+      imu_msg.angular_velocity.x = sample.axes[0];
+      imu_msg.angular_velocity.y = sample.axes[1];
+      imu_msg.angular_velocity.z = sample.axes[2];
+      imu_msg.linear_acceleration_covariance[0] = -1.0;
+    }
+    else
+    {
+      imu_msg.linear_acceleration.x = sample.axes[0];
+      imu_msg.linear_acceleration.y = sample.axes[1];
+      imu_msg.linear_acceleration.z = sample.axes[2];
+      imu_msg.angular_velocity_covariance[0] = -1.0;
+    }
+
+    imu_publisher_.publish(imu_msg);
+  }
+
+  /*
+   * Calibrate the gyro and accel samples of a drained batch, interpolate the accel onto
+   * the gyro timestamps and publish one complete message per gyro sample. The orientation
+   * filter, when enabled, runs on every fused sample and its latest estimate is broadcast
+   * once per batch when the IMU TF is enabled.
+   */
+  void ZR300Nodelet::publishFusedIMU(const std::vector<IMUSample> &samples, bool publish)
+  {
+    gyro_samples_.clear();
+    accel_samples_.clear();
+    for (const IMUSample &sample : samples)
+    {
+      std::vector<MotionSample> &motion = (sample.source == RS_EVENT_IMU_GYRO) ? gyro_samples_ : accel_samples_;
+      motion.push_back(MotionSample());
+      motion.back().timestamp = sample.timestamp;
+      std::copy(sample.axes, sample.axes + 3, motion.back().axes);
+    }
+    calibrateMotionSamples(imu_intrinsics_.gyro.data, gyro_samples_.data(), gyro_samples_.size());
+    calibrateMotionSamples(imu_intrinsics_.acc.data, accel_samples_.data(), accel_samples_.size());
+
+    // Feed the fusion in arrival order so that no gyro sample waits on a later accel batch.
+    fused_samples_.clear();
+    size_t gyro = 0;
+    size_t accel = 0;
+    for (const IMUSample &sample : samples)
+    {
+      if (sample.source == RS_EVENT_IMU_GYRO)
+      {
+        imu_fusion_.addGyro(&gyro_samples_[gyro++], 1, fused_samples_);
+      }
+      else
+      {
+        imu_fusion_.addAccel(&accel_samples_[accel++], 1, fused_samples_);
+      }
+    }
+    imu_fusion_dropped_ = imu_fusion_.getDropped();
 
-          imu_msg.orientation.x = 0.0;
-          imu_msg.orientation.y = 0.0;
-          imu_msg.orientation.z = 0.0;
-          imu_msg.orientation.w = 0.0;
-          imu_msg.orientation_covariance = {-1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    for (const FusedMotionSample &fused : fused_samples_)
+    {
+      if (enable_orientation_)
+      {
+        imu_orientation_.update(fused.angular_velocity, fused.linear_acceleration, fused.timestamp);
+      }
+      if (publish == false)
+      {
+        continue;
+      }
 
-          imu_msg.angular_velocity.x = imu_angular_vel_[0];
-          imu_msg.angular_velocity.y = imu_angular_vel_[1];
-          imu_msg.angular_velocity.z = imu_angular_vel_[2];
+      sensor_msgs::Imu imu_msg = sensor_msgs::Imu();
+      imu_msg.header.stamp = toHostTime(motion_clock_model_, fused.timestamp);
+      imu_msg.header.frame_id = imu_optical_frame_id_;
+      if (enable_orientation_ && imu_orientation_.isInitialized())
+      {
+        imu_orientation_.getOrientation(imu_msg.orientation.x, imu_msg.orientation.y, imu_msg.orientation.z,
+            imu_msg.orientation.w);
+      }
+      else
+      {
+        imu_msg.orientation_covariance[0] = -1.0;
+      }
+
+      imu_msg.angular_velocity.x = fused.angular_velocity[0];
+      imu_msg.angular_velocity.y = fused.angular_velocity[1];
+      imu_msg.angular_velocity.z = fused.angular_velocity[2];
+      imu_msg.linear_acceleration.x = fused.linear_acceleration[0];
+      imu_msg.linear_acceleration.y = fused.linear_acceleration[1];
+      imu_msg.linear_acceleration.z = fused.linear_acceleration[2];
+      for (int i = 0; i < 3; ++i)
+      {
+        imu_msg.angular_velocity_covariance[i * 4] = imu_intrinsics_.gyro.noise_variances[i];
+        imu_msg.linear_acceleration_covariance[i * 4] = imu_intrinsics_.acc.noise_variances[i];
+      }
 
-          imu_msg.linear_acceleration.x = imu_linear_accel_[0];
-          imu_msg.linear_acceleration.y = imu_linear_accel_[1];
-          imu_msg.linear_acceleration.z = imu_linear_accel_[2];
+      imu_fused_publisher_.publish(imu_msg);
+      imu_fused_++;
+    }
 
-          for (int i = 0; i < 9; ++i)
+    if (enable_imu_tf_ && !fused_samples_.empty() && imu_orientation_.isInitialized())
+    {
+      // The world frame hangs below the IMU so that the IMU keeps its parent in the camera tree.
+      double x, y, z, w;
+      imu_orientation_.getOrientation(x, y, z, w);
+      tf::Transform tr;
+      tr.setOrigin(tf::Vector3(0, 0, 0));
+      tr.setRotation(tf::Quaternion(-x, -y, -z, w));  // inverse of the unit quaternion
+      dynamic_tf_broadcaster_.sendTransform(tf::StampedTransform(tr,
+          toHostTime(motion_clock_model_, fused_samples_.back().timestamp), imu_optical_frame_id_,
+          imu_world_frame_id_));
+    }
+  }
+
+  /*
+   * Read the motion module calibration, or use an identity calibration when the device has none.
+   */
+  void ZR300Nodelet::loadIMUCalibration()
+  {
+    rs_get_motion_intrinsics(rs_device_, &imu_intrinsics_, &rs_error_);
+    bool calibrated = (rs_error_ == NULL);
+    if (rs_error_)
+    {
+      rs_free_error(rs_error_);
+      rs_error_ = NULL;
+    }
+    rs_motion_device_intrinsic *devices[] = {&imu_intrinsics_.acc, &imu_intrinsics_.gyro};
+    for (rs_motion_device_intrinsic *device : devices)
+    {
+      bool has_scale = false;
+      for (int i = 0; i < 3; ++i)
+      {
+        for (int j = 0; j < 3; ++j)
+        {
+          has_scale = has_scale || (device->data[i][j] != 0.0f);
+        }
+      }
+      calibrated = calibrated && has_scale;
+    }
+    if (calibrated == false)
+    {
+      ROS_WARN_STREAM(nodelet_name_ << " - No IMU calibration, fused IMU samples are uncalibrated");
+      for (rs_motion_device_intrinsic *device : devices)
+      {
+        for (int i = 0; i < 3; ++i)
+        {
+          for (int j = 0; j < 4; ++j)
           {
-            imu_msg.angular_velocity_covariance[i] = imu_angular_vel_cov_[i];
-            imu_msg.linear_acceleration_covariance[i] = imu_linear_accel_cov_[i];
+            device->data[i][j] = (i == j) ? 1.0f : 0.0f;
           }
-
-          imu_publisher_.publish(imu_msg);
-          prev_imu_ts_ = imu_ts_;
+          device->noise_variances[i] = 0.0f;
+          device->bias_variances[i] = 0.0f;
         }
       }
     }
-    stopIMU();
+  }
+
+  /*
+   * Append a sample to the batch, starting a new batch stamped with it when there is none.
+   */
+  void ZR300Nodelet::addIMUBatchSample(realsense_camera::IMUArrayPtr &batch, const IMUSample &sample,
+      const ros::Time &stamp)
+  {
+    if (!batch)
+    {
+      batch = boost::make_shared<realsense_camera::IMUArray>();
+      batch->header.stamp = stamp;
+      batch->header.frame_id = imu_optical_frame_id_;
+    }
+    batch->sources.push_back((sample.source == RS_EVENT_IMU_GYRO) ? realsense_camera::IMUArray::SOURCE_GYRO :
+        realsense_camera::IMUArray::SOURCE_ACCEL);
+    batch->time_offsets.push_back((stamp - batch->header.stamp).toSec());
+    batch->axes.insert(batch->axes.end(), sample.axes, sample.axes + 3);
   }
 
   /*
@@ -310,6 +612,14 @@ namespace realsense_camera
     }
   }
 
+  /*
+   * Motion tracking needs a running device, so keep a video stream on with lazy streams. -- overrides base class
+   */
+  bool ZR300Nodelet::requiresStreaming()
+  {
+    return enable_imu_;
+  }
+
   /*
    * Set IMU callbacks.
    */
@@ -317,31 +627,39 @@ namespace realsense_camera
   {
     motion_handler_ = [&](rs::motion_data entry)  // NOLINT(build/c++11)
     {
-      std::unique_lock<std::mutex> lock(imu_mutex_);
+      if (entry.timestamp_data.source_id != RS_EVENT_IMU_GYRO && entry.timestamp_data.source_id != RS_EVENT_IMU_ACCEL)
+      {
+        return;
+      }
+      if (enable_clock_sync_)
+      {
+        // The motion module has its own clock.
+        ros::Time arrival = ros::Time::now();
+        std::unique_lock<std::mutex> lock(clock_mutex_);
+        motion_clock_model_.addSample(static_cast<double>(entry.timestamp_data.timestamp), arrival.toSec());
+      }
+
+      IMUSample sample;
+      sample.source = entry.timestamp_data.source_id;
+      sample.timestamp = static_cast<double>(entry.timestamp_data.timestamp);
+      std::copy(entry.axes, entry.axes + 3, sample.axes);
 
-      if (entry.timestamp_data.source_id == RS_EVENT_IMU_GYRO)
+      imu_received_++;
+      if (imu_ring_.push(std::move(sample)) == false)
       {
-        for (int i = 0; i < 3; ++i)
+        // Keep the newest samples: discard the oldest one the publisher has not taken yet.
+        IMUSample oldest;
+        if (imu_ring_.pop(oldest))
         {
-          imu_angular_vel_[i] = entry.axes[i];
-          imu_linear_accel_[i] = 0.0;
+          imu_overwritten_++;
         }
-        imu_angular_vel_cov_[0] = 0.0;
-        imu_linear_accel_cov_[0] = -1.0;
-      }
-      else if (entry.timestamp_data.source_id == RS_EVENT_IMU_ACCEL)
-      {
-        for (int i = 0; i < 3; ++i)
+        if (imu_ring_.push(std::move(sample)) == false)
         {
-          imu_angular_vel_[i] = 0.0;
-          imu_linear_accel_[i] = entry.axes[i];
+          imu_overwritten_++;
         }
-        imu_angular_vel_cov_[0] = -1.0;
-        imu_linear_accel_cov_[0] = 0.0;
       }
-      imu_ts_ = static_cast<double>(entry.timestamp_data.timestamp);
 
-      ROS_DEBUG_STREAM(" - Motion,\t host time " << imu_ts_
+      ROS_DEBUG_STREAM(" - Motion,\t host time " << entry.timestamp_data.timestamp
           << "\ttimestamp: " << std::setprecision(8) << (double)entry.timestamp_data.timestamp*IMU_UNITS_TO_MSEC
           << "\tsource: " << (rs::event)entry.timestamp_data.source_id
           << "\tframe_num: " << entry.timestamp_data.frame_number
@@ -373,7 +691,7 @@ namespace realsense_camera
 
     fisheye_frame_handler_ = [&](rs::frame frame)  // NOLINT(build/c++11)
     {
-      publishStreamTopic(RS_STREAM_FISHEYE, frame);
+      queueFrame(RS_STREAM_FISHEYE, frame);
     };
 
     rs_set_frame_callback_cpp(rs_device_, RS_STREAM_FISHEYE,
@@ -381,6 +699,74 @@ namespace realsense_camera
     checkError();
   }
 
+  /*
+   * The fisheye frames are stamped by the motion module, like the IMU samples, rather than by the
+   * camera clock of the other streams. -- overrides base class
+   */
+  DeviceClockModel &ZR300Nodelet::getClockModel(rs_stream stream_index)
+  {
+    if (stream_index == RS_STREAM_FISHEYE)
+    {
+      return motion_clock_model_;
+    }
+    return R200Nodelet::getClockModel(stream_index);
+  }
+
+  /*
+   * Restart the clock models of the streams and of the motion module. -- overrides base class
+   */
+  void ZR300Nodelet::resetClockModels()
+  {
+    R200Nodelet::resetClockModels();
+    std::unique_lock<std::mutex> lock(clock_mutex_);
+    motion_clock_model_.configure(clock_sync_window_, clock_sync_outlier_ms_);
+  }
+
+  /*
+   * Report the motion module clock along with the streams. -- overrides base class
+   */
+  void ZR300Nodelet::diagnoseClockSync(diagnostic_updater::DiagnosticStatusWrapper &stat)
+  {
+    R200Nodelet::diagnoseClockSync(stat);
+    if (enable_clock_sync_ && (enable_imu_ || enable_[RS_STREAM_FISHEYE]))
+    {
+      addClockStatistics(stat, "Motion module", motion_clock_model_, reported_motion_clock_resets_);
+    }
+  }
+
+  /*
+   * Add the IMU sample counters to the diagnostics. -- overrides base class
+   */
+  void ZR300Nodelet::setupDiagnostics()
+  {
+    R200Nodelet::setupDiagnostics();
+    if (enable_imu_ == true)
+    {
+      diagnostic_updater_->add("IMU Samples", this, &ZR300Nodelet::diagnoseIMU);
+    }
+  }
+
+  /*
+   * Report the received, published and overwritten IMU samples, warning on new overwrites.
+   */
+  void ZR300Nodelet::diagnoseIMU(diagnostic_updater::DiagnosticStatusWrapper &stat)
+  {
+    uint64_t overwritten = imu_overwritten_;
+    stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "IMU samples");
+    stat.add("Received", imu_received_.load());
+    stat.add("Published", imu_published_.load());
+    stat.add("Batches", imu_batches_.load());
+    stat.add("Fused", imu_fused_.load());
+    stat.add("Fusion dropped", imu_fusion_dropped_.load());
+    stat.add("Overwritten", overwritten);
+    stat.add("Queued", imu_ring_.size());
+    if (overwritten > reported_imu_overwritten_)
+    {
+      stat.mergeSummary(diagnostic_msgs::DiagnosticStatus::WARN, "IMU samples overwritten");
+    }
+    reported_imu_overwritten_ = overwritten;
+  }
+
   /*
    * Get the camera extrinsics
    */
@@ -396,8 +782,10 @@ namespace realsense_camera
     }
     checkError();
 
-    // Get offset between base frame and imu frame
-    rs_get_motion_extrinsics_from(rs_device_, RS_STREAM_COLOR, &color2imu_extrinsic_, &rs_error_);
+    // Get offset between base frame and imu frame. The motion extrinsics map color points into the
+    // IMU frame, the inverse of the other sensor extrinsics.
+    rs_extrinsics color2imu_extrinsic;
+    rs_get_motion_extrinsics_from(rs_device_, RS_STREAM_COLOR, &color2imu_extrinsic, &rs_error_);
     if (rs_error_)
     {
 /*  Temporarily hardcoding the values until fully supported by librealsense API.  */
@@ -406,126 +794,27 @@ namespace realsense_camera
       rs_free_error(rs_error_);
       rs_error_ = NULL;
 
-      color2imu_extrinsic_.translation[0] = -0.07;
-      color2imu_extrinsic_.translation[1] = 0.0;
-      color2imu_extrinsic_.translation[2] = 0.0;
+      imu2color_extrinsic_.translation[0] = -0.07;
+      imu2color_extrinsic_.translation[1] = 0.0;
+      imu2color_extrinsic_.translation[2] = 0.0;
+      std::copy(ROTATION_IDENTITY, ROTATION_IDENTITY + 9, imu2color_extrinsic_.rotation);
+    }
+    else
+    {
+      imu2color_extrinsic_ = invertExtrinsic(color2imu_extrinsic);
     }
     // checkError();
   }
 
   /*
-   * Publish Static transforms.
+   * Build the transform table from the extrinsics and frame ids.
    */
-  void ZR300Nodelet::publishStaticTransforms()
+  void ZR300Nodelet::buildTransformTable()
   {
-    R200Nodelet::publishStaticTransforms();
-
-    tf::Quaternion q_i2io;
-    tf::Quaternion q_f2fo;
-    tf::Quaternion q_imu2imuo;
-    geometry_msgs::TransformStamped b2i_msg;
-    geometry_msgs::TransformStamped i2io_msg;
-    geometry_msgs::TransformStamped b2f_msg;
-    geometry_msgs::TransformStamped f2fo_msg;
-    geometry_msgs::TransformStamped b2imu_msg;
-    geometry_msgs::TransformStamped imu2imuo_msg;
-
-    // Transform base frame to fisheye frame
-    b2f_msg.header.stamp = transform_ts_;
-    b2f_msg.header.frame_id = base_frame_id_;
-    b2f_msg.child_frame_id = frame_id_[RS_STREAM_FISHEYE];
-    b2f_msg.transform.translation.x =  color2fisheye_extrinsic_.translation[2];
-    b2f_msg.transform.translation.y = -color2fisheye_extrinsic_.translation[0];
-    b2f_msg.transform.translation.z = -color2fisheye_extrinsic_.translation[1];
-    b2f_msg.transform.rotation.x = 0;
-    b2f_msg.transform.rotation.y = 0;
-    b2f_msg.transform.rotation.z = 0;
-    b2f_msg.transform.rotation.w = 1;
-    static_tf_broadcaster_.sendTransform(b2f_msg);
-
-    // Transform fisheye frame to fisheye optical frame
-    q_f2fo.setRPY(-M_PI/2, 0.0, -M_PI/2);
-    f2fo_msg.header.stamp = transform_ts_;
-    f2fo_msg.header.frame_id = frame_id_[RS_STREAM_FISHEYE];
-    f2fo_msg.child_frame_id = optical_frame_id_[RS_STREAM_FISHEYE];
-    f2fo_msg.transform.translation.x = 0;
-    f2fo_msg.transform.translation.y = 0;
-    f2fo_msg.transform.translation.z = 0;
-    f2fo_msg.transform.rotation.x = q_f2fo.getX();
-    f2fo_msg.transform.rotation.y = q_f2fo.getY();
-    f2fo_msg.transform.rotation.z = q_f2fo.getZ();
-    f2fo_msg.transform.rotation.w = q_f2fo.getW();
-    static_tf_broadcaster_.sendTransform(f2fo_msg);
-
-    // Transform base frame to imu frame
-    b2imu_msg.header.stamp = transform_ts_;
-    b2imu_msg.header.frame_id = base_frame_id_;
-    b2imu_msg.child_frame_id = imu_frame_id_;
-    b2imu_msg.transform.translation.x =  color2imu_extrinsic_.translation[2];
-    b2imu_msg.transform.translation.y = -color2imu_extrinsic_.translation[0];
-    b2imu_msg.transform.translation.z = -color2imu_extrinsic_.translation[1];
-    b2imu_msg.transform.rotation.x = 0;
-    b2imu_msg.transform.rotation.y = 0;
-    b2imu_msg.transform.rotation.z = 0;
-    b2imu_msg.transform.rotation.w = 1;
-    static_tf_broadcaster_.sendTransform(b2imu_msg);
-
-    // Transform imu frame to imu optical frame
-    q_imu2imuo.setRPY(-M_PI/2, 0.0, -M_PI/2);
-    imu2imuo_msg.header.stamp = transform_ts_;
-    imu2imuo_msg.header.frame_id = imu_frame_id_;
-    imu2imuo_msg.child_frame_id = imu_optical_frame_id_;
-    imu2imuo_msg.transform.translation.x = 0;
-    imu2imuo_msg.transform.translation.y = 0;
-    imu2imuo_msg.transform.translation.z = 0;
-    imu2imuo_msg.transform.rotation.x = q_imu2imuo.getX();
-    imu2imuo_msg.transform.rotation.y = q_imu2imuo.getY();
-    imu2imuo_msg.transform.rotation.z = q_imu2imuo.getZ();
-    imu2imuo_msg.transform.rotation.w = q_imu2imuo.getW();
-    static_tf_broadcaster_.sendTransform(imu2imuo_msg);
-  }
+    R200Nodelet::buildTransformTable();
 
-  /*
-   * Publish Dynamic transforms.
-   */
-  void ZR300Nodelet::publishDynamicTransforms()
-  {
-    tf::Transform tr;
-    tf::Quaternion q;
-
-    R200Nodelet::publishDynamicTransforms();
-
-    // Transform base frame to fisheye frame
-    tr.setOrigin(tf::Vector3(
-           color2fisheye_extrinsic_.translation[2],
-          -color2fisheye_extrinsic_.translation[0],
-          -color2fisheye_extrinsic_.translation[1]));
-    tr.setRotation(tf::Quaternion(0, 0, 0, 1));
-    dynamic_tf_broadcaster_.sendTransform(tf::StampedTransform(tr, transform_ts_,
-          base_frame_id_, frame_id_[RS_STREAM_FISHEYE]));
-
-    // Transform fisheye frame to fisheye optical frame
-    tr.setOrigin(tf::Vector3(0, 0, 0));
-    q.setRPY(-M_PI/2, 0.0, -M_PI/2);
-    tr.setRotation(q);
-    dynamic_tf_broadcaster_.sendTransform(tf::StampedTransform(tr, transform_ts_,
-          frame_id_[RS_STREAM_FISHEYE], optical_frame_id_[RS_STREAM_FISHEYE]));
-
-    // Transform base frame to imu frame
-    tr.setOrigin(tf::Vector3(
-           color2imu_extrinsic_.translation[2],
-          -color2imu_extrinsic_.translation[0],
-          -color2imu_extrinsic_.translation[1]));
-    tr.setRotation(tf::Quaternion(0, 0, 0, 1));
-    dynamic_tf_broadcaster_.sendTransform(tf::StampedTransform(tr, transform_ts_,
-          base_frame_id_, imu_frame_id_));
-
-    // Transform imu frame to imu optical frame
-    tr.setOrigin(tf::Vector3(0, 0, 0));
-    q.setRPY(-M_PI/2, 0.0, -M_PI/2);
-    tr.setRotation(q);
-    dynamic_tf_broadcaster_.sendTransform(tf::StampedTransform(tr, transform_ts_,
-          imu_frame_id_, imu_optical_frame_id_));
+    addSensorTransforms(frame_id_[RS_STREAM_FISHEYE], optical_frame_id_[RS_STREAM_FISHEYE], color2fisheye_extrinsic_);
+    addSensorTransforms(imu_frame_id_, imu_optical_frame_id_, imu2color_extrinsic_);
   }
 
   /*
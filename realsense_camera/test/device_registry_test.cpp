@@ -0,0 +1,221 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <realsense_camera/device_registry.h>
+
+// Fake librealsense 1.x: one reference-counted context per process, listing the devices
+// plugged in when queried. Device handles stay valid while the device is plugged in.
+namespace
+{
+  struct FakeDevice
+  {
+    std::string serial_no;
+    std::string name;
+  };
+  std::vector<FakeDevice> plugged;
+  char handles[8];  // rs_device pointers are addresses in here, by serial number
+  std::vector<std::string> handle_serials;
+  int context_references = 0;
+  int created_contexts = 0;
+  char context;
+
+  rs_device *handle(const std::string &serial_no)
+  {
+    std::vector<std::string>::iterator known = std::find(handle_serials.begin(), handle_serials.end(), serial_no);
+    if (known == handle_serials.end())
+    {
+      known = handle_serials.insert(handle_serials.end(), serial_no);
+    }
+    return reinterpret_cast<rs_device *>(handles + (known - handle_serials.begin()));
+  }
+
+  const FakeDevice &fake(const rs_device *device)
+  {
+    const std::string &serial_no = handle_serials[reinterpret_cast<const char *>(device) - handles];
+    for (const FakeDevice &entry : plugged)
+    {
+      if (entry.serial_no == serial_no)
+      {
+        return entry;
+      }
+    }
+    static FakeDevice none;
+    return none;
+  }
+}  // namespace
+
+rs_context *rs_create_context(int, rs_error **)
+{
+  if (context_references++ == 0)
+  {
+    created_contexts++;
+  }
+  return reinterpret_cast<rs_context *>(&context);
+}
+void rs_delete_context(rs_context *, rs_error **)
+{
+  context_references--;
+}
+int rs_get_device_count(const rs_context *, rs_error **)
+{
+  return plugged.size();
+}
+rs_device *rs_get_device(rs_context *, int index, rs_error **)
+{
+  return handle(plugged[index].serial_no);
+}
+const char *rs_get_device_serial(const rs_device *device, rs_error **)
+{
+  return fake(device).serial_no.c_str();
+}
+const char *rs_get_device_usb_port_id(const rs_device *, rs_error **)
+{
+  return "1-1";
+}
+const char *rs_get_device_name(const rs_device *device, rs_error **)
+{
+  return fake(device).name.c_str();
+}
+const char *rs_get_device_firmware_version(const rs_device *, rs_error **)
+{
+  return "1.0.72.06";
+}
+int rs_supports(rs_device *, rs_capabilities, rs_error **)
+{
+  return 0;
+}
+const char *rs_get_device_info(const rs_device *, rs_camera_info, rs_error **)
+{
+  return "";
+}
+void rs_free_error(rs_error *)
+{
+}
+
+namespace realsense_camera
+{
+class DeviceRegistryTest : public ::testing::Test
+{
+protected:
+  void SetUp()
+  {
+    plugged = {{"A", "Intel RealSense R200"}};
+    created_contexts = 0;
+    pool_.start(2);
+  }
+
+  WorkerPool pool_;
+};
+
+TEST_F(DeviceRegistryTest, SharesOneEnumeration)
+{
+  std::shared_ptr<DeviceRegistry> first = DeviceRegistry::acquire();
+  std::shared_ptr<DeviceRegistry> second = DeviceRegistry::acquire();
+  ASSERT_EQ(first, second);
+
+  uint64_t first_generation = 0, second_generation = 0;
+  rs_error *error = NULL;
+  EXPECT_TRUE(first->scan(pool_, first_generation, &error));
+  EXPECT_FALSE(second->scan(pool_, second_generation, &error));
+  EXPECT_EQ(first_generation, second_generation);
+  EXPECT_EQ(1, created_contexts);
+  ASSERT_EQ(1u, second->getDevices().size());
+  EXPECT_EQ("A", second->getDevices()[0].serial_no);
+}
+
+TEST_F(DeviceRegistryTest, RescansWithAnAssignedDevice)
+{
+  std::shared_ptr<DeviceRegistry> registry = DeviceRegistry::acquire();
+  uint64_t generation = 0;
+  rs_error *error = NULL;
+  ASSERT_TRUE(registry->scan(pool_, generation, &error));
+  std::string assigned_to;
+  rs_device *device_a = registry->assign("camera1", "R200", "A", "", assigned_to);
+  ASSERT_TRUE(device_a != NULL);
+
+  // A second camera is plugged in after the first nodelet connected.
+  plugged.push_back({"B", "Intel RealSense R200"});
+  EXPECT_TRUE(registry->scan(pool_, generation, &error));
+  EXPECT_TRUE(error == NULL);
+  EXPECT_EQ(1, created_contexts);  // listed again through the same context
+
+  std::vector<DeviceRegistry::Device> devices = registry->getDevices();
+  ASSERT_EQ(2u, devices.size());
+  EXPECT_EQ("A", devices[0].serial_no);
+  EXPECT_EQ("camera1", devices[0].owner);
+  EXPECT_EQ(device_a, devices[0].device);
+  EXPECT_EQ("B", devices[1].serial_no);
+  EXPECT_TRUE(devices[1].owner.empty());
+
+  rs_device *device_b = registry->assign("camera2", "R200", "B", "", assigned_to);
+  ASSERT_TRUE(device_b != NULL);
+  EXPECT_NE(device_a, device_b);
+  EXPECT_EQ(NULL, registry->assign("camera3", "R200", "A", "", assigned_to));
+  EXPECT_EQ("camera1", assigned_to);
+
+  // The context lives until the last nodelet drops the registry.
+  registry->release(device_a);
+  registry->release(device_b);
+  EXPECT_EQ(1, context_references);
+  registry.reset();
+  EXPECT_EQ(0, context_references);
+}
+
+TEST_F(DeviceRegistryTest, KeepsAnAssignedDeviceThatIsUnplugged)
+{
+  std::shared_ptr<DeviceRegistry> registry = DeviceRegistry::acquire();
+  uint64_t generation = 0;
+  rs_error *error = NULL;
+  ASSERT_TRUE(registry->scan(pool_, generation, &error));
+  std::string assigned_to;
+  rs_device *device_a = registry->assign("camera1", "R200", "A", "", assigned_to);
+  ASSERT_TRUE(device_a != NULL);
+
+  plugged = {{"B", "Intel RealSense R200"}};
+  EXPECT_TRUE(registry->scan(pool_, generation, &error));
+  std::vector<DeviceRegistry::Device> devices = registry->getDevices();
+  ASSERT_EQ(2u, devices.size());
+  EXPECT_EQ("B", devices[0].serial_no);
+  EXPECT_EQ(device_a, devices[1].device);
+  EXPECT_EQ("camera1", devices[1].owner);
+}
+}  // namespace realsense_camera
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,112 @@
+/******************************************************************************
+ Copyright (c) 2017, Intel Corporation
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ 1. Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ 2. Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ 3. Neither the name of the copyright holder nor the names of its contributors
+ may be used to endorse or promote products derived from this software without
+ specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *******************************************************************************/
+
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <realsense_camera/transform_table.h>
+
+namespace realsense_camera
+{
+namespace
+{
+  const double TOLERANCE = 1e-6;  // extrinsics are single precision
+  const double HALF_SQRT2 = std::sqrt(0.5);
+
+  /*
+   * A color to IMU extrinsic as rs_get_motion_extrinsics_from reports it: the IMU is turned
+   * 90 degrees about the optical axis and points move by (0.01, 0.02, 0.03) m into it.
+   */
+  rs_extrinsics knownColorToImu()
+  {
+    // Column-major rotation R = [[0, -1, 0], [1, 0, 0], [0, 0, 1]]
+    rs_extrinsics extrinsic = {{0, 1, 0, -1, 0, 0, 0, 0, 1}, {0.01, 0.02, 0.03}};
+    return extrinsic;
+  }
+}  // namespace
+
+TEST(TransformTableTest, InvertsExtrinsic)
+{
+  rs_extrinsics color2imu = knownColorToImu();
+  rs_extrinsics imu2color = invertExtrinsic(color2imu);
+
+  // Mapping a point into the IMU and back returns it.
+  const double point[3] = {0.5, -0.25, 2.0};
+  double imu[3];
+  double color[3];
+  for (int r = 0; r < 3; ++r)
+  {
+    imu[r] = color2imu.translation[r];
+    for (int c = 0; c < 3; ++c)
+    {
+      imu[r] += color2imu.rotation[c * 3 + r] * point[c];
+    }
+  }
+  for (int r = 0; r < 3; ++r)
+  {
+    color[r] = imu2color.translation[r];
+    for (int c = 0; c < 3; ++c)
+    {
+      color[r] += imu2color.rotation[c * 3 + r] * imu[c];
+    }
+    EXPECT_NEAR(point[r], color[r], TOLERANCE);
+  }
+}
+
+TEST(TransformTableTest, PublishesImuPoseInBaseFrame)
+{
+  TransformTable table;
+  ASSERT_TRUE(table.addExtrinsic("base", "imu", invertExtrinsic(knownColorToImu())));
+  const std::vector<geometry_msgs::TransformStamped> &transforms = table.stamp(ros::Time());
+  ASSERT_EQ(1u, transforms.size());
+  const geometry_msgs::TransformStamped &imu = transforms[0];
+  EXPECT_EQ("base", imu.header.frame_id);
+  EXPECT_EQ("imu", imu.child_frame_id);
+
+  // The IMU origin is -R^T t = (-0.02, 0.01, -0.03) in optical axes, (-0.03, 0.02, -0.01) in body axes.
+  EXPECT_NEAR(-0.03, imu.transform.translation.x, TOLERANCE);
+  EXPECT_NEAR(0.02, imu.transform.translation.y, TOLERANCE);
+  EXPECT_NEAR(-0.01, imu.transform.translation.z, TOLERANCE);
+
+  // R^T turns -90 degrees about the optical z axis, which is the body x axis.
+  EXPECT_NEAR(-HALF_SQRT2, imu.transform.rotation.x, TOLERANCE);
+  EXPECT_NEAR(0.0, imu.transform.rotation.y, TOLERANCE);
+  EXPECT_NEAR(0.0, imu.transform.rotation.z, TOLERANCE);
+  EXPECT_NEAR(HALF_SQRT2, imu.transform.rotation.w, TOLERANCE);
+}
+}  // namespace realsense_camera
+
+int main(int argc, char **argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}